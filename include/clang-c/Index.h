@@ -32,7 +32,7 @@
  * compatible, thus CINDEX_VERSION_MAJOR is expected to remain stable.
  */
 #define CINDEX_VERSION_MAJOR 0
-#define CINDEX_VERSION_MINOR 39
+#define CINDEX_VERSION_MINOR 41
 
 #define CINDEX_VERSION_ENCODE(major, minor) ( \
       ((major) * 10000)                       \
@@ -1234,7 +1234,37 @@ enum CXTranslationUnit_Flags {
    * purposes of an IDE, this is undesirable behavior and as much information
    * as possible should be reported. Use this flag to enable this behavior.
    */
-  CXTranslationUnit_KeepGoing = 0x200
+  CXTranslationUnit_KeepGoing = 0x200,
+
+  /**
+   * \brief Rebuild the precompiled preamble on a background thread.
+   *
+   * When the precompiled preamble is out of date, \c
+   * clang_reparseTranslationUnit() does not wait for it to be rebuilt. If only
+   * the headers included by the preamble have changed, reparsing continues to
+   * use the previous preamble; otherwise, it parses without a preamble. The
+   * new preamble is used once it is ready. This reduces the latency of
+   * reparsing at the expense of briefly seeing stale header contents.
+   *
+   * This option has an effect only together with
+   * \c CXTranslationUnit_PrecompiledPreamble, and only when libclang was built
+   * with thread support.
+   */
+  CXTranslationUnit_BackgroundPreamble = 0x400,
+
+  /**
+   * \brief Precompile the preamble as a chain of precompiled headers, split
+   * after its top-level inclusions.
+   *
+   * When an inclusion in the preamble, or a header it includes, changes, only
+   * the part of the preamble from that inclusion onwards is precompiled
+   * again by \c clang_reparseTranslationUnit().
+   *
+   * This option has an effect only together with
+   * \c CXTranslationUnit_PrecompiledPreamble, and none while the preamble is
+   * rebuilt on a background thread.
+   */
+  CXTranslationUnit_ChainedPreamble = 0x800
 };
 
 /**
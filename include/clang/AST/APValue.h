@@ -84,9 +84,23 @@ private:
     ~Vec() { delete[] Elts; }
   };
   struct Arr {
-    APValue *Elts;
+    /// The initialized elements, followed by the filler if there is one.
+    /// If the array is packed, these are held as the bit patterns of their
+    /// values instead.
+    union {
+      APValue *Elts;
+      uint64_t *Words;
+    };
     unsigned NumElts, ArrSize;
+    /// For a packed array, the semantics of its floating-point elements (or
+    /// null if they are integers), their width in bits, and for integers,
+    /// their signedness.
+    const llvm::fltSemantics *PackedSemantics;
+    unsigned PackedBitWidth;
+    bool PackedIsUnsigned;
+    bool IsPacked;
     Arr(unsigned NumElts, unsigned ArrSize);
+    Arr(const Arr &Packed);
     ~Arr();
   };
   struct StructData {
@@ -273,10 +287,17 @@ public:
   APValue &getArrayInitializedElt(unsigned I) {
     assert(isArray() && "Invalid accessor");
     assert(I < getArrayInitializedElts() && "Index out of range");
+    if (isPackedArray())
+      unpackArray();
     return ((Arr*)(char*)Data.buffer)->Elts[I];
   }
+  /// Reading an element through a const APValue never unpacks the array;
+  /// use getPackedArrayElt to read an element of a packed array.
   const APValue &getArrayInitializedElt(unsigned I) const {
-    return const_cast<APValue*>(this)->getArrayInitializedElt(I);
+    assert(isArray() && "Invalid accessor");
+    assert(I < getArrayInitializedElts() && "Index out of range");
+    assert(!isPackedArray() && "Use getPackedArrayElt for a packed array");
+    return ((const Arr*)(const void *)Data.buffer)->Elts[I];
   }
   bool hasArrayFiller() const {
     return getArrayInitializedElts() != getArraySize();
@@ -284,10 +305,16 @@ public:
   APValue &getArrayFiller() {
     assert(isArray() && "Invalid accessor");
     assert(hasArrayFiller() && "No array filler");
+    if (isPackedArray())
+      unpackArray();
     return ((Arr*)(char*)Data.buffer)->Elts[getArrayInitializedElts()];
   }
   const APValue &getArrayFiller() const {
-    return const_cast<APValue*>(this)->getArrayFiller();
+    assert(isArray() && "Invalid accessor");
+    assert(hasArrayFiller() && "No array filler");
+    assert(!isPackedArray() && "Use getPackedArrayElt for a packed array");
+    return ((const Arr*)(const void *)Data.buffer)
+        ->Elts[getArrayInitializedElts()];
   }
   unsigned getArrayInitializedElts() const {
     assert(isArray() && "Invalid accessor");
@@ -298,6 +325,35 @@ public:
     return ((const Arr*)(const void *)Data.buffer)->ArrSize;
   }
 
+  /// \brief Whether this is an array whose elements are all integers, or all
+  /// floating-point numbers, of the same type, held packed in one buffer
+  /// rather than as an APValue each.
+  ///
+  /// Getting a modifiable reference to an element of a packed array unpacks
+  /// it, and a const one can't be had; use getPackedArrayElt and
+  /// setPackedArrayElt instead.
+  bool isPackedArray() const {
+    return isArray() && ((const Arr*)(const void *)Data.buffer)->IsPacked;
+  }
+
+  /// \brief Get the value of element \p I of a packed array, which is the
+  /// filler if \p I is at least getArrayInitializedElts().
+  APValue getPackedArrayElt(unsigned I) const;
+
+  /// \brief Set element \p I of a packed array, giving it an initialized
+  /// element if it was represented by the filler.
+  ///
+  /// \returns false, leaving the array unchanged, if \p Value isn't of the
+  /// same type as the other elements.
+  bool setPackedArrayElt(unsigned I, const APValue &Value);
+
+  /// \brief Pack the elements of this array, if they are all integers, or all
+  /// floating-point numbers, of the same type of at most 64 bits. This
+  /// invalidates any references to the elements.
+  ///
+  /// \returns whether the array is packed.
+  bool packArray();
+
   unsigned getStructNumBases() const {
     assert(isStruct() && "Invalid accessor");
     return ((const StructData*)(const char*)Data.buffer)->NumBases;
@@ -430,6 +486,7 @@ private:
   }
   void MakeLValue();
   void MakeArray(unsigned InitElts, unsigned Size);
+  void unpackArray();
   void MakeStruct(unsigned B, unsigned M) {
     assert(isUninit() && "Bad state change");
     new ((void*)(char*)Data.buffer) StructData(B, M);
@@ -65,6 +65,7 @@
 #include <cstdint>
 #include <iterator>
 #include <memory>
+#include <mutex>
 #include <new>
 #include <string>
 #include <type_traits>
@@ -84,6 +85,7 @@ class ASTRecordLayout;
 class AtomicExpr;
 class BlockExpr;
 class CharUnits;
+class ConstexprCallCache;
 class CXXABI;
 class DiagnosticsEngine;
 class Expr;
@@ -227,6 +229,10 @@ class ASTContext : public RefCountedBase<ASTContext> {
   llvm::DenseMap<const MaterializeTemporaryExpr *, APValue *>
     MaterializedTemporaryValues;
 
+  /// \brief The results of constexpr function calls that can be reused by
+  /// later calls with the same arguments, created on first use.
+  mutable std::unique_ptr<ConstexprCallCache> ConstexprCalls;
+
   /// \brief Representation of a "canonical" template template parameter that
   /// is used in canonical template names.
   class CanonicalTemplateTemplateParm : public llvm::FoldingSetNode {
@@ -487,6 +493,33 @@ private:
   /// AST objects will be released when the ASTContext itself is destroyed.
   mutable llvm::BumpPtrAllocator BumpAlloc;
 
+  /// \brief Guards BumpAlloc when the AST may be built from several threads
+  /// (LangOptions::ThreadSafeASTContext).
+  mutable std::mutex AllocateMutex;
+
+  /// \brief Guards the type-uniquing tables, and the list of types, when the
+  /// AST may be built from several threads. Creating a type can create
+  /// others, such as its canonical type, so the lock is recursive.
+  mutable std::recursive_mutex TypeUniquingMutex;
+
+  /// \brief Holds the lock on the type-uniquing tables for its lifetime, if
+  /// the AST may be built from several threads.
+  class TypeUniquingLock {
+    std::recursive_mutex *Mutex;
+
+  public:
+    explicit TypeUniquingLock(const ASTContext &Ctx)
+        : Mutex(Ctx.LangOpts.ThreadSafeASTContext ? &Ctx.TypeUniquingMutex
+                                                  : nullptr) {
+      if (Mutex)
+        Mutex->lock();
+    }
+    ~TypeUniquingLock() {
+      if (Mutex)
+        Mutex->unlock();
+    }
+  };
+
   /// \brief Allocator for partial diagnostics.
   PartialDiagnostic::StorageAllocator DiagAllocator;
 
@@ -622,6 +655,10 @@ public:
   }
 
   void *Allocate(size_t Size, unsigned Align = 8) const {
+    if (LLVM_UNLIKELY(LangOpts.ThreadSafeASTContext)) {
+      std::lock_guard<std::mutex> Lock(AllocateMutex);
+      return BumpAlloc.Allocate(Size, Align);
+    }
     return BumpAlloc.Allocate(Size, Align);
   }
   template <typename T> T *Allocate(size_t Num = 1) const {
@@ -1032,6 +1069,17 @@ public:
   void PrintStats() const;
   const SmallVectorImpl<Type *>& getTypes() const { return Types; }
 
+  /// \brief Write a JSON report of the memory used by the AST to \p OS
+  /// (-fast-memory-report).
+  ///
+  /// The report breaks down the declarations, statements and types of each
+  /// kind, type source information, declaration context lookup tables,
+  /// comments and the source manager. Declarations and statements are only
+  /// counted while Decl and Stmt statistics are enabled, and those counts are
+  /// process-wide: they include the nodes of every AST built in the process
+  /// since, such as those of modules built implicitly along the way.
+  void printMemoryReport(raw_ostream &OS) const;
+
   BuiltinTemplateDecl *buildBuiltinTemplateDecl(BuiltinTemplateKind BTK,
                                                 const IdentifierInfo *II) const;
 
@@ -2557,6 +2605,9 @@ public:
   APValue *getMaterializedTemporaryValue(const MaterializeTemporaryExpr *E,
                                          bool MayCreate);
 
+  /// \brief Get the remembered results of constexpr function calls.
+  ConstexprCallCache &getConstexprCallCache() const;
+
   //===--------------------------------------------------------------------===//
   //                    Statistics
   //===--------------------------------------------------------------------===//
@@ -2680,6 +2731,20 @@ private:
   // but we include it here so that ASTContext can quickly deallocate them.
   llvm::PointerIntPair<StoredDeclsMap*,1> LastSDM;
 
+  /// \brief Trivial type source information that can be shared by every
+  /// request for the same type and location, keyed by the type and the raw
+  /// encoding of the location.
+  mutable llvm::DenseMap<std::pair<QualType, unsigned>, TypeSourceInfo *>
+      SharedTrivialTypeSourceInfos;
+
+  /// \brief The number of TypeSourceInfos created, and the bytes they use.
+  mutable unsigned NumTypeSourceInfos;
+  mutable size_t TypeSourceInfoBytes;
+
+  /// \brief The number of requests for trivial type source information that
+  /// were satisfied by sharing an existing TypeSourceInfo.
+  mutable unsigned NumSharedTypeSourceInfoUses;
+
   friend class DeclContext;
   friend class DeclarationNameTable;
 
@@ -29,6 +29,7 @@ namespace clang {
   class DeclContext;
   class DiagnosticsEngine;
   class Expr;
+  class FileEntry;
   class FileManager;
   class IdentifierInfo;
   class NestedNameSpecifier;
@@ -42,6 +43,7 @@ namespace clang {
     typedef llvm::DenseSet<std::pair<Decl *, Decl *> > NonEquivalentDeclSet;
     typedef llvm::DenseMap<const CXXBaseSpecifier *, CXXBaseSpecifier *>
     ImportedCXXBaseSpecifierMap;
+    typedef llvm::DenseMap<const FileEntry *, FileID> ImportedFileMap;
 
   private:
     /// \brief The contexts we're importing to and from.
@@ -84,6 +86,14 @@ namespace clang {
     /// \brief Declaration (from, to) pairs that are known not to be equivalent
     /// (which we have already complained about).
     NonEquivalentDeclSet NonEquivalentDecls;
+
+    /// \brief Canonical declaration (from, to) pairs that are known to be
+    /// structurally equivalent.
+    NonEquivalentDeclSet EquivalentDecls;
+
+    /// \brief If non-null, the FileIDs that any importer into the "to"
+    /// context has created for files, keyed by the "to" file entry.
+    ImportedFileMap *SharedImportedFiles;
     
   public:
     /// \brief Create a new AST importer.
@@ -286,6 +296,21 @@ namespace clang {
     /// \brief Return the set of declarations that we know are not equivalent.
     NonEquivalentDeclSet &getNonEquivalentDecls() { return NonEquivalentDecls; }
 
+    /// \brief Return the set of declarations that we know are equivalent.
+    NonEquivalentDeclSet &getEquivalentDecls() { return EquivalentDecls; }
+
+    /// \brief Share the FileIDs created for files with other importers into
+    /// the same "to" context.
+    ///
+    /// When a file has already been imported, its existing FileID is reused
+    /// instead of creating a new one, so that the "to" source manager grows
+    /// with the number of distinct files rather than with the number of
+    /// imported ASTs. Locations in such a file keep the include location of
+    /// the AST it was first imported from.
+    void setSharedImportedFiles(ImportedFileMap *Files) {
+      SharedImportedFiles = Files;
+    }
+
     /// \brief Called for ObjCInterfaceDecl, ObjCProtocolDecl, and TagDecl.
     /// Mark the Decl as complete, filling it in as much as possible.
     ///
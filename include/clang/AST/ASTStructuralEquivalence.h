@@ -46,6 +46,14 @@ struct StructuralEquivalenceContext {
   /// (which we have already complained about).
   llvm::DenseSet<std::pair<Decl *, Decl *>> &NonEquivalentDecls;
 
+  /// Canonical declaration (from, to) pairs that are known to be
+  /// equivalent, or null if equivalences are not remembered across checks.
+  ///
+  /// Only pairs whose equivalence was fully verified against complete
+  /// definitions are recorded, and only when we are not being strict about
+  /// type spelling.
+  llvm::DenseSet<std::pair<Decl *, Decl *>> *EquivalentDecls;
+
   /// Whether we're being strict about the spelling of types when
   /// unifying two types.
   bool StrictTypeSpelling;
@@ -59,13 +67,26 @@ struct StructuralEquivalenceContext {
   /// \c true if the last diagnostic came from ToCtx.
   bool LastDiagFromC2;
 
+  /// \c true if some check in this context found a non-equivalence, in which
+  /// case the remaining tentative equivalences may not hold.
+  bool FoundNonEquivalence;
+
+  /// \c true if some check in this context took a record or enum to be
+  /// equivalent to another while either of them had no definition. That no
+  /// longer holds once the definition is seen, so nothing verified in this
+  /// context can be remembered.
+  bool AssumedIncompleteEquivalence;
+
   StructuralEquivalenceContext(
       ASTContext &FromCtx, ASTContext &ToCtx,
       llvm::DenseSet<std::pair<Decl *, Decl *>> &NonEquivalentDecls,
-      bool StrictTypeSpelling = false, bool Complain = true)
+      bool StrictTypeSpelling = false, bool Complain = true,
+      llvm::DenseSet<std::pair<Decl *, Decl *>> *EquivalentDecls = nullptr)
       : FromCtx(FromCtx), ToCtx(ToCtx), NonEquivalentDecls(NonEquivalentDecls),
+        EquivalentDecls(EquivalentDecls),
         StrictTypeSpelling(StrictTypeSpelling), Complain(Complain),
-        LastDiagFromC2(false) {}
+        LastDiagFromC2(false), FoundNonEquivalence(false),
+        AssumedIncompleteEquivalence(false) {}
 
   DiagnosticBuilder Diag1(SourceLocation Loc, unsigned DiagID);
   DiagnosticBuilder Diag2(SourceLocation Loc, unsigned DiagID);
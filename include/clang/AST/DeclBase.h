@@ -19,6 +19,7 @@
 #include "clang/Basic/Specifiers.h"
 #include "clang/Basic/VersionTuple.h"
 #include "llvm/ADT/PointerUnion.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/iterator.h"
 #include "llvm/ADT/iterator_range.h"
 #include "llvm/Support/Compiler.h"
@@ -950,6 +951,13 @@ public:
   static void EnableStatistics();
   static void PrintStats();
 
+  /// \brief Call \p Callback with the name, the number created and the size
+  /// of each kind of declaration. Declarations are only counted while
+  /// statistics are enabled.
+  static void getStatistics(
+      llvm::function_ref<void(StringRef Kind, unsigned Count, size_t Size)>
+          Callback);
+
   /// isTemplateParameter - Determines whether this declaration is a
   /// template parameter.
   bool isTemplateParameter() const;
@@ -1897,6 +1905,7 @@ private:
   StoredDeclsMap *CreateStoredDeclsMap(ASTContext &C) const;
 
   void buildLookupImpl(DeclContext *DCtx, bool Internal);
+  void buildLookupImpl(DeclContext *DCtx, decl_range Decls, bool Internal);
   void makeDeclVisibleInContextWithFlags(NamedDecl *D, bool Internal,
                                          bool Rediscoverable);
   void makeDeclVisibleInContextImpl(NamedDecl *D, bool Internal);
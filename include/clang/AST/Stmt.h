@@ -22,6 +22,7 @@
 #include "clang/Basic/SourceLocation.h"
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/PointerIntPair.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/iterator.h"
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/ErrorHandling.h"
@@ -375,6 +376,13 @@ public:
   static void EnableStatistics();
   static void PrintStats();
 
+  /// \brief Call \p Callback with the name, the number created and the size
+  /// of each class of statement. Statements are only counted while
+  /// statistics are enabled.
+  static void getStatistics(
+      llvm::function_ref<void(StringRef Class, unsigned Count, size_t Size)>
+          Callback);
+
   /// \brief Dumps the specified AST fragment and all subtrees to
   /// \c llvm::errs().
   void dump() const;
@@ -17,6 +17,9 @@
 #define LLVM_CLANG_BASIC_BUILTINS_H
 
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
 #include <cstring>
 
 // VC++ defines 'alloca' as an object-like macro, which interferes with our
@@ -66,6 +69,18 @@ class Context {
   llvm::ArrayRef<Info> TSRecords;
   llvm::ArrayRef<Info> AuxTSRecords;
 
+  /// \brief Maps from each name to the indices of the records with that name,
+  /// in order, for the target-independent, target and auxiliary target
+  /// builtins. These are built once per process and shared by every Context;
+  /// see initializeBuiltins().
+  typedef llvm::StringMap<llvm::SmallVector<unsigned, 1>> NameIndex;
+  const NameIndex *BuiltinIndex = nullptr;
+  const NameIndex *TSIndex = nullptr;
+  const NameIndex *AuxTSIndex = nullptr;
+
+  /// \brief The language options passed to initializeBuiltins().
+  const LangOptions *LangOpts = nullptr;
+
 public:
   Context() {}
 
@@ -76,8 +91,30 @@ public:
   /// \brief Mark the identifiers for all the builtins with their
   /// appropriate builtin ID # and mark any non-portable builtin identifiers as
   /// such.
+  ///
+  /// Identifiers already in \p Table are marked immediately; the rest are
+  /// marked by \p Table as they are created, so a translation unit only pays
+  /// for the builtin names it actually mentions.
   void initializeBuiltins(IdentifierTable &Table, const LangOptions& LangOpts);
 
+  /// \brief Mark identifiers that \p Table creates from now on with their
+  /// builtin ID #, leaving existing identifiers alone.
+  ///
+  /// This is used when an external AST source has already provided the
+  /// builtin IDs of the identifiers it knows about.
+  void initializeLazyBuiltins(IdentifierTable &Table,
+                              const LangOptions &LangOpts);
+
+  /// \brief Return the builtin ID that initializeBuiltins() assigns to an
+  /// identifier named \p Name, or 0 if it does not name a supported builtin.
+  unsigned lookupBuiltin(llvm::StringRef Name) const;
+
+  /// \brief Invoke \p Fn with the name of each builtin supported in the
+  /// language options passed to initializeBuiltins(), whether or not an
+  /// identifier has been created for it yet.
+  void forEachSupportedBuiltinName(
+      llvm::function_ref<void(llvm::StringRef)> Fn) const;
+
   /// \brief Return the identifier name for the specified builtin,
   /// e.g. "__builtin_abs".
   const char *getName(unsigned ID) const {
@@ -214,7 +251,7 @@ private:
 
   /// \brief Is this builtin supported according to the given language options?
   bool builtinIsSupported(const Builtin::Info &BuiltinInfo,
-                          const LangOptions &LangOpts);
+                          const LangOptions &LangOpts) const;
 
   /// \brief Helper function for isPrintfLike and isScanfLike.
   bool isLike(unsigned ID, unsigned &FormatIdx, bool &HasVAListArg,
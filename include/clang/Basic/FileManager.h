@@ -235,9 +235,16 @@ public:
 
   /// \brief Open the specified file as a MemoryBuffer, returning a new
   /// MemoryBuffer if successful, otherwise returning null.
+  ///
+  /// Clients that never scan for a terminating null (e.g., readers of
+  /// bitstream files) should pass \p RequiresNullTerminator = false. Files
+  /// too small to be worth mapping are still read into memory, but larger
+  /// ones can then be mapped even when their size is a multiple of the page
+  /// size, which otherwise forces them to be read.
   llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>
   getBufferForFile(const FileEntry *Entry, bool isVolatile = false,
-                   bool ShouldCloseOpenFile = true);
+                   bool ShouldCloseOpenFile = true,
+                   bool RequiresNullTerminator = true);
   llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>
   getBufferForFile(StringRef Filename);
 
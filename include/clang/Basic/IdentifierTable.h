@@ -42,6 +42,7 @@ namespace clang {
   class IdentifierInfo;
   class IdentifierTable;
   class SourceLocation;
+  namespace Builtin { class Context; }
   class MultiKeywordSelector; // private class used by Selector
   class DeclarationName;      // AST class that stores declaration names
 
@@ -475,6 +476,14 @@ class IdentifierTable {
 
   IdentifierInfoLookup* ExternalLookup;
 
+  /// \brief The builtins whose IDs are assigned to identifiers as they are
+  /// created, rather than up front, if any.
+  const Builtin::Context *LazyBuiltins = nullptr;
+
+  /// \brief Give a newly-created identifier its builtin ID, if it names a
+  /// builtin registered with setLazyBuiltins().
+  void initializeLazyBuiltin(IdentifierInfo &II);
+
 public:
   /// \brief Create the identifier table, populating it with info about the
   /// language keywords for the language specified by \p LangOpts.
@@ -490,6 +499,15 @@ public:
   IdentifierInfoLookup *getExternalIdentifierLookup() const {
     return ExternalLookup;
   }
+
+  /// \brief Assign builtin IDs from \p Builtins to identifiers as they are
+  /// created. See Builtin::Context::initializeBuiltins().
+  void setLazyBuiltins(const Builtin::Context *Builtins) {
+    LazyBuiltins = Builtins;
+  }
+
+  /// \brief Retrieve the builtins registered with setLazyBuiltins(), if any.
+  const Builtin::Context *getLazyBuiltins() const { return LazyBuiltins; }
   
   llvm::BumpPtrAllocator& getAllocator() {
     return HashTable.getAllocator();
@@ -518,6 +536,9 @@ public:
     // contents.
     II->Entry = &Entry;
 
+    if (LazyBuiltins)
+      initializeLazyBuiltin(*II);
+
     return *II;
   }
 
@@ -549,6 +570,9 @@ public:
     // contents.
     II->Entry = &Entry;
 
+    if (LazyBuiltins)
+      initializeLazyBuiltin(*II);
+
     // If this is the 'import' contextual keyword, mark it as such.
     if (Name.equals("import"))
       II->setModulesImport(true);
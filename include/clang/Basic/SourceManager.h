@@ -648,6 +648,35 @@ class SourceManager : public RefCountedBase<SourceManager> {
   /// is very common to look up many tokens from the same file.
   mutable FileID LastFileIDLookup;
 
+  /// \brief A small round-robin cache of FileIDs recently found by
+  /// getFileIDSlow.
+  ///
+  /// Unlike LastFileIDLookup, this also remembers macro expansions and
+  /// keeps a few entries, so that clients alternating between several files
+  /// or expansions (diagnostics, indexers) avoid searching the SLocEntry
+  /// tables.
+  enum { FileIDLookupCacheSize = 4 };
+  mutable FileID FileIDLookupCache[FileIDLookupCacheSize];
+  mutable unsigned NextFileIDLookupCacheSlot;
+
+  /// \brief An entry of LocalSLocOffsetIndex.
+  struct IndexedSLocOffset {
+    unsigned Offset;
+    unsigned Index;
+  };
+
+  /// \brief The offsets of a prefix of LocalSLocEntryTable laid out in
+  /// Eytzinger (breadth-first) order, which replaces the binary search in
+  /// getFileIDLocal with a cache-friendly one.
+  ///
+  /// Element 0 is unused.  The index is rebuilt whenever the local table has
+  /// doubled in size since it was last built; entries past the indexed prefix
+  /// are found with the ordinary search.
+  mutable std::vector<IndexedSLocOffset> LocalSLocOffsetIndex;
+
+  /// \brief The number of local SLocEntries covered by LocalSLocOffsetIndex.
+  mutable unsigned NumIndexedLocalSLocEntries;
+
   /// \brief Holds information for \#line directives.
   ///
   /// This is referenced by indices from SLocEntryTable.
@@ -668,6 +697,12 @@ class SourceManager : public RefCountedBase<SourceManager> {
 
   // Statistics for -print-stats.
   mutable unsigned NumLinearScans, NumBinaryProbes;
+  mutable unsigned NumFileIDCacheHits, NumIndexedLookups;
+
+  /// \brief The number of local macro expansion and macro argument expansion
+  /// SLocEntries created, and the SLoc address space each kind consumes.
+  unsigned NumMacroExpansionEntries, NumMacroArgExpansionEntries;
+  unsigned MacroExpansionSLocBytes, MacroArgExpansionSLocBytes;
 
   /// \brief Associates a FileID with its "included/expanded in" decomposed
   /// location.
@@ -1671,6 +1706,15 @@ private:
   FileID getFileIDLocal(unsigned SLocOffset) const;
   FileID getFileIDLoaded(unsigned SLocOffset) const;
 
+  /// \brief Look up the local FileID containing \p SLocOffset in
+  /// LocalSLocOffsetIndex, building the index if it is stale.
+  ///
+  /// \returns an invalid FileID if the offset lies past the indexed prefix.
+  FileID getFileIDLocalIndexed(unsigned SLocOffset) const;
+  void buildLocalSLocOffsetIndex() const;
+
+  void clearFileIDLookupCaches();
+
   SourceLocation getExpansionLocSlowCase(SourceLocation Loc) const;
   SourceLocation getSpellingLocSlowCase(SourceLocation Loc) const;
   SourceLocation getFileLocSlowCase(SourceLocation Loc) const;
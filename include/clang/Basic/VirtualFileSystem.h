@@ -17,6 +17,7 @@
 #include "llvm/ADT/IntrusiveRefCntPtr.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/Twine.h"
 #include "llvm/Support/Chrono.h"
@@ -25,10 +26,12 @@
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstdint>
 #include <ctime>
 #include <memory>
+#include <mutex>
 #include <stack>
 #include <string>
 #include <system_error>
@@ -405,6 +408,112 @@ public:
   void write(llvm::raw_ostream &OS);
 };
 
+/// \brief Gets a \p FileSystem serving the files packed into \p Buffer by
+/// \p ArchiveVFSWriter, or null if \p Buffer is not a valid archive.
+///
+/// The returned file system is read-only. File contents are handed out as
+/// buffers that point directly into \p Buffer, so mapping one archive
+/// replaces opening and reading each of the files it contains.
+IntrusiveRefCntPtr<FileSystem>
+getVFSFromArchive(std::unique_ptr<llvm::MemoryBuffer> Buffer);
+
+/// \brief Returns true if \p Buffer starts like an archive written by
+/// \p ArchiveVFSWriter.
+bool isVFSArchive(StringRef Buffer);
+
+/// \brief Packs a set of files into a single archive for
+/// \p getVFSFromArchive.
+///
+/// The archive consists of a header, a table of file and directory entries
+/// sorted by path, a string table of paths, and the page-aligned,
+/// null-terminated contents of each file.
+class ArchiveVFSWriter {
+  struct ArchiveFile {
+    std::string VPath;
+    std::unique_ptr<llvm::MemoryBuffer> Buffer;
+    llvm::sys::TimePoint<> MTime;
+  };
+  std::vector<ArchiveFile> Files;
+
+public:
+  ArchiveVFSWriter();
+  ~ArchiveVFSWriter();
+
+  /// \brief Add the file at absolute path \p VirtualPath with the contents of
+  /// \p Buffer. Parent directories are added implicitly.
+  void addFile(StringRef VirtualPath, std::unique_ptr<llvm::MemoryBuffer> Buffer,
+               llvm::sys::TimePoint<> MTime = llvm::sys::TimePoint<>());
+
+  /// \brief Write the archive to \p OS.
+  void write(llvm::raw_ostream &OS);
+};
+
+/// \brief A thread-safe cache of the status and contents of files, shared by
+/// file systems used on different threads.
+///
+/// FileManager is not thread-safe, so in-process parallel tools give each
+/// thread its own FileManager on top of a file system returned by
+/// createCachingFileSystem(). Those file systems all consult one cache, so a
+/// header seen by any thread is stat'ed and read only once. Entries are spread
+/// over independently locked shards to keep contention low, and file contents
+/// are shared by reference count between every buffer handed out for them.
+///
+/// The cache assumes that files do not change while it is alive.
+class SharedFileSystemCache
+    : public llvm::ThreadSafeRefCountedBase<SharedFileSystemCache> {
+  struct Entry {
+    bool HasStatus = false;
+    std::error_code StatusError;
+    Status S;
+    std::shared_ptr<llvm::MemoryBuffer> Buffer;
+  };
+
+  struct Shard {
+    std::mutex Mutex;
+    llvm::StringMap<Entry> Entries;
+  };
+
+  enum { NumShards = 32 };
+
+  IntrusiveRefCntPtr<FileSystem> FS;
+  Shard Shards[NumShards];
+
+  std::atomic<unsigned> NumStatLookups, NumStatMisses;
+  std::atomic<unsigned> NumBufferLookups, NumBufferMisses;
+
+  Shard &getShard(StringRef Path);
+
+public:
+  /// \param FS The file system to cache. It is only ever given absolute
+  /// paths, and must be safe to use from several threads at once.
+  explicit SharedFileSystemCache(IntrusiveRefCntPtr<FileSystem> FS);
+  ~SharedFileSystemCache();
+
+  /// \brief Get the status of the entry at the absolute path \p Path.
+  llvm::ErrorOr<Status> status(StringRef Path);
+
+  /// \brief Get the contents of the file at the absolute path \p Path,
+  /// reading it only if no thread has done so yet.
+  llvm::ErrorOr<std::shared_ptr<llvm::MemoryBuffer>> getBuffer(StringRef Path);
+
+  /// \brief Get the file system being cached.
+  FileSystem &getUnderlyingFS() const { return *FS; }
+
+  /// \brief Print some statistics to stderr that indicate how well the cache
+  /// is doing.
+  void PrintStats() const;
+};
+
+/// \brief Gets a \p FileSystem that serves status and file contents through
+/// \p Cache.
+///
+/// Each returned file system has its own working directory, starting at
+/// \p WorkingDirectory, and resolves relative paths against it rather than
+/// against the process's working directory. Give each thread its own.
+IntrusiveRefCntPtr<FileSystem>
+createCachingFileSystem(IntrusiveRefCntPtr<SharedFileSystemCache> Cache,
+                        StringRef WorkingDirectory);
+
 } // end namespace vfs
 } // end namespace clang
 
@@ -38,6 +38,7 @@
 
 namespace llvm {
   class MemoryBuffer;
+  class ThreadPool;
 }
 
 namespace clang {
@@ -232,12 +233,19 @@ public:
     /// buffers it is zero.
     time_t ModTime;
 
-    /// Memory buffers have MD5 instead of modification time.  We don't
-    /// compute MD5 for on-disk files because we hope that modification time is
-    /// enough to tell if the file was changed.
+    /// Memory buffers have MD5 instead of modification time.  On-disk files
+    /// have the MD5 of the contents the preamble was built from, when known,
+    /// so that a file whose modification time changed but whose contents did
+    /// not (e.g., because it was saved without changes, or restored by a
+    /// version control system) doesn't invalidate the preamble.  It is only
+    /// consulted once the size and modification time fail to match.
     llvm::MD5::MD5Result MD5;
 
-    static PreambleFileHash createForFile(off_t Size, time_t ModTime);
+    /// \brief Create the hash of an on-disk file, given its contents if they
+    /// are available.
+    static PreambleFileHash
+    createForFile(off_t Size, time_t ModTime,
+                  const llvm::MemoryBuffer *Buffer = nullptr);
     static PreambleFileHash
     createForMemoryBuffer(const llvm::MemoryBuffer *Buffer);
 
@@ -265,7 +273,8 @@ private:
   /// preamble, with both their buffer size and their modification time.
   ///
   /// If any of the files have changed from one compile to the next,
-  /// the preamble must be thrown away.
+  /// the preamble must be thrown away. A file whose modification time
+  /// changed is only considered changed if its contents did, too.
   llvm::StringMap<PreambleFileHash> FilesInPreamble;
 
   /// \brief When non-NULL, this is the buffer used to store the contents of
@@ -289,6 +298,56 @@ private:
   /// \brief A list of the serialization ID numbers for each of the top-level
   /// declarations parsed within the precompiled preamble.
   std::vector<serialization::DeclID> TopLevelDeclsInPreamble;
+
+  /// \brief The number of precompiled preambles built so far.
+  unsigned PreambleCounter;
+
+  /// \brief Whether out-of-date preambles are rebuilt on a background thread
+  /// rather than when reparsing.
+  bool BuildPreambleInBackground;
+
+  /// \brief A precompiled preamble being built on a background thread.
+  struct BackgroundPreambleBuild;
+
+  /// \brief The preamble currently being built in the background, if any.
+  std::unique_ptr<BackgroundPreambleBuild> PendingPreamble;
+
+  /// \brief The thread on which preambles are built in the background.
+  std::unique_ptr<llvm::ThreadPool> PreambleThread;
+
+  /// \brief A part of a chained precompiled preamble, which covers the main
+  /// file up to the end of one of its top-level inclusions.
+  struct PreambleSegment {
+    /// \brief The offset in the main file at which the segment ends.
+    unsigned End;
+
+    /// \brief Whether the segment ends at the start of a new line.
+    bool EndsAtStartOfLine;
+
+    /// \brief The file the segment is precompiled to, chained to the file of
+    /// the previous segment.
+    std::string PCHPath;
+
+    /// \brief The files used when precompiling the segment, including those
+    /// used by the previous segments.
+    llvm::StringMap<PreambleFileHash> Files;
+
+    std::vector<serialization::DeclID> TopLevelDecls;
+    SmallVector<StandaloneDiagnostic, 4> Diagnostics;
+    unsigned NumWarnings;
+    unsigned TopLevelHashValue;
+  };
+
+  /// \brief Whether the preamble is precompiled as a chain of PCH files, one
+  /// per group of top-level inclusions, rather than as a single one.
+  bool ChainPreambleAtIncludes;
+
+  /// \brief The segments the current preamble was precompiled in, when it is
+  /// chained. The last one is precompiled to \c PreambleFile.
+  std::vector<PreambleSegment> PreambleSegments;
+
+  /// \brief The number of preamble segments precompiled so far.
+  unsigned PreambleSegmentCounter;
   
   /// \brief Whether we should be caching code-completion results.
   bool ShouldCacheCodeCompletionResults : 1;
@@ -440,6 +499,15 @@ private:
       std::shared_ptr<PCHContainerOperations> PCHContainerOps,
       const CompilerInvocation &PreambleInvocationIn, bool AllowRebuild = true,
       unsigned MaxLines = 0);
+  std::unique_ptr<llvm::MemoryBuffer> getMainBufferWithChainedPreamble(
+      std::shared_ptr<PCHContainerOperations> PCHContainerOps,
+      const CompilerInvocation &PreambleInvocationIn,
+      const ComputedPreamble &NewPreamble, bool AllowRebuild);
+  void startBackgroundPreambleBuild(
+      std::shared_ptr<PCHContainerOperations> PCHContainerOps,
+      const CompilerInvocation &PreambleInvocationIn,
+      const ComputedPreamble &NewPreamble);
+  void adoptBackgroundPreamble();
   void RealizeTopLevelDeclsFromPreamble();
 
   /// \brief Transfers ownership of the objects (like SourceManager) from
@@ -531,9 +599,49 @@ public:
 
   bool getOnlyLocalDecls() const { return OnlyLocalDecls; }
 
+  unsigned getPreambleCounterForTests() const { return PreambleCounter; }
+  unsigned getPreambleSegmentCounterForTests() const {
+    return PreambleSegmentCounter;
+  }
+
   bool getOwnsRemappedFileBuffers() const { return OwnsRemappedFileBuffers; }
   void setOwnsRemappedFileBuffers(bool val) { OwnsRemappedFileBuffers = val; }
 
+  /// \brief Determine whether out-of-date preambles are rebuilt on a
+  /// background thread.
+  bool getBuildPreambleInBackground() const {
+    return BuildPreambleInBackground;
+  }
+
+  /// \brief Rebuild out-of-date preambles on a background thread.
+  ///
+  /// When enabled, \c Reparse() does not wait for a new precompiled preamble.
+  /// If only the files included by the preamble have changed, and each of
+  /// them has either kept its size or been remapped, it keeps parsing against
+  /// the previous preamble; otherwise, it parses without one.
+  /// The new preamble is used by the first reparse after it is ready. This
+  /// has no effect when LLVM is built without thread support.
+  void setBuildPreambleInBackground(bool Enable);
+
+  /// \brief Determine whether the preamble is precompiled as a chain of PCH
+  /// files split at its top-level inclusions.
+  bool getChainPreambleAtIncludes() const { return ChainPreambleAtIncludes; }
+
+  /// \brief Precompile the preamble as a chain of PCH files, split after its
+  /// top-level inclusions, each one chained to the previous one.
+  ///
+  /// When the preamble text or one of the files it includes changes, only
+  /// the segments from the first one affected onwards are precompiled again.
+  /// This has no effect while preambles are built in the background.
+  ///
+  /// Source locations within the main file are only mapped from the last
+  /// segment of the preamble; declarations in the main file's preamble that
+  /// were precompiled in earlier segments keep locations in their own loaded
+  /// copy of the main file.
+  void setChainPreambleAtIncludes(bool Enable) {
+    ChainPreambleAtIncludes = Enable;
+  }
+
   StringRef getMainFileName() const;
 
   /// \brief If this ASTUnit came from an AST file, returns the filename for it.
@@ -51,6 +51,29 @@ class Sema;
 class SourceManager;
 class TargetInfo;
 
+/// \brief Counts of the implicit module builds performed for a compiler
+/// instance, including those performed by the instances it spawned to build
+/// modules, as reported by -module-cache-stats.
+struct ModuleCacheStatistics {
+  /// \brief The number of modules successfully built because they were
+  /// missing from the module cache or out of date.
+  unsigned NumModulesBuilt = 0;
+
+  /// \brief The number of modules built that turned out identical to one
+  /// already in the content store, and now share its storage.
+  unsigned NumModulesShared = 0;
+
+  /// \brief The number of module files evicted to keep the module cache
+  /// within its size limit.
+  unsigned NumModuleFilesEvicted = 0;
+
+  void add(const ModuleCacheStatistics &Other) {
+    NumModulesBuilt += Other.NumModulesBuilt;
+    NumModulesShared += Other.NumModulesShared;
+    NumModuleFilesEvicted += Other.NumModuleFilesEvicted;
+  }
+};
+
 /// CompilerInstance - Helper class for managing a single instance of the Clang
 /// compiler.
 ///
@@ -154,6 +177,9 @@ class CompilerInstance : public ModuleLoader {
   /// \brief One or more modules failed to build.
   bool ModuleBuildFailed = false;
 
+  /// \brief The implicit module builds performed for this instance.
+  ModuleCacheStatistics ModuleCacheStats;
+
   /// \brief Holds information about the output file.
   ///
   /// If TempFilename is not empty we must rename it to Filename at the end.
@@ -243,6 +269,10 @@ public:
     BuildGlobalModuleIndex = Build;
   }
 
+  /// \brief Retrieve the counts of implicit module builds performed for
+  /// this instance.
+  ModuleCacheStatistics &getModuleCacheStats() { return ModuleCacheStats; }
+
   /// }
   /// @name Forwarding Methods
   /// {
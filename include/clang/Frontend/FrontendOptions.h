@@ -172,8 +172,12 @@ public:
   unsigned ShowHelp : 1;                   ///< Show the -help text.
   unsigned ShowStats : 1;                  ///< Show frontend performance
                                            /// metrics and statistics.
+  unsigned ShowModuleCacheStats : 1;       ///< Show statistics about the
+                                           /// implicit module cache.
   unsigned ShowTimers : 1;                 ///< Show timers for individual
                                            /// actions.
+  unsigned ShowASTMemoryReport : 1;        ///< Show the memory used by the
+                                           /// AST, as JSON.
   unsigned ShowVersion : 1;                ///< Show the -version text.
   unsigned FixWhatYouCan : 1;              ///< Apply fixes even if there are
                                            /// unfixable errors.
@@ -202,6 +206,9 @@ public:
                                            ///< files into the PCM file.
   unsigned IncludeTimestamps : 1;          ///< Whether timestamps should be
                                            ///< written to the produced PCH file.
+  unsigned ParallelASTSerialization : 1;   ///< Whether declarations and types
+                                           ///< are encoded on several threads
+                                           ///< when writing an AST file.
 
   CodeCompleteOptions CodeCompleteOpts;
 
@@ -324,16 +331,24 @@ public:
   /// Filename to write statistics to.
   std::string StatsFile;
 
+  /// If non-empty, the file to write a profile of template instantiations to,
+  /// in the Chrome trace event format. A report of the most expensive
+  /// templates is written next to it, with ".report" appended to the name.
+  std::string TemplateProfileFile;
+
 public:
   FrontendOptions() :
     DisableFree(false), RelocatablePCH(false), ShowHelp(false),
-    ShowStats(false), ShowTimers(false), ShowVersion(false),
-    FixWhatYouCan(false), FixOnlyWarnings(false), FixAndRecompile(false),
+    ShowStats(false), ShowModuleCacheStats(false), ShowTimers(false),
+    ShowASTMemoryReport(false), ShowVersion(false), FixWhatYouCan(false),
+    FixOnlyWarnings(false),
+    FixAndRecompile(false),
     FixToTemporaries(false), ARCMTMigrateEmitARCErrors(false),
     SkipFunctionBodies(false), UseGlobalModuleIndex(true),
     GenerateGlobalModuleIndex(true), ASTDumpDecls(false), ASTDumpLookups(false),
     BuildingImplicitModule(false), ModulesEmbedAllFiles(false),
-    IncludeTimestamps(true), ARCMTAction(ARCMT_None),
+    IncludeTimestamps(true), ParallelASTSerialization(false),
+    ARCMTAction(ARCMT_None),
     ObjCMTAction(ObjCMT_None), ProgramAction(frontend::ParseSyntaxOnly)
   {}
 
@@ -137,6 +137,20 @@ public:
   /// regenerated often.
   unsigned ModuleCachePruneAfter;
 
+  /// \brief The number of threads that may be used to build, ahead of time,
+  /// the implicit modules that a module being built is likely to import.
+  ///
+  /// With the default of 1, each module is built when it is first imported.
+  unsigned ModuleBuildJobs;
+
+  /// \brief The size (in megabytes) beyond which the least recently used
+  /// module files are evicted from the module cache, or 0 for no limit.
+  ///
+  /// The cache is only checked, and trimmed, after a compilation that built
+  /// modules, since nothing else makes it grow. Each compilation marks the
+  /// module files it loaded as used, rather than relying on access times.
+  unsigned ModuleCacheSizeLimit;
+
   /// \brief The time in seconds when the build session started.
   ///
   /// This time is used by other optimizations in header search and module
@@ -180,16 +194,23 @@ public:
 
   unsigned ModulesHashContent : 1;
 
+  /// \brief Whether implicitly-built module files that are identical to
+  /// one built for another configuration should share its storage, through
+  /// a content-addressed store in the module cache.
+  unsigned ModuleCacheShareIdentical : 1;
+
   HeaderSearchOptions(StringRef _Sysroot = "/")
       : Sysroot(_Sysroot), ModuleFormat("raw"), DisableModuleHash(0),
         ImplicitModuleMaps(0), ModuleMapFileHomeIsCwd(0),
         ModuleCachePruneInterval(7 * 24 * 60 * 60),
-        ModuleCachePruneAfter(31 * 24 * 60 * 60), BuildSessionTimestamp(0),
+        ModuleCachePruneAfter(31 * 24 * 60 * 60), ModuleBuildJobs(1),
+        ModuleCacheSizeLimit(0), BuildSessionTimestamp(0),
         UseBuiltinIncludes(true), UseStandardSystemIncludes(true),
         UseStandardCXXIncludes(true), UseLibcxx(false), Verbose(false),
         ModulesValidateOncePerBuildSession(false),
         ModulesValidateSystemHeaders(false), UseDebugInfo(false),
-        ModulesValidateDiagnosticOptions(true), ModulesHashContent(false) {}
+        ModulesValidateDiagnosticOptions(true), ModulesHashContent(false),
+        ModuleCacheShareIdentical(false) {}
 
   /// AddPath - Add the \p Path path to the specified \p Group list.
   void AddPath(StringRef Path, frontend::IncludeDirGroup Group,
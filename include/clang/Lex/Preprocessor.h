@@ -585,6 +585,23 @@ class Preprocessor {
   unsigned NumFastMacroExpanded, NumTokenPaste, NumFastTokenPaste;
   unsigned NumSkipped;
 
+  /// \brief The source location entries and address space consumed by the
+  /// expansions of a single macro, including macros expanded while it was
+  /// active.
+  struct MacroSLocUsage {
+    unsigned NumExpansions = 0;
+    unsigned NumSLocEntries = 0;
+    uint64_t SLocBytes = 0;
+  };
+
+  /// \brief Whether to record per-macro source location usage for
+  /// -print-stats.
+  bool RecordMacroSLocUsage;
+
+  /// \brief Source location usage of each expanded macro, populated only when
+  /// \c RecordMacroSLocUsage is set.
+  llvm::DenseMap<const IdentifierInfo *, MacroSLocUsage> MacroSLocUsageMap;
+
   /// \brief The predefined macros that preprocessor should use from the
   /// command line etc.
   std::string Predefines;
@@ -1545,6 +1562,15 @@ public:
       ++NumTokenPaste;
   }
 
+  /// \brief Whether per-macro source location usage is being recorded.
+  bool isRecordingMacroSLocUsage() const { return RecordMacroSLocUsage; }
+
+  /// \brief Note that an expansion of the macro \p II has finished, having
+  /// started when the SourceManager had \p StartEntries local SLocEntries and
+  /// a next local offset of \p StartOffset.
+  void noteMacroSLocUsage(const IdentifierInfo *II, unsigned StartEntries,
+                          unsigned StartOffset);
+
   void PrintStats();
 
   size_t getTotalMemory() const;
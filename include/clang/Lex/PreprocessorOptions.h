@@ -54,6 +54,10 @@ public:
   /// definitions and expansions.
   unsigned DetailedRecord : 1;
 
+  /// \brief Whether to record how much of the source location address space
+  /// the expansions of each macro consume, for -print-stats.
+  bool RecordMacroSLocUsage;
+
   /// The implicit PCH included at the start of the translation unit, or empty.
   std::string ImplicitPCHInclude;
 
@@ -140,6 +144,7 @@ public:
 
 public:
   PreprocessorOptions() : UsePredefines(true), DetailedRecord(false),
+                          RecordMacroSLocUsage(false),
                           DisablePCHValidation(false),
                           AllowPCHWithCompilerErrors(false),
                           DumpDeserializedPCHDecls(false),
@@ -15,8 +15,10 @@
 #define LLVM_CLANG_LEX_TOKENLEXER_H
 
 #include "clang/Basic/SourceLocation.h"
+#include "llvm/ADT/SmallVector.h"
 
 namespace clang {
+  class IdentifierInfo;
   class MacroInfo;
   class Preprocessor;
   class Token;
@@ -71,11 +73,24 @@ class TokenLexer {
   /// "source location address space".
   unsigned MacroStartSLocOffset;
 
+  /// \brief The number of local SLocEntries when the macro expansion started,
+  /// used when recording per-macro source location usage.
+  unsigned MacroStartNumSLocEntries;
+
+  /// \brief The name of the macro being expanded, if any.
+  const IdentifierInfo *MacroName;
+
   /// \brief Location of the macro definition.
   SourceLocation MacroDefStart;
   /// \brief Length of the macro definition.
   unsigned MacroDefLength;
 
+  /// \brief Single-token macro arguments that are operands of a ## operator,
+  /// as pairs of their index in Tokens and the expansion location of the
+  /// argument use.  These tokens keep their spelling location and only get a
+  /// macro argument expansion SLocEntry if they survive the paste.
+  SmallVector<std::pair<unsigned, SourceLocation>, 4> PasteOperandInstLocs;
+
   /// Lexical information about the expansion point of the macro: the identifier
   /// that the macro expanded from had these properties.
   bool AtStartOfLine : 1;
@@ -182,6 +197,11 @@ private:
   /// macro expansion source location entry.
   SourceLocation getExpansionLocForMacroDefLoc(SourceLocation loc) const;
 
+  /// \brief If the token at \p TokIdx is a macro argument waiting to be
+  /// pasted, returns the expansion location of the argument use, otherwise
+  /// returns an invalid SourceLocation.
+  SourceLocation getPasteOperandInstLoc(unsigned TokIdx) const;
+
   /// \brief Creates SLocEntries and updates the locations of macro argument
   /// tokens to their new expanded locations.
   ///
@@ -740,7 +740,8 @@ namespace clang {
     SmallVector<OverloadCandidate, 16> Candidates;
     llvm::SmallPtrSet<Decl *, 16> Functions;
 
-    // Allocator for ConversionSequenceLists. We store the first few of these
+    // Allocator for ConversionSequenceLists, and for the scratch storage used
+    // by BestViableFunction. We store the first few conversion sequences
     // inline to avoid allocation for small sets.
     llvm::BumpPtrAllocator SlabAllocator;
 
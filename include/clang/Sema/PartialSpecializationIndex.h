@@ -0,0 +1,90 @@
+//===--- PartialSpecializationIndex.h - Partial spec lookup -----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines the PartialSpecializationIndex class, which narrows down
+//  the partial specializations of a class template that might match a given
+//  template argument list.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_SEMA_PARTIALSPECIALIZATIONINDEX_H
+#define LLVM_CLANG_SEMA_PARTIALSPECIALIZATIONINDEX_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include <utility>
+
+namespace clang {
+
+class ClassTemplateDecl;
+class ClassTemplatePartialSpecializationDecl;
+class TemplateArgument;
+
+/// \brief An index of the partial specializations of class templates, keyed
+/// by the outermost type constructors of their template arguments.
+///
+/// A partial specialization only matches a template argument list if
+/// substituting the deduced arguments into its own template arguments
+/// produces exactly the given ones. When a type argument of the partial
+/// specialization is, say, a pointer type, it can't match a template argument
+/// that is a reference or a class type, so there is no need to try deducing
+/// its template arguments. The index is conservative: any template argument
+/// whose outermost form it doesn't understand matches everything.
+class PartialSpecializationIndex {
+public:
+  /// \brief The outermost type constructor of a template argument: a
+  /// category, and for builtin and class types, which one.
+  typedef std::pair<unsigned, const void *> Key;
+
+private:
+  struct TemplateIndex {
+    TemplateIndex() : NumIndexed(0) {}
+
+    /// \brief The number of partial specializations indexed so far.
+    unsigned NumIndexed;
+
+    /// \brief The keys of the template arguments of each partial
+    /// specialization, in the order they were indexed.
+    SmallVector<SmallVector<Key, 2>, 4> Signatures;
+
+    /// \brief The partial specializations whose first template argument has
+    /// the given key.
+    llvm::DenseMap<Key, SmallVector<unsigned, 2>> ByFirstArgument;
+
+    /// \brief The partial specializations whose first template argument
+    /// might match any template argument.
+    SmallVector<unsigned, 4> AnyFirstArgument;
+  };
+
+  llvm::DenseMap<const ClassTemplateDecl *, TemplateIndex> Templates;
+
+public:
+  /// \brief Compute the key of the given template argument of a class
+  /// template specialization or partial specialization.
+  static Key getKey(const TemplateArgument &Arg);
+
+  /// \brief Determine whether a template argument of a partial
+  /// specialization with key \p Pattern might match a template argument
+  /// with key \p Arg.
+  static bool mightMatch(Key Pattern, Key Arg);
+
+  /// \brief Retrieve those partial specializations of \p Template that might
+  /// match the template argument list \p Args, in the same order as
+  /// ClassTemplateDecl::getPartialSpecializations would list them.
+  void getCandidates(ClassTemplateDecl *Template,
+                     ArrayRef<TemplateArgument> Args,
+                     SmallVectorImpl<ClassTemplatePartialSpecializationDecl *>
+                         &PartialSpecs);
+};
+
+} // end namespace clang
+
+#endif // LLVM_CLANG_SEMA_PARTIALSPECIALIZATIONINDEX_H
@@ -55,6 +55,7 @@
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/TinyPtrVector.h"
+#include <chrono>
 #include <deque>
 #include <memory>
 #include <string>
@@ -162,6 +163,7 @@ namespace clang {
   class OverloadExpr;
   class ParenListExpr;
   class ParmVarDecl;
+  class PartialSpecializationIndex;
   class Preprocessor;
   class PseudoDestructorTypeStorage;
   class PseudoObjectExpr;
@@ -177,10 +179,12 @@ namespace clang {
   class TemplateDecl;
   class TemplateParameterList;
   class TemplatePartialOrderingContext;
+  class TemplateProfiler;
   class TemplateTemplateParmDecl;
   class Token;
   class TypeAliasDecl;
   class TypedefDecl;
+  class TypoCorrectionIndex;
   class TypedefNameDecl;
   class TypeLoc;
   class TypoCorrectionConsumer;
@@ -1010,6 +1014,49 @@ public:
   /// for C++ records.
   llvm::FoldingSet<SpecialMemberOverloadResultEntry> SpecialMemberCache;
 
+  /// \brief The outcome of deducing a function template's arguments from the
+  /// arguments of a call, keyed by the template and by the canonical types
+  /// and value kinds of the arguments.
+  class DeductionCacheEntry : public llvm::FastFoldingSetNode {
+  public:
+    DeductionCacheEntry(const llvm::FoldingSetNodeID &ID)
+      : FastFoldingSetNode(ID) {}
+
+    /// \brief The TemplateDeductionResult.
+    unsigned Result;
+
+    /// \brief Whether deduction got as far as checking conversions for the
+    /// non-dependent parameters, which depend on the argument expressions
+    /// and so are checked again for each call.
+    bool CheckedNonDependent;
+
+    /// \brief The parameter types passed to that check.
+    SmallVector<QualType, 4> ParamTypesForArgChecking;
+
+    /// \brief The specialization, if deduction succeeded.
+    FunctionDecl *Specialization;
+
+    /// \brief The state of the TemplateDeductionInfo, if deduction failed.
+    TemplateArgumentList *Deduced;
+    TemplateParameter Param;
+    TemplateArgument FirstArg;
+    TemplateArgument SecondArg;
+    unsigned CallArgIndex;
+    bool HasSFINAEDiagnostic;
+    SmallVector<PartialDiagnosticAt, 1> Diagnostics;
+  };
+
+  /// \brief A cache of the outcomes of template argument deduction from
+  /// calls. It is cleared whenever a declaration that could change those
+  /// outcomes is added.
+  llvm::FoldingSet<DeductionCacheEntry> DeductionCache;
+
+  /// \brief The allocator for entries in DeductionCache.
+  llvm::BumpPtrAllocator DeductionCacheAllocator;
+
+  /// \brief Forget the outcomes of all earlier template argument deductions.
+  void clearDeductionCache();
+
   /// \brief A cache of the flags available in enumerations with the flag_bits
   /// attribute.
   mutable llvm::DenseMap<const EnumDecl*, llvm::APInt> FlagBitsCache;
@@ -6855,6 +6902,16 @@ public:
       bool PartialOverloading,
       llvm::function_ref<bool(ArrayRef<QualType>)> CheckNonDependent);
 
+private:
+  TemplateDeductionResult DeduceTemplateArgumentsFromCall(
+      FunctionTemplateDecl *FunctionTemplate,
+      TemplateArgumentListInfo *ExplicitTemplateArgs, ArrayRef<Expr *> Args,
+      FunctionDecl *&Specialization, sema::TemplateDeductionInfo &Info,
+      bool PartialOverloading,
+      llvm::function_ref<bool(ArrayRef<QualType>)> CheckNonDependent);
+
+public:
+
   TemplateDeductionResult
   DeduceTemplateArguments(FunctionTemplateDecl *FunctionTemplate,
                           TemplateArgumentListInfo *ExplicitTemplateArgs,
@@ -7108,6 +7165,24 @@ public:
   /// Specializations whose definitions are currently being instantiated.
   llvm::DenseSet<std::pair<Decl *, unsigned>> InstantiatingSpecializations;
 
+  /// \brief If non-null, records the cost of each code synthesis context
+  /// (-ftemplate-profile).
+  std::unique_ptr<TemplateProfiler> TemplateProf;
+
+  /// \brief Start recording the cost of each template instantiation,
+  /// deduction and substitution with the given profiler.
+  void setTemplateProfiler(std::unique_ptr<TemplateProfiler> Profiler);
+
+  /// \brief Retrieve the template instantiation profiler, if any.
+  TemplateProfiler *getTemplateProfiler() const { return TemplateProf.get(); }
+
+  /// \brief An index of the partial specializations of each class template,
+  /// built as they are needed to instantiate its specializations.
+  std::unique_ptr<PartialSpecializationIndex> PartialSpecIndex;
+
+  /// \brief Retrieve the index of class template partial specializations.
+  PartialSpecializationIndex &getPartialSpecializationIndex();
+
   /// Non-dependent types used in templates that have already been instantiated
   /// by some template instantiation.
   llvm::DenseSet<QualType> InstantiatedNonDependentTypes;
@@ -7443,6 +7518,17 @@ public:
   /// \brief The number of typos corrected by CorrectTypo.
   unsigned TyposCorrected;
 
+  /// \brief The time spent on typo correction so far, which
+  /// -ftypo-correction-budget-ms limits.
+  std::chrono::steady_clock::duration TypoCorrectionTime;
+
+  /// \brief An index of the names considered by unqualified typo correction,
+  /// built the first time a typo is corrected.
+  std::unique_ptr<TypoCorrectionIndex> TypoCorrectionIdx;
+
+  /// \brief Retrieve the index of typo correction candidates.
+  TypoCorrectionIndex &getTypoCorrectionIndex();
+
   typedef llvm::SmallSet<SourceLocation, 2> SrcLocSet;
   typedef llvm::DenseMap<IdentifierInfo *, SrcLocSet> IdentifierSourceLocations;
 
@@ -0,0 +1,128 @@
+//===--- TemplateProfiler.h - Template instantiation profiling --*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines the TemplateProfiler class, which measures the cost of
+//  the template instantiations, deductions and substitutions Sema performs.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_SEMA_TEMPLATEPROFILER_H
+#define LLVM_CLANG_SEMA_TEMPLATEPROFILER_H
+
+#include "clang/Basic/LLVM.h"
+#include "clang/Basic/SourceLocation.h"
+#include "llvm/ADT/ArrayRef.h"
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace clang {
+
+class ASTContext;
+class Decl;
+class NamedDecl;
+
+/// \brief Records the time spent, and the memory allocated by the ASTContext,
+/// in each template instantiation, deduction and substitution that Sema
+/// performs.
+///
+/// Spans nest in the same way as Sema's code synthesis contexts. The profile
+/// can be written as Chrome trace events, which chrome://tracing and similar
+/// viewers display as a flame graph, or as a report of the templates whose
+/// instantiations cost the most.
+class TemplateProfiler {
+public:
+  /// \brief A single instantiation, deduction or substitution.
+  struct Span {
+    /// \brief What kind of work this is, e.g. "instantiate" or "deduce".
+    const char *Kind;
+
+    /// \brief The specialization, or other entity, being worked on.
+    std::string Name;
+
+    /// \brief The template that the work is attributed to in the report.
+    std::string Template;
+
+    /// \brief Where the work was required, as "file:line:column".
+    std::string Location;
+
+    /// \brief The index of the enclosing span, or -1 for an outermost span.
+    int Parent;
+
+    /// \brief Start time, in microseconds since profiling began.
+    uint64_t Start;
+
+    /// \brief Time spent in the span, in microseconds.
+    uint64_t Duration;
+
+    /// \brief Time spent in the span but not in nested spans.
+    uint64_t SelfDuration;
+
+    /// \brief Bytes allocated by the ASTContext during the span.
+    uint64_t Bytes;
+
+    /// \brief Bytes allocated during the span but not during nested spans.
+    uint64_t SelfBytes;
+  };
+
+private:
+  ASTContext &Context;
+
+  /// \brief When profiling began.
+  std::chrono::steady_clock::time_point Origin;
+
+  /// \brief All spans, in the order they started.
+  std::vector<Span> Spans;
+
+  /// \brief A span that has started but not ended.
+  struct OpenSpan {
+    unsigned Index;
+    uint64_t StartBytes;
+    uint64_t ChildDuration;
+    uint64_t ChildBytes;
+  };
+
+  /// \brief The spans that have not ended yet, innermost last.
+  std::vector<OpenSpan> OpenSpans;
+
+  uint64_t now() const;
+
+public:
+  explicit TemplateProfiler(ASTContext &Context);
+
+  /// \brief Start a span.
+  ///
+  /// \param Kind A short description of the work, which must outlive the
+  /// profiler.
+  /// \param Entity The declaration being instantiated or substituted into,
+  /// if any.
+  /// \param Template The template whose parameter \p Entity is, for
+  /// substitutions into template parameters.
+  /// \param Loc The point of instantiation.
+  void beginSpan(const char *Kind, const Decl *Entity,
+                 const NamedDecl *Template, SourceLocation Loc);
+
+  /// \brief End the innermost span.
+  void endSpan();
+
+  /// \brief Retrieve all spans, in the order they started.
+  ArrayRef<Span> getSpans() const { return Spans; }
+
+  /// \brief Write the profile in the Chrome trace event format.
+  void writeTrace(raw_ostream &OS) const;
+
+  /// \brief Write a report of the \p MaxEntries templates whose
+  /// instantiations took the most time.
+  void writeReport(raw_ostream &OS, unsigned MaxEntries) const;
+};
+
+} // end namespace clang
+
+#endif // LLVM_CLANG_SEMA_TEMPLATEPROFILER_H
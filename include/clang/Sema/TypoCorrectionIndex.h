@@ -0,0 +1,90 @@
+//===--- TypoCorrectionIndex.h - Typo correction candidates -----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines the TypoCorrectionIndex class, which finds the known
+//  identifiers that are within a given edit distance of a typo.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_SEMA_TYPOCORRECTIONINDEX_H
+#define LLVM_CLANG_SEMA_TYPOCORRECTIONINDEX_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringRef.h"
+#include <vector>
+
+namespace clang {
+
+class ASTContext;
+class IdentifierInfo;
+
+/// \brief A BK-tree over the names that unqualified typo correction
+/// considers: every identifier in the identifier table, the names of the
+/// supported builtins, and the identifiers of the external source.
+///
+/// Edit distance is a metric, so a subtree whose root is at distance D from
+/// the root of the tree only holds names at distance D from it, and a search
+/// for the names within distance R of a typo only needs to visit the subtrees
+/// whose distance to the root is within R of the typo's. That is a small part
+/// of the tree for the short distances typo correction accepts.
+///
+/// The index is built on first use. Identifiers created since then are added
+/// the next time it's searched, and so are those of the external source once
+/// its generation changes.
+class TypoCorrectionIndex {
+  struct Node {
+    Node(StringRef Name, unsigned Distance)
+        : Name(Name), Distance(Distance), FirstChild(0), NextSibling(0) {}
+
+    StringRef Name;
+
+    /// \brief The edit distance between this name and its parent's.
+    unsigned Distance;
+
+    /// \brief The indices of the first child and the next sibling of this
+    /// node, or zero if there is none; the root is never a child.
+    unsigned FirstChild;
+    unsigned NextSibling;
+  };
+
+  ASTContext &Context;
+
+  std::vector<Node> Nodes;
+
+  /// \brief Whether the builtins and external identifiers have been indexed.
+  bool Built;
+
+  /// \brief The generation of the external source when it was indexed.
+  uint32_t ExternalGeneration;
+
+  /// \brief The identifiers of the identifier table that have been indexed.
+  llvm::DenseSet<const IdentifierInfo *> IndexedIdentifiers;
+
+  /// \brief The names in the tree, so that names seen again are skipped
+  /// without walking it.
+  llvm::DenseSet<StringRef> IndexedNames;
+
+  void insert(StringRef Name);
+  void update();
+
+public:
+  explicit TypoCorrectionIndex(ASTContext &Context)
+      : Context(Context), Built(false), ExternalGeneration(0) {}
+
+  /// \brief Call \p Callback with each known name whose edit distance from
+  /// \p Typo, allowing replacements, is at most \p MaxDistance.
+  void lookup(StringRef Typo, unsigned MaxDistance,
+              llvm::function_ref<void(StringRef)> Callback);
+};
+
+} // end namespace clang
+
+#endif // LLVM_CLANG_SEMA_TYPOCORRECTIONINDEX_H
@@ -607,6 +607,14 @@ namespace clang {
 
       /// \brief Record code for \#pragma pack options.
       PACK_PRAGMA_OPTIONS = 61,
+
+      /// \brief Record code for the identifier filter.
+      ///
+      /// A Bloom filter over the hashes of the identifiers in the
+      /// IDENTIFIER_TABLE, stored as a blob of little-endian 64-bit words.
+      /// A lookup of an identifier that the filter rejects doesn't need to
+      /// probe the table.
+      IDENTIFIER_FILTER = 62,
     };
 
     /// \brief Record types used within a source manager block.
@@ -31,6 +31,7 @@
 #include "clang/Serialization/Module.h"
 #include "clang/Serialization/ModuleFileExtension.h"
 #include "clang/Serialization/ModuleManager.h"
+#include "llvm/ADT/BitVector.h"
 #include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallSet.h"
@@ -469,14 +470,17 @@ private:
   /// declaration resides.
   GlobalDeclMapType GlobalDeclMap;
 
-  typedef std::pair<ModuleFile *, uint64_t> FileOffset;
-  typedef SmallVector<FileOffset, 2> FileOffsetsTy;
-  typedef llvm::DenseMap<serialization::DeclID, FileOffsetsTy>
-      DeclUpdateOffsetsMap;
-
   /// \brief Declarations that have modifications residing in a later file
-  /// in the chain.
-  DeclUpdateOffsetsMap DeclUpdateOffsets;
+  /// in the chain, indexed by global declaration ID.
+  ///
+  /// The update records themselves are kept per module file (see
+  /// \c ModuleFile::DeclUpdateOffsets); this only tells us whether they are
+  /// worth searching when a declaration is loaded.
+  llvm::BitVector DeclsWithUpdates;
+
+  /// \brief The module files that contain declaration updates, in the order
+  /// in which their AST blocks were read.
+  SmallVector<ModuleFile *, 4> ModulesWithDeclUpdates;
 
   struct PendingUpdateRecord {
     Decl *D;
@@ -933,6 +937,10 @@ private:
   /// \brief The number of lookups into identifier tables that succeed.
   unsigned NumIdentifierLookupHits = 0;
 
+  /// \brief The number of lookups into identifier tables that were answered
+  /// by the table's filter without probing the table.
+  unsigned NumIdentifierFilterRejects = 0;
+
   /// \brief The number of selectors that have been read.
   unsigned NumSelectorsRead = 0;
 
@@ -1601,6 +1609,10 @@ public:
                         const PCHContainerReader &PCHContainerRdr,
                         DiagnosticsEngine &Diags);
 
+  /// \brief Read the signature record from the control block of the AST file
+  /// whose bitstream is \p PCH, or else return 0.
+  static ASTFileSignature readASTFileSignature(StringRef PCH);
+
   /// \brief Read the control block for the named AST file.
   ///
   /// \returns true if an error occurred, false otherwise.
@@ -86,6 +86,29 @@ public:
   typedef SmallVectorImpl<uint64_t> RecordDataImpl;
   typedef ArrayRef<uint64_t> RecordDataRef;
 
+  /// \brief A record of the DECLTYPES block whose encoding has been put off
+  /// so that it can be done in parallel with the encoding of other records.
+  ///
+  /// While records are being deferred, the offset handed out for a record
+  /// is its 1-based position in the block rather than a bit position. Once
+  /// the records have been written, \c resolveRecordOffset maps it to the
+  /// record's real bit position.
+  struct DeferredRecord {
+    unsigned Code;
+    unsigned Abbrev;
+    SmallVector<uint64_t, 16> Vals;
+
+    /// \brief The blob of a record emitted with a blob abbreviation. Blobs
+    /// are aligned within the stream, so such a record is encoded serially.
+    std::string Blob;
+    bool HasBlob;
+
+    /// \brief Elements of \c Vals that hold the offset of another record,
+    /// paired with whether they're stored relative to this record. Such a
+    /// record is encoded serially, once those offsets are known.
+    SmallVector<std::pair<unsigned, bool>, 2> Offsets;
+  };
+
   friend class ASTDeclWriter;
   friend class ASTStmtWriter;
   friend class ASTTypeWriter;
@@ -134,6 +157,10 @@ private:
   /// file is up to date, but not otherwise.
   bool IncludeTimestamps;
 
+  /// \brief Indicates whether the records of the DECLTYPES block are encoded
+  /// on several threads; see \c DeferredRecord.
+  bool ParallelRecordEncoding;
+
   /// \brief Indicates when the AST writing is actively performing
   /// serialization, rather than just queueing updates.
   bool WritingAST = false;
@@ -232,6 +259,19 @@ private:
   /// the type's ID.
   std::vector<uint32_t> TypeOffsets;
 
+  /// \brief Whether records are currently queued in \c DeferredRecords
+  /// rather than written to the stream.
+  bool DeferringRecords = false;
+
+  /// \brief The records of the DECLTYPES block that have not been written.
+  std::vector<DeferredRecord> DeferredRecords;
+
+  /// \brief The bit position of each deferred record that has been written.
+  std::vector<uint64_t> DeferredRecordOffsets;
+
+  /// \brief The abbreviations defined in the DECLTYPES block, in order.
+  std::vector<std::shared_ptr<llvm::BitCodeAbbrev>> DeclTypesAbbrevs;
+
   /// \brief The first ID number we can use for our own identifiers.
   serialization::IdentID FirstIdentID = serialization::NUM_PREDEF_IDENT_IDS;
 
@@ -454,6 +494,36 @@ private:
   void WritePragmaDiagnosticMappings(const DiagnosticsEngine &Diag,
                                      bool isModule);
 
+  /// \brief Define an abbreviation in the DECLTYPES block.
+  unsigned EmitDeclTypesAbbrev(std::shared_ptr<llvm::BitCodeAbbrev> Abbrev);
+
+  /// \brief The offset at which the next record will be written.
+  uint64_t getCurrentRecordOffset() const;
+
+  /// \brief Emit a record, deferring it if \c DeferringRecords is set, and
+  /// return its offset.
+  ///
+  /// The elements of \p Record named by \p RelativeOffsets hold offsets of
+  /// earlier records (or zero), and are converted into offsets relative to
+  /// this record. Those named by \p AbsoluteOffsets are only fixed up when
+  /// the record is deferred.
+  uint64_t EmitRecord(unsigned Code, RecordDataImpl &Record,
+                      unsigned Abbrev = 0,
+                      ArrayRef<unsigned> RelativeOffsets = None,
+                      ArrayRef<unsigned> AbsoluteOffsets = None);
+
+  /// \brief Emit a record with a blob, deferring it if \c DeferringRecords
+  /// is set, and return its offset.
+  uint64_t EmitRecordWithBlob(unsigned Abbrev, RecordDataRef Record,
+                              StringRef Blob);
+
+  /// \brief Write out the records in \c DeferredRecords.
+  void WriteDeferredRecords();
+
+  /// \brief Map an offset handed out for a deferred record that has been
+  /// written to the bit position of that record.
+  uint64_t resolveRecordOffset(uint64_t Offset) const;
+
   unsigned TypeExtQualAbbrev = 0;
   unsigned TypeFunctionProtoAbbrev = 0;
   void WriteTypeAbbrevs();
@@ -519,7 +589,8 @@ public:
   ASTWriter(llvm::BitstreamWriter &Stream, SmallVectorImpl<char> &Buffer,
             MemoryBufferCache &PCMCache,
             ArrayRef<std::shared_ptr<ModuleFileExtension>> Extensions,
-            bool IncludeTimestamps = true);
+            bool IncludeTimestamps = true,
+            bool ParallelRecordEncoding = false);
   ~ASTWriter() override;
 
   const LangOptions &getLangOpts() const;
@@ -734,17 +805,6 @@ class ASTRecordWriter {
   void FlushStmts();
   void FlushSubStmts();
 
-  void PrepareToEmit(uint64_t MyOffset) {
-    // Convert offsets into relative form.
-    for (unsigned I : OffsetIndices) {
-      auto &StoredOffset = (*Record)[I];
-      assert(StoredOffset < MyOffset && "invalid offset");
-      if (StoredOffset)
-        StoredOffset = MyOffset - StoredOffset;
-    }
-    OffsetIndices.clear();
-  }
-
 public:
   /// Construct a ASTRecordWriter that uses the default encoding scheme.
   ASTRecordWriter(ASTWriter &Writer, ASTWriter::RecordDataImpl &Record)
@@ -778,9 +838,8 @@ public:
   /// return its offset.
   // FIXME: Allow record producers to suggest Abbrevs.
   uint64_t Emit(unsigned Code, unsigned Abbrev = 0) {
-    uint64_t Offset = Writer->Stream.GetCurrentBitNo();
-    PrepareToEmit(Offset);
-    Writer->Stream.EmitRecord(Code, *Record, Abbrev);
+    uint64_t Offset = Writer->EmitRecord(Code, *Record, Abbrev, OffsetIndices);
+    OffsetIndices.clear();
     FlushStmts();
     return Offset;
   }
@@ -788,9 +847,9 @@ public:
   /// \brief Emit the record to the stream, preceded by its substatements.
   uint64_t EmitStmt(unsigned Code, unsigned Abbrev = 0) {
     FlushSubStmts();
-    PrepareToEmit(Writer->Stream.GetCurrentBitNo());
-    Writer->Stream.EmitRecord(Code, *Record, Abbrev);
-    return Writer->Stream.GetCurrentBitNo();
+    Writer->EmitRecord(Code, *Record, Abbrev, OffsetIndices);
+    OffsetIndices.clear();
+    return Writer->getCurrentRecordOffset();
   }
 
   /// \brief Add a bit offset into the record. This will be converted into an
@@ -953,7 +1012,8 @@ public:
   PCHGenerator(const Preprocessor &PP, StringRef OutputFile, StringRef isysroot,
                std::shared_ptr<PCHBuffer> Buffer,
                ArrayRef<std::shared_ptr<ModuleFileExtension>> Extensions,
-               bool AllowASTWithErrors = false, bool IncludeTimestamps = true);
+               bool AllowASTWithErrors = false, bool IncludeTimestamps = true,
+               bool ParallelRecordEncoding = false);
   ~PCHGenerator() override;
   void InitializeSema(Sema &S) override { SemaPtr = &S; }
   void HandleTranslationUnit(ASTContext &Ctx) override;
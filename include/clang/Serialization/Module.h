@@ -21,11 +21,14 @@
 #include "clang/Serialization/ASTBitCodes.h"
 #include "clang/Serialization/ContinuousRangeMap.h"
 #include "clang/Serialization/ModuleFileExtension.h"
+#include "llvm/ADT/BitVector.h"
 #include "llvm/ADT/SetVector.h"
 #include "llvm/Bitcode/BitstreamReader.h"
 #include "llvm/Support/Endian.h"
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace llvm {
 template <typename Info> class OnDiskChainedHashTable;
@@ -276,6 +279,16 @@ public:
   /// IdentifierHashTable.
   void *IdentifierLookupTable = nullptr;
 
+  /// \brief The Bloom filter over the identifiers in IdentifierLookupTable,
+  /// if the AST file has one.
+  ///
+  /// This pointer points into a memory buffer, where the little-endian
+  /// 64-bit words of the filter live.
+  const unsigned char *IdentifierFilter = nullptr;
+
+  /// \brief The number of 64-bit words in IdentifierFilter.
+  unsigned IdentifierFilterSize = 0;
+
   /// \brief Offsets of identifiers that we're going to preload within
   /// IdentifierTableData.
   std::vector<unsigned> PreloadIdentifierOffsets;
@@ -423,6 +436,17 @@ public:
   /// module.
   SmallVector<uint64_t, 1> ObjCCategories;
 
+  /// \brief The (global declaration ID, offset) pairs of the DECL_UPDATES
+  /// records in this module file, sorted by declaration ID.
+  ///
+  /// These are only consulted when the declaration they update is
+  /// deserialized, so that loading a module doesn't cost anything for the
+  /// updates to declarations that are never used.
+  std::vector<std::pair<serialization::DeclID, uint64_t>> DeclUpdateOffsets;
+
+  /// \brief Which entries of \c DeclUpdateOffsets have already been applied.
+  llvm::BitVector DeclUpdateOffsetsApplied;
+
   // === Types ===
 
   /// \brief The number of types in this AST file.
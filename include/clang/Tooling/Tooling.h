@@ -325,6 +325,23 @@ class ClangTool {
   /// \param Action Tool action.
   int run(ToolAction *Action);
 
+  /// Runs an action over all files specified in the command line, processing
+  /// up to \p ThreadCount translation units at a time.
+  ///
+  /// Every translation unit gets its own FileManager, but all of them share
+  /// one thread-safe cache of file status and contents, so each header is
+  /// stat'ed and read only once. All compile commands are retrieved before
+  /// any translation unit is processed. \p Action, and the diagnostic consumer
+  /// if one is set, must be safe to use from several threads at once.
+  ///
+  /// The translation units processed this way don't use the file manager
+  /// returned by getFiles().
+  ///
+  /// \param Action Tool action.
+  /// \param ThreadCount The maximum number of threads to use. With 1 or 0,
+  /// this is the same as run(Action).
+  int run(ToolAction *Action, unsigned ThreadCount);
+
   /// \brief Create an AST for each file specified in the command line and
   /// append them to ASTs.
   int buildASTs(std::vector<std::unique_ptr<ASTUnit>> &ASTs);
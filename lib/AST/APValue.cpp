@@ -19,6 +19,8 @@
 #include "clang/AST/Type.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <memory>
 using namespace clang;
 
 namespace {
@@ -104,10 +106,32 @@ struct APValue::MemberPointerData : MemberPointerBase {
 
 // FIXME: Reduce the malloc traffic here.
 
+/// The number of values stored for an array: its initialized elements, and
+/// its filler if it has one.
+static unsigned getNumStoredElts(unsigned NumElts, unsigned ArrSize) {
+  return NumElts + (NumElts != ArrSize ? 1 : 0);
+}
+
 APValue::Arr::Arr(unsigned NumElts, unsigned Size) :
-  Elts(new APValue[NumElts + (NumElts != Size ? 1 : 0)]),
-  NumElts(NumElts), ArrSize(Size) {}
-APValue::Arr::~Arr() { delete [] Elts; }
+  Elts(new APValue[getNumStoredElts(NumElts, Size)]),
+  NumElts(NumElts), ArrSize(Size), PackedSemantics(nullptr),
+  PackedBitWidth(0), PackedIsUnsigned(false), IsPacked(false) {}
+APValue::Arr::Arr(const Arr &Packed) :
+  Words(new uint64_t[getNumStoredElts(Packed.NumElts, Packed.ArrSize)]),
+  NumElts(Packed.NumElts), ArrSize(Packed.ArrSize),
+  PackedSemantics(Packed.PackedSemantics),
+  PackedBitWidth(Packed.PackedBitWidth),
+  PackedIsUnsigned(Packed.PackedIsUnsigned), IsPacked(true) {
+  assert(Packed.IsPacked && "only packed arrays can be copied directly");
+  std::copy(Packed.Words, Packed.Words + getNumStoredElts(NumElts, ArrSize),
+            Words);
+}
+APValue::Arr::~Arr() {
+  if (IsPacked)
+    delete [] Words;
+  else
+    delete [] Elts;
+}
 
 APValue::StructData::StructData(unsigned NumBases, unsigned NumFields) :
   Elts(new APValue[NumBases+NumFields]),
@@ -157,6 +181,13 @@ APValue::APValue(const APValue &RHS) : Kind(Uninitialized) {
                 RHS.getLValueCallIndex(), RHS.isNullPointer());
     break;
   case Array:
+    if (RHS.isPackedArray()) {
+      // The elements are plain words; copy them all at once.
+      new ((void*)(char*)Data.buffer)
+          Arr(*(const Arr*)(const char*)RHS.Data.buffer);
+      Kind = Array;
+      break;
+    }
     MakeArray(RHS.getArrayInitializedElts(), RHS.getArraySize());
     for (unsigned I = 0, N = RHS.getArrayInitializedElts(); I != N; ++I)
       getArrayInitializedElt(I) = RHS.getArrayInitializedElt(I);
@@ -300,12 +331,18 @@ void APValue::dump(raw_ostream &OS) const {
   case Array:
     OS << "Array: ";
     for (unsigned I = 0, N = getArrayInitializedElts(); I != N; ++I) {
-      getArrayInitializedElt(I).dump(OS);
+      if (isPackedArray())
+        getPackedArrayElt(I).dump(OS);
+      else
+        getArrayInitializedElt(I).dump(OS);
       if (I != getArraySize() - 1) OS << ", ";
     }
     if (hasArrayFiller()) {
       OS << getArraySize() - getArrayInitializedElts() << " x ";
-      getArrayFiller().dump(OS);
+      if (isPackedArray())
+        getPackedArrayElt(getArrayInitializedElts()).dump(OS);
+      else
+        getArrayFiller().dump(OS);
     }
     return;
   case Struct:
@@ -478,17 +515,19 @@ void APValue::printPretty(raw_ostream &Out, ASTContext &Ctx, QualType Ty) const{
     const ArrayType *AT = Ctx.getAsArrayType(Ty);
     QualType ElemTy = AT->getElementType();
     Out << '{';
-    if (unsigned N = getArrayInitializedElts()) {
-      getArrayInitializedElt(0).printPretty(Out, Ctx, ElemTy);
-      for (unsigned I = 1; I != N; ++I) {
+    for (unsigned I = 0, N = getArrayInitializedElts(); I != N; ++I) {
+      if (I != 0)
         Out << ", ";
-        if (I == 10) {
-          // Avoid printing out the entire contents of large arrays.
-          Out << "...";
-          break;
-        }
-        getArrayInitializedElt(I).printPretty(Out, Ctx, ElemTy);
+      if (I == 10) {
+        // Avoid printing out the entire contents of large arrays.
+        Out << "...";
+        break;
       }
+      // Read the elements of a packed array without unpacking it.
+      if (isPackedArray())
+        getPackedArrayElt(I).printPretty(Out, Ctx, ElemTy);
+      else
+        getArrayInitializedElt(I).printPretty(Out, Ctx, ElemTy);
     }
     Out << '}';
     return;
@@ -649,6 +688,113 @@ void APValue::MakeArray(unsigned InitElts, unsigned Size) {
   Kind = Array;
 }
 
+/// Get the bit pattern of an element of a packed array with the given element
+/// type. Returns false if the value isn't of that type.
+static bool getPackedWord(const APValue &Value,
+                          const llvm::fltSemantics *Semantics,
+                          unsigned BitWidth, bool IsUnsigned, uint64_t &Word) {
+  if (Semantics) {
+    if (!Value.isFloat() || &Value.getFloat().getSemantics() != Semantics)
+      return false;
+    Word = Value.getFloat().bitcastToAPInt().getZExtValue();
+    return true;
+  }
+  if (!Value.isInt() || Value.getInt().getBitWidth() != BitWidth ||
+      Value.getInt().isUnsigned() != IsUnsigned)
+    return false;
+  Word = Value.getInt().getZExtValue();
+  return true;
+}
+
+APValue APValue::getPackedArrayElt(unsigned I) const {
+  assert(isPackedArray() && "Invalid accessor");
+  assert(I < getArraySize() && "Index out of range");
+  const Arr *A = (const Arr*)(const char*)Data.buffer;
+  llvm::APInt Bits(A->PackedBitWidth, A->Words[std::min(I, A->NumElts)]);
+  if (A->PackedSemantics)
+    return APValue(llvm::APFloat(*A->PackedSemantics, Bits));
+  return APValue(llvm::APSInt(Bits, A->PackedIsUnsigned));
+}
+
+bool APValue::setPackedArrayElt(unsigned I, const APValue &Value) {
+  assert(isPackedArray() && "Invalid accessor");
+  assert(I < getArraySize() && "Index out of range");
+  Arr *A = (Arr*)(char*)Data.buffer;
+  uint64_t Word;
+  if (!getPackedWord(Value, A->PackedSemantics, A->PackedBitWidth,
+                     A->PackedIsUnsigned, Word))
+    return false;
+
+  if (I >= A->NumElts) {
+    // Give the element a value of its own. As for an unpacked array, always
+    // at least double the number of initialized elements.
+    unsigned NewElts = std::max(I + 1, A->NumElts * 2);
+    NewElts = std::min(A->ArrSize, std::max(NewElts, 8u));
+    unsigned NumStored = getNumStoredElts(NewElts, A->ArrSize);
+    uint64_t *Words = new uint64_t[NumStored];
+    std::copy(A->Words, A->Words + A->NumElts, Words);
+    std::fill(Words + A->NumElts, Words + NumStored, A->Words[A->NumElts]);
+    delete [] A->Words;
+    A->Words = Words;
+    A->NumElts = NewElts;
+  }
+  A->Words[I] = Word;
+  return true;
+}
+
+bool APValue::packArray() {
+  assert(isArray() && "Invalid accessor");
+  Arr *A = (Arr*)(char*)Data.buffer;
+  if (A->IsPacked)
+    return true;
+
+  unsigned NumStored = getNumStoredElts(A->NumElts, A->ArrSize);
+  if (!NumStored)
+    return false;
+
+  // All the elements must have the type of the first one.
+  const APValue &First = A->Elts[0];
+  const llvm::fltSemantics *Semantics = nullptr;
+  unsigned BitWidth;
+  bool IsUnsigned = false;
+  if (First.isInt()) {
+    BitWidth = First.getInt().getBitWidth();
+    IsUnsigned = First.getInt().isUnsigned();
+  } else if (First.isFloat()) {
+    Semantics = &First.getFloat().getSemantics();
+    BitWidth = llvm::APFloat::semanticsSizeInBits(*Semantics);
+  } else {
+    return false;
+  }
+  if (BitWidth > 64)
+    return false;
+
+  std::unique_ptr<uint64_t[]> Words(new uint64_t[NumStored]);
+  for (unsigned I = 0; I != NumStored; ++I)
+    if (!getPackedWord(A->Elts[I], Semantics, BitWidth, IsUnsigned, Words[I]))
+      return false;
+
+  delete [] A->Elts;
+  A->Words = Words.release();
+  A->PackedSemantics = Semantics;
+  A->PackedBitWidth = BitWidth;
+  A->PackedIsUnsigned = IsUnsigned;
+  A->IsPacked = true;
+  return true;
+}
+
+void APValue::unpackArray() {
+  assert(isPackedArray() && "Invalid accessor");
+  Arr *A = (Arr*)(char*)Data.buffer;
+  unsigned NumStored = getNumStoredElts(A->NumElts, A->ArrSize);
+  APValue *Elts = new APValue[NumStored];
+  for (unsigned I = 0; I != NumStored; ++I)
+    Elts[I] = getPackedArrayElt(I);
+  delete [] A->Words;
+  A->Elts = Elts;
+  A->IsPacked = false;
+}
+
 void APValue::MakeMemberPointer(const ValueDecl *Member, bool IsDerivedMember,
                                 ArrayRef<const CXXRecordDecl*> Path) {
   assert(isUninit() && "Bad state change");
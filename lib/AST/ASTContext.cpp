@@ -13,6 +13,7 @@
 
 #include "clang/AST/ASTContext.h"
 #include "CXXABI.h"
+#include "ConstexprCallCache.h"
 #include "clang/AST/ASTMutationListener.h"
 #include "clang/AST/Attr.h"
 #include "clang/AST/CharUnits.h"
@@ -587,6 +588,7 @@ ASTContext::CanonicalTemplateTemplateParm::Profile(llvm::FoldingSetNodeID &ID,
 TemplateTemplateParmDecl *
 ASTContext::getCanonicalTemplateTemplateParmDecl(
                                           TemplateTemplateParmDecl *TTP) const {
+  TypeUniquingLock Lock(*this);
   // Check if we already have a canonical template template parameter.
   llvm::FoldingSetNodeID ID;
   CanonicalTemplateTemplateParm::Profile(ID, TTP);
@@ -755,7 +757,9 @@ ASTContext::ASTContext(LangOptions &LOpts, SourceManager &SM,
       PrintingPolicy(LOpts), Idents(idents), Selectors(sels),
       BuiltinInfo(builtins), DeclarationNames(*this), ExternalSource(nullptr),
       Listener(nullptr), Comments(SM), CommentsLoaded(false),
-      CommentCommandTraits(BumpAlloc, LOpts.CommentOpts), LastSDM(nullptr, 0) {
+      CommentCommandTraits(BumpAlloc, LOpts.CommentOpts), LastSDM(nullptr, 0),
+      NumTypeSourceInfos(0), TypeSourceInfoBytes(0),
+      NumSharedTypeSourceInfoUses(0) {
   TUDecl = TranslationUnitDecl::Create(*this);
 }
 
@@ -885,6 +889,120 @@ void ASTContext::PrintStats() const {
   BumpAlloc.PrintStats();
 }
 
+namespace {
+/// \brief Accumulates the number and size of the AST nodes of each kind, and
+/// writes them as a JSON object.
+class NodeKindCounts {
+  raw_ostream &OS;
+  uint64_t TotalCount;
+  uint64_t TotalBytes;
+  bool First;
+
+public:
+  NodeKindCounts(raw_ostream &OS)
+      : OS(OS), TotalCount(0), TotalBytes(0), First(true) {
+    OS << "{\"kinds\": {";
+  }
+
+  void add(StringRef Kind, uint64_t Count, uint64_t Size) {
+    if (!Count)
+      return;
+    OS << (First ? "" : ", ") << '"' << Kind << "\": {\"count\": " << Count
+       << ", \"bytes\": " << Count * Size << '}';
+    First = false;
+    TotalCount += Count;
+    TotalBytes += Count * Size;
+  }
+
+  void finish() {
+    OS << "}, \"count\": " << TotalCount << ", \"bytes\": " << TotalBytes
+       << '}';
+  }
+};
+} // end anonymous namespace
+
+void ASTContext::printMemoryReport(raw_ostream &OS) const {
+  OS << "{\n";
+  OS << "  \"allocator\": {\"allocated\": " << BumpAlloc.getBytesAllocated()
+     << ", \"total\": " << BumpAlloc.getTotalMemory()
+     << ", \"sideTables\": " << getSideTableAllocatedMemory() << "},\n";
+
+  // Declarations and statements. The sizes exclude trailing objects, such as
+  // the operands of expressions with a variable number of them.
+  OS << "  \"decls\": ";
+  NodeKindCounts Decls(OS);
+  Decl::getStatistics([&](StringRef Kind, unsigned Count, size_t Size) {
+    Decls.add(Kind, Count, Size);
+  });
+  Decls.finish();
+  OS << ",\n";
+
+  OS << "  \"stmts\": ";
+  NodeKindCounts Stmts(OS);
+  Stmt::getStatistics([&](StringRef Class, unsigned Count, size_t Size) {
+    Stmts.add(Class, Count, Size);
+  });
+  Stmts.finish();
+  OS << ",\n";
+
+  // Types.
+  unsigned TypeCounts[] = {
+#define TYPE(Name, Parent) 0,
+#define ABSTRACT_TYPE(Name, Parent)
+#include "clang/AST/TypeNodes.def"
+    0 // Extra
+  };
+  for (const Type *T : Types)
+    ++TypeCounts[(unsigned)T->getTypeClass()];
+
+  OS << "  \"types\": ";
+  NodeKindCounts TypeKinds(OS);
+  unsigned Idx = 0;
+#define TYPE(Name, Parent)                                                     \
+  TypeKinds.add(#Name, TypeCounts[Idx++], sizeof(Name##Type));
+#define ABSTRACT_TYPE(Name, Parent)
+#include "clang/AST/TypeNodes.def"
+  TypeKinds.finish();
+  OS << ",\n";
+
+  OS << "  \"typeSourceInfo\": {\"count\": " << NumTypeSourceInfos
+     << ", \"bytes\": " << TypeSourceInfoBytes
+     << ", \"sharedUses\": " << NumSharedTypeSourceInfoUses << "},\n";
+
+  // Declaration context lookup tables.
+  unsigned NumLookupTables = 0, NumLookupEntries = 0;
+  size_t LookupBytes = 0;
+  for (StoredDeclsMap *Map = LastSDM.getPointer(); Map;
+       Map = Map->Previous.getPointer()) {
+    ++NumLookupTables;
+    NumLookupEntries += Map->size();
+    LookupBytes += sizeof(StoredDeclsMap) + Map->getMemorySize();
+    for (const auto &Entry : *Map)
+      if (StoredDeclsList::DeclsTy *Vec = Entry.second.getAsVector())
+        LookupBytes += sizeof(*Vec) + llvm::capacity_in_bytes(*Vec);
+  }
+  OS << "  \"lookupTables\": {\"count\": " << NumLookupTables
+     << ", \"entries\": " << NumLookupEntries << ", \"bytes\": " << LookupBytes
+     << "},\n";
+
+  // Comments.
+  ArrayRef<RawComment *> RawComments = Comments.getComments();
+  OS << "  \"comments\": {\"count\": " << RawComments.size() << ", \"bytes\": "
+     << RawComments.size() * (sizeof(RawComment) + sizeof(RawComment *)) +
+            llvm::capacity_in_bytes(RedeclComments) +
+            llvm::capacity_in_bytes(ParsedComments)
+     << "},\n";
+
+  // The source manager.
+  SourceManager::MemoryBufferSizes Buffers = SourceMgr.getMemoryBufferSizes();
+  OS << "  \"sourceManager\": {\"contentCaches\": "
+     << SourceMgr.getContentCacheSize()
+     << ", \"dataStructures\": " << SourceMgr.getDataStructureSizes()
+     << ", \"mallocBuffers\": " << Buffers.malloc_bytes
+     << ", \"mmapBuffers\": " << Buffers.mmap_bytes << "}\n";
+  OS << "}\n";
+}
+
 void ASTContext::mergeDefinitionIntoModule(NamedDecl *ND, Module *M,
                                            bool NotifyListeners) {
   if (NotifyListeners)
@@ -2226,13 +2344,57 @@ TypeSourceInfo *ASTContext::CreateTypeSourceInfo(QualType T,
   TypeSourceInfo *TInfo =
     (TypeSourceInfo*)BumpAlloc.Allocate(sizeof(TypeSourceInfo) + DataSize, 8);
   new (TInfo) TypeSourceInfo(T);
+  ++NumTypeSourceInfos;
+  TypeSourceInfoBytes += sizeof(TypeSourceInfo) + DataSize;
   return TInfo;
 }
 
+/// \brief Determine whether the type location data for \p T holds nothing
+/// but source locations, so that nobody will fill in any other information
+/// after creating trivial type source information for it.
+static bool hasOnlyLocationData(QualType T) {
+  while (true) {
+    const Type *Ty = T.getTypePtr();
+    switch (Ty->getTypeClass()) {
+    case Type::Builtin:
+    case Type::Record:
+    case Type::Enum:
+    case Type::Typedef:
+    case Type::TemplateTypeParm:
+    case Type::SubstTemplateTypeParm:
+    case Type::InjectedClassName:
+      return true;
+    case Type::Pointer:
+      T = cast<PointerType>(Ty)->getPointeeType();
+      break;
+    case Type::LValueReference:
+    case Type::RValueReference:
+      T = cast<ReferenceType>(Ty)->getPointeeTypeAsWritten();
+      break;
+    default:
+      return false;
+    }
+  }
+}
+
 TypeSourceInfo *ASTContext::getTrivialTypeSourceInfo(QualType T,
                                                      SourceLocation L) const {
+  // Trivial type source information for the same simple type at the same
+  // location is always identical, so share it.
+  bool Shareable = hasOnlyLocationData(T);
+  std::pair<QualType, unsigned> Key(T, L.getRawEncoding());
+  if (Shareable) {
+    auto Known = SharedTrivialTypeSourceInfos.find(Key);
+    if (Known != SharedTrivialTypeSourceInfos.end()) {
+      ++NumSharedTypeSourceInfoUses;
+      return Known->second;
+    }
+  }
+
   TypeSourceInfo *DI = CreateTypeSourceInfo(T);
   DI->getTypeLoc().initialize(const_cast<ASTContext &>(*this), L);
+  if (Shareable)
+    SharedTrivialTypeSourceInfos[Key] = DI;
   return DI;
 }
 
@@ -2253,6 +2415,7 @@ ASTContext::getASTObjCImplementationLayout(
 
 QualType
 ASTContext::getExtQualType(const Type *baseType, Qualifiers quals) const {
+  TypeUniquingLock Lock(*this);
   unsigned fastQuals = quals.getFastQualifiers();
   quals.removeFastQualifiers();
 
@@ -2430,6 +2593,7 @@ void ASTContext::adjustExceptionSpec(
 /// getComplexType - Return the uniqued reference to the type for a complex
 /// number with the specified element type.
 QualType ASTContext::getComplexType(QualType T) const {
+  TypeUniquingLock Lock(*this);
   // Unique pointers, to guarantee there is only one pointer of a particular
   // structure.
   llvm::FoldingSetNodeID ID;
@@ -2458,6 +2622,7 @@ QualType ASTContext::getComplexType(QualType T) const {
 /// getPointerType - Return the uniqued reference to the type for a pointer to
 /// the specified type.
 QualType ASTContext::getPointerType(QualType T) const {
+  TypeUniquingLock Lock(*this);
   // Unique pointers, to guarantee there is only one pointer of a particular
   // structure.
   llvm::FoldingSetNodeID ID;
@@ -2484,6 +2649,7 @@ QualType ASTContext::getPointerType(QualType T) const {
 }
 
 QualType ASTContext::getAdjustedType(QualType Orig, QualType New) const {
+  TypeUniquingLock Lock(*this);
   llvm::FoldingSetNodeID ID;
   AdjustedType::Profile(ID, Orig, New);
   void *InsertPos = nullptr;
@@ -2505,6 +2671,7 @@ QualType ASTContext::getAdjustedType(QualType Orig, QualType New) const {
 }
 
 QualType ASTContext::getDecayedType(QualType T) const {
+  TypeUniquingLock Lock(*this);
   assert((T->isArrayType() || T->isFunctionType()) && "T does not decay");
 
   QualType Decayed;
@@ -2546,6 +2713,7 @@ QualType ASTContext::getDecayedType(QualType T) const {
 /// getBlockPointerType - Return the uniqued reference to the type for
 /// a pointer to the specified block.
 QualType ASTContext::getBlockPointerType(QualType T) const {
+  TypeUniquingLock Lock(*this);
   assert(T->isFunctionType() && "block of function types only");
   // Unique pointers, to guarantee there is only one block of a particular
   // structure.
@@ -2579,6 +2747,7 @@ QualType ASTContext::getBlockPointerType(QualType T) const {
 /// lvalue reference to the specified type.
 QualType
 ASTContext::getLValueReferenceType(QualType T, bool SpelledAsLValue) const {
+  TypeUniquingLock Lock(*this);
   assert(getCanonicalType(T) != OverloadTy && 
          "Unresolved overloaded function type");
   
@@ -2619,6 +2788,7 @@ ASTContext::getLValueReferenceType(QualType T, bool SpelledAsLValue) const {
 /// getRValueReferenceType - Return the uniqued reference to the type for an
 /// rvalue reference to the specified type.
 QualType ASTContext::getRValueReferenceType(QualType T) const {
+  TypeUniquingLock Lock(*this);
   // Unique pointers, to guarantee there is only one pointer of a particular
   // structure.
   llvm::FoldingSetNodeID ID;
@@ -2654,6 +2824,7 @@ QualType ASTContext::getRValueReferenceType(QualType T) const {
 /// getMemberPointerType - Return the uniqued reference to the type for a
 /// member pointer to the specified type, in the specified class.
 QualType ASTContext::getMemberPointerType(QualType T, const Type *Cls) const {
+  TypeUniquingLock Lock(*this);
   // Unique pointers, to guarantee there is only one pointer of a particular
   // structure.
   llvm::FoldingSetNodeID ID;
@@ -2688,6 +2859,7 @@ QualType ASTContext::getConstantArrayType(QualType EltTy,
                                           const llvm::APInt &ArySizeIn,
                                           ArrayType::ArraySizeModifier ASM,
                                           unsigned IndexTypeQuals) const {
+  TypeUniquingLock Lock(*this);
   assert((EltTy->isDependentType() ||
           EltTy->isIncompleteType() || EltTy->isConstantSizeType()) &&
          "Constant array of VLAs is illegal!");
@@ -2870,6 +3042,7 @@ QualType ASTContext::getVariableArrayType(QualType EltTy,
                                           ArrayType::ArraySizeModifier ASM,
                                           unsigned IndexTypeQuals,
                                           SourceRange Brackets) const {
+  TypeUniquingLock Lock(*this);
   // Since we don't unique expressions, it isn't possible to unique VLA's
   // that have an expression provided for their size.
   QualType Canon;
@@ -2898,6 +3071,7 @@ QualType ASTContext::getDependentSizedArrayType(QualType elementType,
                                                 ArrayType::ArraySizeModifier ASM,
                                                 unsigned elementTypeQuals,
                                                 SourceRange brackets) const {
+  TypeUniquingLock Lock(*this);
   assert((!numElements || numElements->isTypeDependent() || 
           numElements->isValueDependent()) &&
          "Size must be type- or value-dependent!");
@@ -2964,6 +3138,7 @@ QualType ASTContext::getDependentSizedArrayType(QualType elementType,
 QualType ASTContext::getIncompleteArrayType(QualType elementType,
                                             ArrayType::ArraySizeModifier ASM,
                                             unsigned elementTypeQuals) const {
+  TypeUniquingLock Lock(*this);
   llvm::FoldingSetNodeID ID;
   IncompleteArrayType::Profile(ID, elementType, ASM, elementTypeQuals);
 
@@ -3001,6 +3176,7 @@ QualType ASTContext::getIncompleteArrayType(QualType elementType,
 /// the specified element type and size. VectorType must be a built-in type.
 QualType ASTContext::getVectorType(QualType vecType, unsigned NumElts,
                                    VectorType::VectorKind VecKind) const {
+  TypeUniquingLock Lock(*this);
   assert(vecType->isBuiltinType());
 
   // Check if we've already instantiated a vector of this type.
@@ -3032,6 +3208,7 @@ QualType ASTContext::getVectorType(QualType vecType, unsigned NumElts,
 /// the specified element type and size. VectorType must be a built-in type.
 QualType
 ASTContext::getExtVectorType(QualType vecType, unsigned NumElts) const {
+  TypeUniquingLock Lock(*this);
   assert(vecType->isBuiltinType() || vecType->isDependentType());
 
   // Check if we've already instantiated a vector of this type.
@@ -3063,6 +3240,7 @@ QualType
 ASTContext::getDependentSizedExtVectorType(QualType vecType,
                                            Expr *SizeExpr,
                                            SourceLocation AttrLoc) const {
+  TypeUniquingLock Lock(*this);
   llvm::FoldingSetNodeID ID;
   DependentSizedExtVectorType::Profile(ID, *this, getCanonicalType(vecType),
                                        SizeExpr);
@@ -3113,6 +3291,7 @@ static bool isCanonicalResultType(QualType T) {
 QualType
 ASTContext::getFunctionNoProtoType(QualType ResultTy,
                                    const FunctionType::ExtInfo &Info) const {
+  TypeUniquingLock Lock(*this);
   // Unique functions, to guarantee there is only one function of a particular
   // structure.
   llvm::FoldingSetNodeID ID;
@@ -3193,6 +3372,7 @@ static bool isCanonicalExceptionSpecification(
 QualType ASTContext::getFunctionTypeInternal(
     QualType ResultTy, ArrayRef<QualType> ArgArray,
     const FunctionProtoType::ExtProtoInfo &EPI, bool OnlyWantCanonical) const {
+  TypeUniquingLock Lock(*this);
   size_t NumArgs = ArgArray.size();
 
   // Unique functions, to guarantee there is only one function of a particular
@@ -3358,6 +3538,7 @@ QualType ASTContext::getFunctionTypeInternal(
 }
 
 QualType ASTContext::getPipeType(QualType T, bool ReadOnly) const {
+  TypeUniquingLock Lock(*this);
   llvm::FoldingSetNodeID ID;
   PipeType::Profile(ID, T, ReadOnly);
 
@@ -3407,6 +3588,7 @@ static bool NeedsInjectedClassNameType(const RecordDecl *D) {
 /// injected class name type for the specified templated declaration.
 QualType ASTContext::getInjectedClassNameType(CXXRecordDecl *Decl,
                                               QualType TST) const {
+  TypeUniquingLock Lock(*this);
   assert(NeedsInjectedClassNameType(Decl));
   if (Decl->TypeForDecl) {
     assert(isa<InjectedClassNameType>(Decl->TypeForDecl));
@@ -3439,6 +3621,7 @@ QualType ASTContext::getInjectedParmType(Expr *E,
 /// getTypeDeclType - Return the unique reference to the type for the
 /// specified type declaration.
 QualType ASTContext::getTypeDeclTypeSlow(const TypeDecl *Decl) const {
+  TypeUniquingLock Lock(*this);
   assert(Decl && "Passed null for Decl param");
   assert(!Decl->TypeForDecl && "TypeForDecl present in slow case");
 
@@ -3471,6 +3654,7 @@ QualType ASTContext::getTypeDeclTypeSlow(const TypeDecl *Decl) const {
 QualType
 ASTContext::getTypedefType(const TypedefNameDecl *Decl,
                            QualType Canonical) const {
+  TypeUniquingLock Lock(*this);
   if (Decl->TypeForDecl) return QualType(Decl->TypeForDecl, 0);
 
   if (Canonical.isNull())
@@ -3483,6 +3667,7 @@ ASTContext::getTypedefType(const TypedefNameDecl *Decl,
 }
 
 QualType ASTContext::getRecordType(const RecordDecl *Decl) const {
+  TypeUniquingLock Lock(*this);
   if (Decl->TypeForDecl) return QualType(Decl->TypeForDecl, 0);
 
   if (const RecordDecl *PrevDecl = Decl->getPreviousDecl())
@@ -3496,6 +3681,7 @@ QualType ASTContext::getRecordType(const RecordDecl *Decl) const {
 }
 
 QualType ASTContext::getEnumType(const EnumDecl *Decl) const {
+  TypeUniquingLock Lock(*this);
   if (Decl->TypeForDecl) return QualType(Decl->TypeForDecl, 0);
 
   if (const EnumDecl *PrevDecl = Decl->getPreviousDecl())
@@ -3511,6 +3697,7 @@ QualType ASTContext::getEnumType(const EnumDecl *Decl) const {
 QualType ASTContext::getAttributedType(AttributedType::Kind attrKind,
                                        QualType modifiedType,
                                        QualType equivalentType) {
+  TypeUniquingLock Lock(*this);
   llvm::FoldingSetNodeID id;
   AttributedType::Profile(id, attrKind, modifiedType, equivalentType);
 
@@ -3532,6 +3719,7 @@ QualType ASTContext::getAttributedType(AttributedType::Kind attrKind,
 QualType
 ASTContext::getSubstTemplateTypeParmType(const TemplateTypeParmType *Parm,
                                          QualType Replacement) const {
+  TypeUniquingLock Lock(*this);
   assert(Replacement.isCanonical()
          && "replacement types must always be canonical");
 
@@ -3555,6 +3743,7 @@ ASTContext::getSubstTemplateTypeParmType(const TemplateTypeParmType *Parm,
 QualType ASTContext::getSubstTemplateTypeParmPackType(
                                           const TemplateTypeParmType *Parm,
                                               const TemplateArgument &ArgPack) {
+  TypeUniquingLock Lock(*this);
 #ifndef NDEBUG
   for (const auto &P : ArgPack.pack_elements()) {
     assert(P.getKind() == TemplateArgument::Type &&"Pack contains a non-type");
@@ -3591,6 +3780,7 @@ QualType ASTContext::getSubstTemplateTypeParmPackType(
 QualType ASTContext::getTemplateTypeParmType(unsigned Depth, unsigned Index,
                                              bool ParameterPack,
                                              TemplateTypeParmDecl *TTPDecl) const {
+  TypeUniquingLock Lock(*this);
   llvm::FoldingSetNodeID ID;
   TemplateTypeParmType::Profile(ID, Depth, Index, ParameterPack, TTPDecl);
   void *InsertPos = nullptr;
@@ -3668,6 +3858,7 @@ QualType
 ASTContext::getTemplateSpecializationType(TemplateName Template,
                                           ArrayRef<TemplateArgument> Args,
                                           QualType Underlying) const {
+  TypeUniquingLock Lock(*this);
   assert(!Template.getAsDependentTemplateName() && 
          "No dependent template names here!");
   // Look through qualified template names.
@@ -3706,6 +3897,7 @@ ASTContext::getTemplateSpecializationType(TemplateName Template,
 
 QualType ASTContext::getCanonicalTemplateSpecializationType(
     TemplateName Template, ArrayRef<TemplateArgument> Args) const {
+  TypeUniquingLock Lock(*this);
   assert(!Template.getAsDependentTemplateName() && 
          "No dependent template names here!");
 
@@ -3752,6 +3944,7 @@ QualType
 ASTContext::getElaboratedType(ElaboratedTypeKeyword Keyword,
                               NestedNameSpecifier *NNS,
                               QualType NamedType) const {
+  TypeUniquingLock Lock(*this);
   llvm::FoldingSetNodeID ID;
   ElaboratedType::Profile(ID, Keyword, NNS, NamedType);
 
@@ -3776,6 +3969,7 @@ ASTContext::getElaboratedType(ElaboratedTypeKeyword Keyword,
 
 QualType
 ASTContext::getParenType(QualType InnerType) const {
+  TypeUniquingLock Lock(*this);
   llvm::FoldingSetNodeID ID;
   ParenType::Profile(ID, InnerType);
 
@@ -3802,6 +3996,7 @@ QualType ASTContext::getDependentNameType(ElaboratedTypeKeyword Keyword,
                                           NestedNameSpecifier *NNS,
                                           const IdentifierInfo *Name,
                                           QualType Canon) const {
+  TypeUniquingLock Lock(*this);
   if (Canon.isNull()) {
     NestedNameSpecifier *CanonNNS = getCanonicalNestedNameSpecifier(NNS);
     if (CanonNNS != NNS)
@@ -3842,6 +4037,7 @@ ASTContext::getDependentTemplateSpecializationType(
                                  NestedNameSpecifier *NNS,
                                  const IdentifierInfo *Name,
                                  ArrayRef<TemplateArgument> Args) const {
+  TypeUniquingLock Lock(*this);
   assert((!NNS || NNS->isDependent()) && 
          "nested-name-specifier must be dependent");
 
@@ -3932,6 +4128,7 @@ ASTContext::getInjectedTemplateArgs(const TemplateParameterList *Params,
 
 QualType ASTContext::getPackExpansionType(QualType Pattern,
                                           Optional<unsigned> NumExpansions) {
+  TypeUniquingLock Lock(*this);
   llvm::FoldingSetNodeID ID;
   PackExpansionType::Profile(ID, Pattern, NumExpansions);
 
@@ -4012,6 +4209,7 @@ QualType ASTContext::getObjCObjectType(
            ArrayRef<QualType> typeArgs,
            ArrayRef<ObjCProtocolDecl *> protocols,
            bool isKindOf) const {
+  TypeUniquingLock Lock(*this);
   // If the base type is an interface and there aren't any protocols or
   // type arguments to add, then the interface type will do just fine.
   if (typeArgs.empty() && protocols.empty() && !isKindOf &&
@@ -4166,6 +4364,7 @@ QualType
 ASTContext::getObjCTypeParamType(const ObjCTypeParamDecl *Decl,
                            ArrayRef<ObjCProtocolDecl *> protocols,
                            QualType Canonical) const {
+  TypeUniquingLock Lock(*this);
   // Look in the folding set for an existing type.
   llvm::FoldingSetNodeID ID;
   ObjCTypeParamType::Profile(ID, Decl, protocols);
@@ -4266,6 +4465,7 @@ bool ASTContext::QIdProtocolsAdoptObjCObjectProtocols(QualType QT,
 /// getObjCObjectPointerType - Return a ObjCObjectPointerType type for
 /// the given object type.
 QualType ASTContext::getObjCObjectPointerType(QualType ObjectT) const {
+  TypeUniquingLock Lock(*this);
   llvm::FoldingSetNodeID ID;
   ObjCObjectPointerType::Profile(ID, ObjectT);
 
@@ -4297,6 +4497,7 @@ QualType ASTContext::getObjCObjectPointerType(QualType ObjectT) const {
 /// specified ObjC interface decl. The list of protocols is optional.
 QualType ASTContext::getObjCInterfaceType(const ObjCInterfaceDecl *Decl,
                                           ObjCInterfaceDecl *PrevDecl) const {
+  TypeUniquingLock Lock(*this);
   if (Decl->TypeForDecl)
     return QualType(Decl->TypeForDecl, 0);
 
@@ -4323,6 +4524,7 @@ QualType ASTContext::getObjCInterfaceType(const ObjCInterfaceDecl *Decl,
 /// DeclRefExpr's. This doesn't effect the type checker, since it operates
 /// on canonical type's (which are always unique).
 QualType ASTContext::getTypeOfExprType(Expr *tofExpr) const {
+  TypeUniquingLock Lock(*this);
   TypeOfExprType *toe;
   if (tofExpr->isTypeDependent()) {
     llvm::FoldingSetNodeID ID;
@@ -4357,6 +4559,7 @@ QualType ASTContext::getTypeOfExprType(Expr *tofExpr) const {
 /// an issue. This doesn't affect the type checker, since it operates
 /// on canonical types (which are always unique).
 QualType ASTContext::getTypeOfType(QualType tofType) const {
+  TypeUniquingLock Lock(*this);
   QualType Canonical = getCanonicalType(tofType);
   TypeOfType *tot = new (*this, TypeAlignment) TypeOfType(tofType, Canonical);
   Types.push_back(tot);
@@ -4368,6 +4571,7 @@ QualType ASTContext::getTypeOfType(QualType tofType) const {
 /// expression, and would not give a significant memory saving, since there
 /// is an Expr tree under each such type.
 QualType ASTContext::getDecltypeType(Expr *e, QualType UnderlyingType) const {
+  TypeUniquingLock Lock(*this);
   DecltypeType *dt;
 
   // C++11 [temp.type]p2:
@@ -4397,6 +4601,7 @@ QualType ASTContext::getDecltypeType(Expr *e, QualType UnderlyingType) const {
 }
 
 QualType ASTContext::getReflectedType(Expr *E, QualType T) const {
+  TypeUniquingLock Lock(*this);
   ReflectedType *RT;
 
   if (E->isInstantiationDependent()) {
@@ -4426,6 +4631,7 @@ QualType ASTContext::getUnaryTransformType(QualType BaseType,
                                            QualType UnderlyingType,
                                            UnaryTransformType::UTTKind Kind)
     const {
+  TypeUniquingLock Lock(*this);
   UnaryTransformType *ut = nullptr;
 
   if (BaseType->isDependentType()) {
@@ -4462,6 +4668,7 @@ QualType ASTContext::getUnaryTransformType(QualType BaseType,
 /// canonical deduced-but-dependent 'auto' type.
 QualType ASTContext::getAutoType(QualType DeducedType, AutoTypeKeyword Keyword,
                                  bool IsDependent) const {
+  TypeUniquingLock Lock(*this);
   if (DeducedType.isNull() && Keyword == AutoTypeKeyword::Auto && !IsDependent)
     return getAutoDeductType();
 
@@ -4486,6 +4693,7 @@ QualType ASTContext::getAutoType(QualType DeducedType, AutoTypeKeyword Keyword,
 /// such type, or the canonical deduced-but-dependent such type.
 QualType ASTContext::getDeducedTemplateSpecializationType(
     TemplateName Template, QualType DeducedType, bool IsDependent) const {
+  TypeUniquingLock Lock(*this);
   // Look in the folding set for an existing type.
   void *InsertPos = nullptr;
   llvm::FoldingSetNodeID ID;
@@ -4506,6 +4714,7 @@ QualType ASTContext::getDeducedTemplateSpecializationType(
 /// getAtomicType - Return the uniqued reference to the atomic type for
 /// the given value type.
 QualType ASTContext::getAtomicType(QualType T) const {
+  TypeUniquingLock Lock(*this);
   // Unique pointers, to guarantee there is only one pointer of a particular
   // structure.
   llvm::FoldingSetNodeID ID;
@@ -7013,6 +7222,7 @@ TemplateName
 ASTContext::getQualifiedTemplateName(NestedNameSpecifier *NNS,
                                      bool TemplateKeyword,
                                      TemplateDecl *Template) const {
+  TypeUniquingLock Lock(*this);
   assert(NNS && "Missing nested-name-specifier in qualified template name");
   
   // FIXME: Canonicalization?
@@ -7036,6 +7246,7 @@ ASTContext::getQualifiedTemplateName(NestedNameSpecifier *NNS,
 TemplateName
 ASTContext::getDependentTemplateName(NestedNameSpecifier *NNS,
                                      const IdentifierInfo *Name) const {
+  TypeUniquingLock Lock(*this);
   assert((!NNS || NNS->isDependent()) &&
          "Nested name specifier must be dependent");
 
@@ -7072,6 +7283,7 @@ ASTContext::getDependentTemplateName(NestedNameSpecifier *NNS,
 TemplateName 
 ASTContext::getDependentTemplateName(NestedNameSpecifier *NNS,
                                      OverloadedOperatorKind Operator) const {
+  TypeUniquingLock Lock(*this);
   assert((!NNS || NNS->isDependent()) &&
          "Nested name specifier must be dependent");
   
@@ -7107,6 +7319,7 @@ ASTContext::getDependentTemplateName(NestedNameSpecifier *NNS,
 TemplateName 
 ASTContext::getSubstTemplateTemplateParm(TemplateTemplateParmDecl *param,
                                          TemplateName replacement) const {
+  TypeUniquingLock Lock(*this);
   llvm::FoldingSetNodeID ID;
   SubstTemplateTemplateParmStorage::Profile(ID, param, replacement);
 
@@ -7125,6 +7338,7 @@ ASTContext::getSubstTemplateTemplateParm(TemplateTemplateParmDecl *param,
 TemplateName 
 ASTContext::getSubstTemplateTemplateParmPack(TemplateTemplateParmDecl *Param,
                                        const TemplateArgument &ArgPack) const {
+  TypeUniquingLock Lock(*this);
   ASTContext &Self = const_cast<ASTContext &>(*this);
   llvm::FoldingSetNodeID ID;
   SubstTemplateTemplateParmPackStorage::Profile(ID, Self, Param, ArgPack);
@@ -9214,7 +9428,8 @@ size_t ASTContext::getSideTableAllocatedMemory() const {
          llvm::capacity_in_bytes(OverriddenMethods) +
          llvm::capacity_in_bytes(Types) +
          llvm::capacity_in_bytes(VariableArrayTypes) +
-         llvm::capacity_in_bytes(ClassScopeSpecializationPattern);
+         llvm::capacity_in_bytes(ClassScopeSpecializationPattern) +
+         llvm::capacity_in_bytes(SharedTrivialTypeSourceInfos);
 }
 
 /// getIntTypeForBitwidth -
@@ -9343,6 +9558,13 @@ ASTContext::getMaterializedTemporaryValue(const MaterializeTemporaryExpr *E,
   return MaterializedTemporaryValues.lookup(E);
 }
 
+ConstexprCallCache &ASTContext::getConstexprCallCache() const {
+  if (!ConstexprCalls)
+    ConstexprCalls.reset(
+        new ConstexprCallCache(getLangOpts().ConstexprCacheLimit));
+  return *ConstexprCalls;
+}
+
 bool ASTContext::AtomicUsesUnsupportedLibcall(const AtomicExpr *E) const {
   const llvm::Triple &T = getTargetInfo().getTriple();
   if (!T.isOSDarwin())
@@ -1221,7 +1221,8 @@ bool ASTNodeImporter::IsStructuralMatch(RecordDecl *FromRecord,
   StructuralEquivalenceContext Ctx(Importer.getFromContext(),
                                    ToRecord->getASTContext(),
                                    Importer.getNonEquivalentDecls(),
-                                   false, Complain);
+                                   false, Complain,
+                                   &Importer.getEquivalentDecls());
   return Ctx.IsStructurallyEquivalent(FromRecord, ToRecord);
 }
 
@@ -1229,14 +1230,16 @@ bool ASTNodeImporter::IsStructuralMatch(VarDecl *FromVar, VarDecl *ToVar,
                                         bool Complain) {
   StructuralEquivalenceContext Ctx(
       Importer.getFromContext(), Importer.getToContext(),
-      Importer.getNonEquivalentDecls(), false, Complain);
+      Importer.getNonEquivalentDecls(), false, Complain,
+      &Importer.getEquivalentDecls());
   return Ctx.IsStructurallyEquivalent(FromVar, ToVar);
 }
 
 bool ASTNodeImporter::IsStructuralMatch(EnumDecl *FromEnum, EnumDecl *ToEnum) {
   StructuralEquivalenceContext Ctx(Importer.getFromContext(),
                                    Importer.getToContext(),
-                                   Importer.getNonEquivalentDecls());
+                                   Importer.getNonEquivalentDecls(), false,
+                                   true, &Importer.getEquivalentDecls());
   return Ctx.IsStructurallyEquivalent(FromEnum, ToEnum);
 }
 
@@ -1255,7 +1258,8 @@ bool ASTNodeImporter::IsStructuralMatch(ClassTemplateDecl *From,
                                         ClassTemplateDecl *To) {
   StructuralEquivalenceContext Ctx(Importer.getFromContext(),
                                    Importer.getToContext(),
-                                   Importer.getNonEquivalentDecls());
+                                   Importer.getNonEquivalentDecls(), false,
+                                   true, &Importer.getEquivalentDecls());
   return Ctx.IsStructurallyEquivalent(From, To);
 }
 
@@ -1263,7 +1267,8 @@ bool ASTNodeImporter::IsStructuralMatch(VarTemplateDecl *From,
                                         VarTemplateDecl *To) {
   StructuralEquivalenceContext Ctx(Importer.getFromContext(),
                                    Importer.getToContext(),
-                                   Importer.getNonEquivalentDecls());
+                                   Importer.getNonEquivalentDecls(), false,
+                                   true, &Importer.getEquivalentDecls());
   return Ctx.IsStructurallyEquivalent(From, To);
 }
 
@@ -2221,7 +2226,8 @@ Decl *ASTNodeImporter::VisitFriendDecl(FriendDecl *D) {
   FriendDecl *ImportedFriend = RD->getFirstFriend();
   StructuralEquivalenceContext Context(
       Importer.getFromContext(), Importer.getToContext(),
-      Importer.getNonEquivalentDecls(), false, false);
+      Importer.getNonEquivalentDecls(), false, false,
+      &Importer.getEquivalentDecls());
 
   while (ImportedFriend) {
     if (D->getFriendDecl() && ImportedFriend->getFriendDecl()) {
@@ -5577,7 +5583,8 @@ ASTImporter::ASTImporter(ASTContext &ToContext, FileManager &ToFileManager,
                          bool MinimalImport)
   : ToContext(ToContext), FromContext(FromContext),
     ToFileManager(ToFileManager), FromFileManager(FromFileManager),
-    Minimal(MinimalImport), LastDiagFromFrom(false)
+    Minimal(MinimalImport), LastDiagFromFrom(false),
+    SharedImportedFiles(nullptr)
 {
   ImportedDecls[FromContext.getTranslationUnitDecl()]
     = ToContext.getTranslationUnitDecl();
@@ -6010,13 +6017,26 @@ FileID ASTImporter::Import(FileID FromID) {
   SourceManager &ToSM = ToContext.getSourceManager();
   const SrcMgr::SLocEntry &FromSLoc = FromSM.getSLocEntry(FromID);
   assert(FromSLoc.isFile() && "Cannot handle macro expansions yet");
+  const SrcMgr::ContentCache *Cache = FromSLoc.getFile().getContentCache();
+
+  // Reuse the FileID of a file that has already been imported into the "to"
+  // context, possibly by another importer.
+  if (SharedImportedFiles && Cache->OrigEntry && Cache->OrigEntry->getDir()) {
+    if (const FileEntry *Entry =
+            ToFileManager.getFile(Cache->OrigEntry->getName())) {
+      ImportedFileMap::iterator Known = SharedImportedFiles->find(Entry);
+      if (Known != SharedImportedFiles->end()) {
+        ImportedFileIDs[FromID] = Known->second;
+        return Known->second;
+      }
+    }
+  }
   
   // Include location of this file.
   SourceLocation ToIncludeLoc = Import(FromSLoc.getFile().getIncludeLoc());
   
   // Map the FileID for to the "to" source manager.
   FileID ToID;
-  const SrcMgr::ContentCache *Cache = FromSLoc.getFile().getContentCache();
   if (Cache->OrigEntry && Cache->OrigEntry->getDir()) {
     // FIXME: We probably want to use getVirtualFile(), so we don't hit the
     // disk again
@@ -6027,6 +6047,8 @@ FileID ASTImporter::Import(FileID FromID) {
       return FileID();
     ToID = ToSM.createFileID(Entry, ToIncludeLoc, 
                              FromSLoc.getFile().getFileCharacteristic());
+    if (SharedImportedFiles)
+      (*SharedImportedFiles)[Entry] = ToID;
   } else {
     // FIXME: We want to re-use the existing MemoryBuffer!
     const llvm::MemoryBuffer *
@@ -6306,6 +6328,6 @@ bool ASTImporter::IsStructurallyEquivalent(QualType From, QualType To,
     return true;
 
   StructuralEquivalenceContext Ctx(FromContext, ToContext, NonEquivalentDecls,
-                                   false, Complain);
+                                   false, Complain, &EquivalentDecls);
   return Ctx.IsStructurallyEquivalent(From, To);
 }
@@ -861,8 +861,10 @@ static bool IsStructurallyEquivalent(StructuralEquivalenceContext &Context,
   // incomplete, we assume that they are equivalent.
   D1 = D1->getDefinition();
   D2 = D2->getDefinition();
-  if (!D1 || !D2)
+  if (!D1 || !D2) {
+    Context.AssumedIncompleteEquivalence = true;
     return true;
+  }
 
   if (CXXRecordDecl *D1CXX = dyn_cast<CXXRecordDecl>(D1)) {
     if (CXXRecordDecl *D2CXX = dyn_cast<CXXRecordDecl>(D2)) {
@@ -967,6 +969,10 @@ static bool IsStructurallyEquivalent(StructuralEquivalenceContext &Context,
 /// Determine structural equivalence of two enums.
 static bool IsStructurallyEquivalent(StructuralEquivalenceContext &Context,
                                      EnumDecl *D1, EnumDecl *D2) {
+  // An enum without a definition has no enumerators yet.
+  if (!D1->getDefinition() || !D2->getDefinition())
+    Context.AssumedIncompleteEquivalence = true;
+
   EnumDecl::enumerator_iterator EC2 = D2->enumerator_begin(),
                                 EC2End = D2->enumerator_end();
   for (EnumDecl::enumerator_iterator EC1 = D1->enumerator_begin(),
@@ -1126,14 +1132,18 @@ static bool IsStructurallyEquivalent(StructuralEquivalenceContext &Context,
 /// Determine structural equivalence of two declarations.
 static bool IsStructurallyEquivalent(StructuralEquivalenceContext &Context,
                                      Decl *D1, Decl *D2) {
-  // FIXME: Check for known structural equivalences via a callback of some sort.
+  std::pair<Decl *, Decl *> P(D1->getCanonicalDecl(), D2->getCanonicalDecl());
 
   // Check whether we already know that these two declarations are not
   // structurally equivalent.
-  if (Context.NonEquivalentDecls.count(
-          std::make_pair(D1->getCanonicalDecl(), D2->getCanonicalDecl())))
+  if (Context.NonEquivalentDecls.count(P))
     return false;
 
+  // Check whether an earlier check already proved them equivalent.
+  if (Context.EquivalentDecls && !Context.StrictTypeSpelling &&
+      Context.EquivalentDecls->count(P))
+    return true;
+
   // Determine whether we've already produced a tentative equivalence for D1.
   Decl *&EquivToD1 = Context.TentativeEquivalences[D1->getCanonicalDecl()];
   if (EquivToD1)
@@ -1324,11 +1334,22 @@ bool StructuralEquivalenceContext::Finish() {
       // know about it).
       NonEquivalentDecls.insert(
           std::make_pair(D1->getCanonicalDecl(), D2->getCanonicalDecl()));
+      FoundNonEquivalence = true;
       return true;
     }
     // FIXME: Check other declaration kinds!
   }
 
+  // Every tentative equivalence has now been verified, so remember them for
+  // later checks. If an earlier check in this context failed, some of them
+  // may have been assumed on behalf of the failing pair; don't trust those.
+  // Nor those that relied on a declaration without a definition, which may
+  // be given one that doesn't match later on.
+  if (EquivalentDecls && !StrictTypeSpelling && !FoundNonEquivalence &&
+      !AssumedIncompleteEquivalence)
+    for (const auto &Equiv : TentativeEquivalences)
+      EquivalentDecls->insert(Equiv);
+
   return false;
 }
 } // namespace clang
@@ -0,0 +1,147 @@
+//===--- ConstexprCallCache.cpp - Memoized constexpr calls ----------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the ConstexprCallCache class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "ConstexprCallCache.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/Support/ErrorHandling.h"
+
+using namespace clang;
+
+/// \brief The largest number of values a remembered result may consist of.
+static const unsigned MaxResultSize = 64;
+
+bool ConstexprCallCache::isMemoizableArgument(const APValue &Arg) {
+  return Arg.isInt() || Arg.isFloat();
+}
+
+/// \brief Determine whether \p Value has no pointers or references, counting
+/// its values against \p Budget.
+static bool isMemoizableValue(const APValue &Value, unsigned &Budget) {
+  if (!Budget)
+    return false;
+  --Budget;
+
+  switch (Value.getKind()) {
+  case APValue::Uninitialized:
+  case APValue::Int:
+  case APValue::Float:
+  case APValue::ComplexInt:
+  case APValue::ComplexFloat:
+    return true;
+
+  case APValue::LValue:
+  case APValue::MemberPointer:
+  case APValue::AddrLabelDiff:
+    return false;
+
+  case APValue::Vector:
+    for (unsigned I = 0, N = Value.getVectorLength(); I != N; ++I)
+      if (!isMemoizableValue(Value.getVectorElt(I), Budget))
+        return false;
+    return true;
+
+  case APValue::Array:
+    // Look at a packed array without unpacking it: it only holds integers or
+    // floating-point numbers.
+    if (Value.isPackedArray()) {
+      unsigned NumElts =
+          Value.getArrayInitializedElts() + Value.hasArrayFiller();
+      if (NumElts > Budget)
+        return false;
+      Budget -= NumElts;
+      return true;
+    }
+    for (unsigned I = 0, N = Value.getArrayInitializedElts(); I != N; ++I)
+      if (!isMemoizableValue(Value.getArrayInitializedElt(I), Budget))
+        return false;
+    return !Value.hasArrayFiller() ||
+           isMemoizableValue(Value.getArrayFiller(), Budget);
+
+  case APValue::Struct:
+    for (unsigned I = 0, N = Value.getStructNumBases(); I != N; ++I)
+      if (!isMemoizableValue(Value.getStructBase(I), Budget))
+        return false;
+    for (unsigned I = 0, N = Value.getStructNumFields(); I != N; ++I)
+      if (!isMemoizableValue(Value.getStructField(I), Budget))
+        return false;
+    return true;
+
+  case APValue::Union:
+    return isMemoizableValue(Value.getUnionValue(), Budget);
+  }
+  llvm_unreachable("unknown APValue kind");
+}
+
+bool ConstexprCallCache::isMemoizableResult(const APValue &Result) {
+  unsigned Budget = MaxResultSize;
+  return isMemoizableValue(Result, Budget);
+}
+
+unsigned ConstexprCallCache::hash(const FunctionDecl *Callee,
+                                  ArrayRef<APValue> Args) {
+  llvm::hash_code Hash = llvm::hash_value(Callee);
+  for (const APValue &Arg : Args) {
+    if (Arg.isInt())
+      Hash = llvm::hash_combine(Hash, Arg.getInt().isSigned(), Arg.getInt());
+    else
+      Hash = llvm::hash_combine(Hash, Arg.getFloat());
+  }
+  // Keep clear of the empty and tombstone keys of the bucket map.
+  return unsigned(size_t(Hash)) >> 1;
+}
+
+/// \brief Determine whether two memoizable arguments have the same value.
+static bool isSameArgument(const APValue &A, const APValue &B) {
+  if (A.getKind() != B.getKind())
+    return false;
+  if (A.isInt())
+    return A.getInt().getBitWidth() == B.getInt().getBitWidth() &&
+           A.getInt().isSigned() == B.getInt().isSigned() &&
+           A.getInt() == B.getInt();
+  // Distinguish between -0.0 and 0.0, and between NaNs.
+  return A.getFloat().bitwiseIsEqual(B.getFloat());
+}
+
+const ConstexprCallCache::CallResult *
+ConstexprCallCache::find(const FunctionDecl *Callee,
+                         ArrayRef<APValue> Args) const {
+  auto Bucket = Buckets.find(hash(Callee, Args));
+  if (Bucket == Buckets.end())
+    return nullptr;
+
+  for (unsigned Index : Bucket->second) {
+    const Entry &E = Entries[Index];
+    if (E.Callee != Callee || E.Args.size() != Args.size())
+      continue;
+    bool Same = true;
+    for (unsigned I = 0, N = Args.size(); Same && I != N; ++I)
+      Same = isSameArgument(E.Args[I], Args[I]);
+    if (Same)
+      return &E.Result;
+  }
+  return nullptr;
+}
+
+void ConstexprCallCache::insert(const FunctionDecl *Callee,
+                                ArrayRef<APValue> Args,
+                                const CallResult &Result) {
+  if (Entries.size() >= MaxEntries)
+    return;
+
+  Buckets[hash(Callee, Args)].push_back(Entries.size());
+  Entries.emplace_back();
+  Entry &E = Entries.back();
+  E.Callee = Callee;
+  E.Args.append(Args.begin(), Args.end());
+  E.Result = Result;
+}
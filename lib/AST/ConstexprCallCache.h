@@ -0,0 +1,94 @@
+//===--- ConstexprCallCache.h - Memoized constexpr calls --------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the ConstexprCallCache class, which remembers the results
+// of constexpr function calls for the rest of the translation unit.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_LIB_AST_CONSTEXPRCALLCACHE_H
+#define LLVM_CLANG_LIB_AST_CONSTEXPRCALLCACHE_H
+
+#include "clang/AST/APValue.h"
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include <deque>
+
+namespace clang {
+
+class FunctionDecl;
+
+/// \brief The results of constexpr function calls whose arguments are all
+/// integers or floating-point numbers, keyed by the callee and the values of
+/// the arguments.
+///
+/// The constant evaluator decides which calls can be memoized; this class
+/// only stores them, up to a fixed number of calls.
+class ConstexprCallCache {
+public:
+  /// \brief The outcome of a call, and the resources evaluating it took.
+  ///
+  /// Reusing the result charges those resources again, so that whether an
+  /// evaluation stays within its limits doesn't depend on what is cached.
+  struct CallResult {
+    APValue Value;
+
+    /// \brief The number of evaluation steps the call took.
+    unsigned Steps;
+
+    /// \brief The depth of the deepest call stack the call built, counting
+    /// the call itself.
+    unsigned Depth;
+  };
+
+private:
+  struct Entry {
+    const FunctionDecl *Callee;
+    SmallVector<APValue, 2> Args;
+    CallResult Result;
+  };
+
+  /// \brief The maximum number of calls to remember.
+  unsigned MaxEntries;
+
+  std::deque<Entry> Entries;
+
+  /// \brief The indices of the entries, by the hash of their callee and
+  /// arguments.
+  llvm::DenseMap<unsigned, SmallVector<unsigned, 1>> Buckets;
+
+  static unsigned hash(const FunctionDecl *Callee, ArrayRef<APValue> Args);
+
+public:
+  explicit ConstexprCallCache(unsigned MaxEntries) : MaxEntries(MaxEntries) {}
+
+  /// \brief Determine whether a call with the given argument can be keyed
+  /// by its value.
+  static bool isMemoizableArgument(const APValue &Arg);
+
+  /// \brief Determine whether the given result can be remembered: it has
+  /// no pointers or references, which might point into the evaluation that
+  /// produced it, and isn't too large.
+  static bool isMemoizableResult(const APValue &Result);
+
+  /// \brief Find the result of an earlier call to \p Callee with the given
+  /// arguments, if we remembered it.
+  const CallResult *find(const FunctionDecl *Callee,
+                         ArrayRef<APValue> Args) const;
+
+  /// \brief Remember the result of a call, unless the cache is full.
+  void insert(const FunctionDecl *Callee, ArrayRef<APValue> Args,
+              const CallResult &Result);
+};
+
+} // end namespace clang
+
+#endif // LLVM_CLANG_LIB_AST_CONSTEXPRCALLCACHE_H
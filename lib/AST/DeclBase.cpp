@@ -169,6 +169,15 @@ void Decl::PrintStats() {
   llvm::errs() << "Total bytes = " << totalBytes << "\n";
 }
 
+void Decl::getStatistics(
+    llvm::function_ref<void(StringRef Kind, unsigned Count, size_t Size)>
+        Callback) {
+#define DECL(DERIVED, BASE)                                             \
+  Callback(#DERIVED, n##DERIVED##s, sizeof(DERIVED##Decl));
+#define ABSTRACT_DECL(DECL)
+#include "clang/AST/DeclNodes.inc"
+}
+
 void Decl::add(Kind k) {
   switch (k) {
 #define DECL(DERIVED, BASE) case DERIVED: ++n##DERIVED##s; break;
@@ -1485,16 +1494,47 @@ StoredDeclsMap *DeclContext::buildLookup() {
 
   if (HasLazyExternalLexicalLookups) {
     HasLazyExternalLexicalLookups = false;
+
+    // If the lookup table already holds all of the local declarations, we
+    // only need to add the ones we load, rather than walking every
+    // declaration in every context again. They're spliced onto the front of
+    // each context's list of declarations.
+    bool OnlyAddLoadedDecls = LookupPtr && !HasLazyLocalLexicalLookups;
+    SmallVector<std::pair<DeclContext *, decl_range>, 2> LoadedDecls;
     for (auto *DC : Contexts) {
-      if (DC->hasExternalLexicalStorage())
-        HasLazyLocalLexicalLookups |=
-            DC->LoadLexicalDeclsFromExternalStorage();
+      if (!DC->hasExternalLexicalStorage())
+        continue;
+      Decl *OldFirstDecl = DC->FirstDecl;
+      if (!DC->LoadLexicalDeclsFromExternalStorage())
+        continue;
+      if (OnlyAddLoadedDecls)
+        LoadedDecls.push_back(std::make_pair(
+            DC, decl_range(decl_iterator(DC->FirstDecl),
+                           decl_iterator(OldFirstDecl))));
+      else
+        HasLazyLocalLexicalLookups = true;
     }
 
+    for (auto &Loaded : LoadedDecls)
+      buildLookupImpl(Loaded.first, Loaded.second,
+                      hasExternalVisibleStorage());
+
     if (!HasLazyLocalLexicalLookups)
       return LookupPtr;
   }
 
+  // If we're building the lookup table from scratch, size it for the
+  // declarations we're about to add rather than growing it as we go.
+  if (!LookupPtr) {
+    unsigned NumNamedDecls = 0;
+    for (auto *DC : Contexts)
+      for (Decl *D : DC->noload_decls())
+        if (isa<NamedDecl>(D))
+          ++NumNamedDecls;
+    if (NumNamedDecls)
+      CreateStoredDeclsMap(getParentASTContext())->reserve(NumNamedDecls);
+  }
+
   for (auto *DC : Contexts)
     buildLookupImpl(DC, hasExternalVisibleStorage());
 
@@ -1508,7 +1548,14 @@ StoredDeclsMap *DeclContext::buildLookup() {
 /// DeclContext, a DeclContext linked to it, or a transparent context
 /// nested within it.
 void DeclContext::buildLookupImpl(DeclContext *DCtx, bool Internal) {
-  for (Decl *D : DCtx->noload_decls()) {
+  buildLookupImpl(DCtx, DCtx->noload_decls(), Internal);
+}
+
+/// buildLookupImpl - Add the given declarations, which are contained within
+/// DCtx, to the lookup data structure.
+void DeclContext::buildLookupImpl(DeclContext *DCtx, decl_range Decls,
+                                  bool Internal) {
+  for (Decl *D : Decls) {
     // Insert this declaration into the lookup structure, but only if
     // it's semantically within its decl context. Any other decls which
     // should be found in this context are added eagerly.
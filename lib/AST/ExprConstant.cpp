@@ -33,6 +33,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "ConstexprCallCache.h"
 #include "clang/AST/APValue.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/ASTDiagnostic.h"
@@ -426,6 +427,9 @@ namespace {
     /// Index - The call index of this call.
     unsigned Index;
 
+    /// CallerMaxDepth - The caller's MaxCallStackDepth when this call began.
+    unsigned CallerMaxDepth;
+
     // FIXME: Adding this to every 'CallStackFrame' may have a nontrivial impact
     // on the overall stack usage of deeply-recursing constexpr evaluataions.
     // (We should cache this map rather than recomputing it repeatedly.)
@@ -549,6 +553,10 @@ namespace {
     /// CallStackDepth - The number of calls in the call stack right now.
     unsigned CallStackDepth;
 
+    /// MaxCallStackDepth - The largest CallStackDepth reached since the
+    /// current call began.
+    unsigned MaxCallStackDepth;
+
     /// NextCallIndex - The next call index to assign.
     unsigned NextCallIndex;
 
@@ -573,6 +581,11 @@ namespace {
     /// declaration whose initializer is being evaluated, if any.
     APValue *EvaluatingDeclValue;
 
+    /// EvaluatingDeclAccesses - The number of times the in-flight value of
+    /// EvaluatingDecl has been accessed. A call which accesses it depends on
+    /// more than its arguments, so its result can't be memoized.
+    unsigned EvaluatingDeclAccesses = 0;
+
     /// The current array initialization index, if we're performing array
     /// initialization.
     uint64_t ArrayInitIndex = -1;
@@ -655,7 +668,7 @@ namespace {
 
     EvalInfo(const ASTContext &C, Expr::EvalStatus &S, EvaluationMode Mode)
       : Ctx(const_cast<ASTContext &>(C)), EvalStatus(S), CurrentCall(nullptr),
-        CallStackDepth(0), NextCallIndex(1),
+        CallStackDepth(0), MaxCallStackDepth(0), NextCallIndex(1),
         StepsLeft(getLangOpts().ConstexprStepLimit),
         BottomFrame(*this, SourceLocation(), nullptr, nullptr, nullptr),
         EvaluatingDecl((const ValueDecl *)nullptr),
@@ -1090,14 +1103,16 @@ CallStackFrame::CallStackFrame(EvalInfo &Info, SourceLocation CallLoc,
                                const FunctionDecl *Callee, const LValue *This,
                                APValue *Arguments)
     : Info(Info), Caller(Info.CurrentCall), Callee(Callee), This(This),
-      Arguments(Arguments), CallLoc(CallLoc), Index(Info.NextCallIndex++) {
+      Arguments(Arguments), CallLoc(CallLoc), Index(Info.NextCallIndex++),
+      CallerMaxDepth(Info.MaxCallStackDepth) {
   Info.CurrentCall = this;
-  ++Info.CallStackDepth;
+  Info.MaxCallStackDepth = ++Info.CallStackDepth;
 }
 
 CallStackFrame::~CallStackFrame() {
   assert(Info.CurrentCall == this && "calls retired out of order");
   --Info.CallStackDepth;
+  Info.MaxCallStackDepth = std::max(Info.MaxCallStackDepth, CallerMaxDepth);
   Info.CurrentCall = Caller;
 }
 
@@ -1708,6 +1723,10 @@ static bool CheckConstantExpression(EvalInfo &Info, SourceLocation DiagLoc,
   // each subobject of its value shall have been initialized by a constant
   // expression.
   if (Value.isArray()) {
+    // A packed array only holds integers or floating-point numbers, which
+    // are always fine.
+    if (Value.isPackedArray())
+      return true;
     QualType EltTy = Type->castAsArrayTypeUnsafe()->getElementType();
     for (unsigned I = 0, N = Value.getArrayInitializedElts(); I != N; ++I) {
       if (!CheckConstantExpression(Info, DiagLoc, EltTy,
@@ -2360,6 +2379,7 @@ static bool evaluateVarDeclInit(EvalInfo &Info, const Expr *E,
   // in-flight value.
   if (Info.EvaluatingDecl.dyn_cast<const ValueDecl*>() == VD) {
     Result = Info.EvaluatingDeclValue;
+    ++Info.EvaluatingDeclAccesses;
     return true;
   }
 
@@ -2458,6 +2478,7 @@ static void expandStringLiteral(EvalInfo &Info, const Expr *Lit,
     Value = S->getCodeUnit(I);
     Result.getArrayInitializedElt(I) = APValue(Value);
   }
+  Result.packArray();
 }
 
 // Expand an array so that it has more than Index filled elements.
@@ -2647,6 +2668,22 @@ findSubobject(EvalInfo &Info, const Expr *E, const CompleteObject &Obj,
           return handler.foundString(*O, ObjType, Index);
       }
 
+      // The elements of a packed array have no APValue of their own: work on
+      // a copy of the element, and store it back if it might have changed.
+      if (O->isPackedArray()) {
+        assert(I == N - 1 && "extracting subobject of scalar?");
+        APValue Elt = O->getPackedArrayElt(Index);
+        if (!handler.found(Elt, ObjType))
+          return false;
+        if (handler.AccessKind != AK_Read &&
+            !O->setPackedArrayElt(Index, Elt)) {
+          if (O->getArrayInitializedElts() <= Index)
+            expandArray(*O, Index);
+          O->getArrayInitializedElt(Index).swap(Elt);
+        }
+        return true;
+      }
+
       if (O->getArrayInitializedElts() > Index)
         O = &O->getArrayInitializedElt(Index);
       else if (handler.AccessKind != AK_Read) {
@@ -3051,6 +3088,8 @@ static CompleteObject findCompleteObject(EvalInfo &Info, const Expr *E,
 
         BaseVal = Info.Ctx.getMaterializedTemporaryValue(MTE, false);
         assert(BaseVal && "got reference to unevaluated temporary");
+        if (VD && VD->getCanonicalDecl() == ED->getCanonicalDecl())
+          ++Info.EvaluatingDeclAccesses;
       } else {
         Info.FFDiag(E);
         return CompleteObject();
@@ -3078,6 +3117,7 @@ static CompleteObject findCompleteObject(EvalInfo &Info, const Expr *E,
   // and this doesn't do quite the right thing for const subobjects of the
   // object under construction.
   if (LVal.getLValueBase() == Info.EvaluatingDecl) {
+    ++Info.EvaluatingDeclAccesses;
     BaseType = Info.Ctx.getCanonicalType(BaseType);
     BaseType.removeLocalConst();
   }
@@ -4249,6 +4289,23 @@ static bool EvaluateArgs(ArrayRef<const Expr*> Args, ArgVector &ArgValues,
   return Success;
 }
 
+/// Determine whether the result of a call can be looked up in, and added to,
+/// the ASTContext's cache of constexpr calls. It must depend on nothing but
+/// the values of its arguments: it's not a member call, and doesn't construct
+/// its result in place, and all of its arguments are integers or
+/// floating-point numbers, not pointers into the current evaluation.
+static bool isMemoizableCall(EvalInfo &Info, const LValue *This,
+                             const LValue *ResultSlot,
+                             ArrayRef<APValue> ArgValues) {
+  if (This || ResultSlot || !Info.getLangOpts().ConstexprCacheLimit ||
+      Info.checkingPotentialConstantExpression())
+    return false;
+  for (const APValue &Arg : ArgValues)
+    if (!ConstexprCallCache::isMemoizableArgument(Arg))
+      return false;
+  return true;
+}
+
 /// Evaluate a function call.
 static bool HandleFunctionCall(SourceLocation CallLoc,
                                const FunctionDecl *Callee, const LValue *This,
@@ -4262,6 +4319,46 @@ static bool HandleFunctionCall(SourceLocation CallLoc,
   if (!Info.CheckCallLimit(CallLoc))
     return false;
 
+  // Reuse the result of an earlier evaluation of the same call, if we can,
+  // charging the steps and call depth it took, so that the outcome is the
+  // same as evaluating it again. Copy the arguments first: the callee is
+  // allowed to modify its parameters.
+  ConstexprCallCache *Cache = nullptr;
+  SmallVector<APValue, 4> CacheKey;
+  if (isMemoizableCall(Info, This, ResultSlot, ArgValues)) {
+    Cache = &Info.Ctx.getConstexprCallCache();
+    if (const ConstexprCallCache::CallResult *Known =
+            Cache->find(Callee, ArgValues)) {
+      if (Info.CallStackDepth + Known->Depth >
+          Info.getLangOpts().ConstexprCallDepth + 1) {
+        Info.FFDiag(CallLoc, diag::note_constexpr_depth_limit_exceeded)
+          << Info.getLangOpts().ConstexprCallDepth;
+        return false;
+      }
+      if (Known->Steps > Info.StepsLeft) {
+        Info.FFDiag(CallLoc, diag::note_constexpr_step_limit_exceeded);
+        return false;
+      }
+      Info.StepsLeft -= Known->Steps;
+      Info.MaxCallStackDepth = std::max(
+          Info.MaxCallStackDepth, Info.CallStackDepth + Known->Depth);
+      Result = Known->Value;
+      return true;
+    }
+    CacheKey.append(ArgValues.begin(), ArgValues.end());
+  }
+
+  // Only remember the result if we can tell that evaluating the call produced
+  // no diagnostics and had no side-effects. That requires the caller to be
+  // collecting notes.
+  bool CanRecord = Cache && Info.EvalStatus.Diag &&
+                   Info.EvalStatus.Diag->empty() &&
+                   !Info.EvalStatus.HasSideEffects &&
+                   !Info.EvalStatus.HasUndefinedBehavior;
+  unsigned OldEvaluatingDeclAccesses = Info.EvaluatingDeclAccesses;
+  unsigned OldStepsLeft = Info.StepsLeft;
+  unsigned OldCallStackDepth = Info.CallStackDepth;
+
   CallStackFrame Frame(Info, CallLoc, Callee, This, ArgValues.data());
 
   // For a trivial copy or move assignment, perform an APValue copy. This is
@@ -4300,7 +4397,21 @@ static bool HandleFunctionCall(SourceLocation CallLoc,
       return true;
     Info.FFDiag(Callee->getLocEnd(), diag::note_constexpr_no_return);
   }
-  return ESR == ESR_Returned;
+  if (ESR != ESR_Returned)
+    return false;
+
+  if (CanRecord && Info.EvalStatus.Diag->empty() &&
+      !Info.EvalStatus.HasSideEffects &&
+      !Info.EvalStatus.HasUndefinedBehavior &&
+      Info.EvaluatingDeclAccesses == OldEvaluatingDeclAccesses &&
+      ConstexprCallCache::isMemoizableResult(Result)) {
+    ConstexprCallCache::CallResult Known;
+    Known.Value = Result;
+    Known.Steps = OldStepsLeft - Info.StepsLeft;
+    Known.Depth = Info.MaxCallStackDepth - OldCallStackDepth;
+    Cache->insert(Callee, CacheKey, Known);
+  }
+  return true;
 }
 
 /// Evaluate a constructor call.
@@ -6869,7 +6980,10 @@ namespace {
       LValue Subobject = This;
       Subobject.addArray(Info, E, CAT);
       ImplicitValueInitExpr VIE(CAT->getElementType());
-      return EvaluateInPlace(Result.getArrayFiller(), Info, Subobject, &VIE);
+      if (!EvaluateInPlace(Result.getArrayFiller(), Info, Subobject, &VIE))
+        return false;
+      Result.packArray();
+      return true;
     }
 
     bool VisitCallExpr(const CallExpr *E) {
@@ -6949,14 +7063,17 @@ bool ArrayExprEvaluator::VisitInitListExpr(const InitListExpr *E) {
     }
   }
 
-  if (!Result.hasArrayFiller())
-    return Success;
+  // If we have a trivial filler, we can just evaluate it once and splat it
+  // over the rest of the array elements.
+  if (Result.hasArrayFiller()) {
+    assert(FillerExpr && "no array filler for incomplete init list");
+    if (!EvaluateInPlace(Result.getArrayFiller(), Info, Subobject, FillerExpr))
+      return false;
+  }
 
-  // If we get here, we have a trivial filler, which we can just evaluate
-  // once and splat over the rest of the array elements.
-  assert(FillerExpr && "no array filler for incomplete init list");
-  return EvaluateInPlace(Result.getArrayFiller(), Info, Subobject,
-                         FillerExpr) && Success;
+  // Nothing refers to the elements any more, so we can pack them.
+  Result.packArray();
+  return Success;
 }
 
 bool ArrayExprEvaluator::VisitArrayInitLoopExpr(const ArrayInitLoopExpr *E) {
@@ -6985,6 +7102,7 @@ bool ArrayExprEvaluator::VisitArrayInitLoopExpr(const ArrayInitLoopExpr *E) {
     }
   }
 
+  Result.packArray();
   return Success;
 }
 
@@ -27,6 +27,7 @@ using namespace clang;
 NestedNameSpecifier *
 NestedNameSpecifier::FindOrInsert(const ASTContext &Context,
                                   const NestedNameSpecifier &Mockup) {
+  ASTContext::TypeUniquingLock Lock(Context);
   llvm::FoldingSetNodeID ID;
   Mockup.Profile(ID);
 
@@ -111,6 +112,7 @@ NestedNameSpecifier::Create(const ASTContext &Context, IdentifierInfo *II) {
 
 NestedNameSpecifier *
 NestedNameSpecifier::GlobalSpecifier(const ASTContext &Context) {
+  ASTContext::TypeUniquingLock Lock(Context);
   if (!Context.GlobalNestedNameSpecifier)
     Context.GlobalNestedNameSpecifier =
         new (Context, alignof(NestedNameSpecifier)) NestedNameSpecifier();
@@ -84,6 +84,17 @@ void Stmt::PrintStats() {
   llvm::errs() << "Total bytes = " << sum << "\n";
 }
 
+void Stmt::getStatistics(
+    llvm::function_ref<void(StringRef Class, unsigned Count, size_t Size)>
+        Callback) {
+  // Ensure the table is primed.
+  getStmtInfoTableEntry(Stmt::NullStmtClass);
+
+  for (const StmtClassNameTable &Info : StmtClassInfo)
+    if (Info.Name)
+      Callback(Info.Name, Info.Counter, Info.Size);
+}
+
 void Stmt::addStmtClass(StmtClass s) {
   ++getStmtInfoTableEntry(s).Counter;
 }
@@ -15,7 +15,10 @@
 #include "clang/Basic/IdentifierTable.h"
 #include "clang/Basic/LangOptions.h"
 #include "clang/Basic/TargetInfo.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/StringRef.h"
+#include <memory>
+#include <mutex>
 using namespace clang;
 
 static const Builtin::Info BuiltinInfo[] = {
@@ -58,7 +61,7 @@ bool Builtin::Context::isBuiltinFunc(const char *Name) {
 }
 
 bool Builtin::Context::builtinIsSupported(const Builtin::Info &BuiltinInfo,
-                                          const LangOptions &LangOpts) {
+                                          const LangOptions &LangOpts) const {
   bool BuiltinsUnsupported =
       (LangOpts.NoBuiltin || LangOpts.isNoBuiltinFunc(BuiltinInfo.Name)) &&
       strchr(BuiltinInfo.Attributes, 'f');
@@ -75,26 +78,121 @@ bool Builtin::Context::builtinIsSupported(const Builtin::Info &BuiltinInfo,
          !GnuModeUnsupported && !MSModeUnsupported && !ObjCUnsupported;
 }
 
+typedef llvm::StringMap<llvm::SmallVector<unsigned, 1>> BuiltinNameIndex;
+
+/// \brief Retrieve the map from builtin name to the indices in \p Records of
+/// the records with that name.
+///
+/// The maps are built the first time a record table is seen and are never
+/// modified afterwards, so every Context in the process (including those on
+/// other threads) can share them without further locking. They hold every
+/// record, whatever the language options, since those differ between
+/// Contexts.
+static const BuiltinNameIndex &
+getBuiltinNameIndex(llvm::ArrayRef<Builtin::Info> Records) {
+  static std::mutex IndexMutex;
+  static llvm::DenseMap<const Builtin::Info *,
+                        std::unique_ptr<BuiltinNameIndex>> Indexes;
+
+  std::lock_guard<std::mutex> Lock(IndexMutex);
+  std::unique_ptr<BuiltinNameIndex> &Index = Indexes[Records.data()];
+  if (!Index) {
+    Index.reset(new BuiltinNameIndex(Records.size()));
+    for (unsigned i = 0, e = Records.size(); i != e; ++i)
+      (*Index)[Records[i].Name].push_back(i);
+  }
+  return *Index;
+}
+
+/// \brief Find the last of the records named \p Name in \p Index that
+/// \p IsSupported accepts.
+///
+/// When every builtin was registered up front, each supported record was
+/// registered in turn, so if a name appeared twice, the last supported
+/// record with that name won.
+static bool findLastSupported(const BuiltinNameIndex &Index, StringRef Name,
+                              llvm::function_ref<bool(unsigned)> IsSupported,
+                              unsigned &Result) {
+  auto I = Index.find(Name);
+  if (I == Index.end())
+    return false;
+  for (unsigned Idx : llvm::reverse(I->getValue())) {
+    if (IsSupported(Idx)) {
+      Result = Idx;
+      return true;
+    }
+  }
+  return false;
+}
+
 /// initializeBuiltins - Mark the identifiers for all the builtins with their
 /// appropriate builtin ID # and mark any non-portable builtin identifiers as
 /// such.
 void Builtin::Context::initializeBuiltins(IdentifierTable &Table,
                                           const LangOptions& LangOpts) {
-  // Step #1: mark all target-independent builtins with their ID's.
+  initializeLazyBuiltins(Table, LangOpts);
+
+  // Identifiers that already exist get their IDs now; the table asks us about
+  // the rest as they are created.
+  for (const auto &Entry : Table)
+    if (IdentifierInfo *II = Entry.getValue())
+      if (unsigned ID = lookupBuiltin(Entry.getKey()))
+        II->setBuiltinID(ID);
+}
+
+void Builtin::Context::initializeLazyBuiltins(IdentifierTable &Table,
+                                              const LangOptions &LangOpts) {
+  this->LangOpts = &LangOpts;
+  BuiltinIndex = &getBuiltinNameIndex(llvm::makeArrayRef(BuiltinInfo));
+  TSIndex = TSRecords.empty() ? nullptr : &getBuiltinNameIndex(TSRecords);
+  AuxTSIndex =
+      AuxTSRecords.empty() ? nullptr : &getBuiltinNameIndex(AuxTSRecords);
+  Table.setLazyBuiltins(this);
+}
+
+unsigned Builtin::Context::lookupBuiltin(llvm::StringRef Name) const {
+  if (!BuiltinIndex)
+    return 0;
+
+  // Builtins for the auxiliary target take precedence over target builtins,
+  // which take precedence over target-independent ones. The auxiliary
+  // target's builtins are always registered.
+  unsigned Idx;
+  if (AuxTSIndex &&
+      findLastSupported(*AuxTSIndex, Name,
+                        [](unsigned) { return true; }, Idx))
+    return Idx + Builtin::FirstTSBuiltin + TSRecords.size();
+
+  if (TSIndex &&
+      findLastSupported(*TSIndex, Name, [&](unsigned I) {
+        return builtinIsSupported(TSRecords[I], *LangOpts);
+      }, Idx))
+    return Idx + Builtin::FirstTSBuiltin;
+
+  if (findLastSupported(*BuiltinIndex, Name, [&](unsigned I) {
+        return I != Builtin::NotBuiltin &&
+               builtinIsSupported(BuiltinInfo[I], *LangOpts);
+      }, Idx))
+    return Idx;
+
+  return 0;
+}
+
+void Builtin::Context::forEachSupportedBuiltinName(
+    llvm::function_ref<void(llvm::StringRef)> Fn) const {
+  if (!LangOpts)
+    return;
+
   for (unsigned i = Builtin::NotBuiltin+1; i != Builtin::FirstTSBuiltin; ++i)
-    if (builtinIsSupported(BuiltinInfo[i], LangOpts)) {
-      Table.get(BuiltinInfo[i].Name).setBuiltinID(i);
-    }
+    if (builtinIsSupported(BuiltinInfo[i], *LangOpts))
+      Fn(BuiltinInfo[i].Name);
 
-  // Step #2: Register target-specific builtins.
   for (unsigned i = 0, e = TSRecords.size(); i != e; ++i)
-    if (builtinIsSupported(TSRecords[i], LangOpts))
-      Table.get(TSRecords[i].Name).setBuiltinID(i + Builtin::FirstTSBuiltin);
+    if (builtinIsSupported(TSRecords[i], *LangOpts))
+      Fn(TSRecords[i].Name);
 
-  // Step #3: Register target-specific builtins for AuxTarget.
   for (unsigned i = 0, e = AuxTSRecords.size(); i != e; ++i)
-    Table.get(AuxTSRecords[i].Name)
-        .setBuiltinID(i + Builtin::FirstTSBuiltin + TSRecords.size());
+    Fn(AuxTSRecords[i].Name);
 }
 
 void Builtin::Context::forgetBuiltin(unsigned ID, IdentifierTable &Table) {
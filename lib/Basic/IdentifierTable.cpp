@@ -12,6 +12,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "clang/Basic/Builtins.h"
 #include "clang/Basic/CharInfo.h"
 #include "clang/Basic/IdentifierTable.h"
 #include "clang/Basic/LangOptions.h"
@@ -86,6 +87,11 @@ IdentifierTable::IdentifierTable(const LangOptions &LangOpts,
   get("import").setModulesImport(true);
 }
 
+void IdentifierTable::initializeLazyBuiltin(IdentifierInfo &II) {
+  if (unsigned ID = LazyBuiltins->lookupBuiltin(II.getName()))
+    II.setBuiltinID(ID);
+}
+
 //===----------------------------------------------------------------------===//
 // Language Keyword Implementation
 //===----------------------------------------------------------------------===//
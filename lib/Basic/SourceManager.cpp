@@ -20,6 +20,7 @@
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/Support/Capacity.h"
 #include "llvm/Support/Compiler.h"
+#include "llvm/Support/MathExtras.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/raw_ostream.h"
@@ -362,7 +363,10 @@ SourceManager::SourceManager(DiagnosticsEngine &Diag, FileManager &FileMgr,
   : Diag(Diag), FileMgr(FileMgr), OverridenFilesKeepOriginalName(true),
     UserFilesAreVolatile(UserFilesAreVolatile), FilesAreTransient(false),
     ExternalSLocEntries(nullptr), LineTable(nullptr), NumLinearScans(0),
-    NumBinaryProbes(0) {
+    NumBinaryProbes(0), NumFileIDCacheHits(0), NumIndexedLookups(0),
+    NumMacroExpansionEntries(0),
+    NumMacroArgExpansionEntries(0), MacroExpansionSLocBytes(0),
+    MacroArgExpansionSLocBytes(0) {
   clearIDTables();
   Diag.setSourceManager(this);
 }
@@ -396,6 +400,7 @@ void SourceManager::clearIDTables() {
   LastLineNoFileIDQuery = FileID();
   LastLineNoContentCache = nullptr;
   LastFileIDLookup = FileID();
+  clearFileIDLookupCaches();
 
   if (LineTable)
     LineTable->clear();
@@ -623,6 +628,13 @@ SourceManager::createExpansionLocImpl(const ExpansionInfo &Info,
   assert(NextLocalOffset + TokLength + 1 > NextLocalOffset &&
          NextLocalOffset + TokLength + 1 <= CurrentLoadedOffset &&
          "Ran out of source locations!");
+  if (Info.isMacroArgExpansion()) {
+    ++NumMacroArgExpansionEntries;
+    MacroArgExpansionSLocBytes += TokLength + 1;
+  } else {
+    ++NumMacroExpansionEntries;
+    MacroExpansionSLocBytes += TokLength + 1;
+  }
   // See createFileID for that +1.
   NextLocalOffset += TokLength + 1;
   return SourceLocation::getMacroLoc(NextLocalOffset - (TokLength + 1));
@@ -709,11 +721,92 @@ FileID SourceManager::getFileIDSlow(unsigned SLocOffset) const {
   if (!SLocOffset)
     return FileID::get(0);
 
+  // Check the FileIDs we found recently before searching the tables.
+  for (FileID Cached : FileIDLookupCache) {
+    if (!Cached.isInvalid() && isOffsetInFileID(Cached, SLocOffset)) {
+      ++NumFileIDCacheHits;
+      return Cached;
+    }
+  }
+
   // Now it is time to search for the correct file. See where the SLocOffset
   // sits in the global view and consult local or loaded buffers for it.
+  FileID Res;
   if (SLocOffset < NextLocalOffset)
-    return getFileIDLocal(SLocOffset);
-  return getFileIDLoaded(SLocOffset);
+    Res = getFileIDLocal(SLocOffset);
+  else
+    Res = getFileIDLoaded(SLocOffset);
+
+  if (!Res.isInvalid()) {
+    FileIDLookupCache[NextFileIDLookupCacheSlot] = Res;
+    NextFileIDLookupCacheSlot =
+        (NextFileIDLookupCacheSlot + 1) % FileIDLookupCacheSize;
+  }
+  return Res;
+}
+
+void SourceManager::clearFileIDLookupCaches() {
+  for (FileID &Cached : FileIDLookupCache)
+    Cached = FileID();
+  NextFileIDLookupCacheSlot = 0;
+  LocalSLocOffsetIndex.clear();
+  NumIndexedLocalSLocEntries = 0;
+}
+
+void SourceManager::buildLocalSLocOffsetIndex() const {
+  NumIndexedLocalSLocEntries = LocalSLocEntryTable.size();
+  unsigned N = NumIndexedLocalSLocEntries + 1;
+  LocalSLocOffsetIndex.resize(N);
+
+  // Walk the implicit tree (children of node K are 2K and 2K+1) in order,
+  // assigning the sorted offsets to the nodes as they are visited.
+  unsigned K = 1;
+  while (2 * K < N)
+    K = 2 * K;
+  for (unsigned Next = 0; K != 0; ++Next) {
+    LocalSLocOffsetIndex[K].Offset = LocalSLocEntryTable[Next].getOffset();
+    LocalSLocOffsetIndex[K].Index = Next;
+    if (2 * K + 1 < N) {
+      // Descend to the leftmost node of the right subtree.
+      K = 2 * K + 1;
+      while (2 * K < N)
+        K = 2 * K;
+    } else {
+      // Climb past the right children to the next ancestor in order.
+      while (K & 1)
+        K >>= 1;
+      K >>= 1;
+    }
+  }
+}
+
+FileID SourceManager::getFileIDLocalIndexed(unsigned SLocOffset) const {
+  // Rebuild the index once the table has doubled since the last build, so
+  // that the cost of building it is amortized over the entries added.
+  if (LocalSLocEntryTable.size() >= 2 * NumIndexedLocalSLocEntries)
+    buildLocalSLocOffsetIndex();
+
+  // Offsets past the indexed prefix are left to the ordinary search.
+  if (NumIndexedLocalSLocEntries < LocalSLocEntryTable.size() &&
+      LocalSLocEntryTable[NumIndexedLocalSLocEntries].getOffset() <=
+          SLocOffset)
+    return FileID();
+
+  // Find the first indexed entry whose offset is greater than SLocOffset; the
+  // entry before it contains the offset.  Descending the implicit tree
+  // encodes the path in K, and the last right turn identifies the answer.
+  unsigned K = 1;
+  unsigned N = LocalSLocOffsetIndex.size();
+  while (K < N)
+    K = 2 * K + (LocalSLocOffsetIndex[K].Offset <= SLocOffset);
+  K >>= llvm::countTrailingOnes(K) + 1;
+
+  ++NumIndexedLookups;
+  // If every indexed entry starts at or before SLocOffset, it is in the last
+  // one.
+  if (K == 0)
+    return FileID::get(NumIndexedLocalSLocEntries - 1);
+  return FileID::get(LocalSLocOffsetIndex[K].Index - 1);
 }
 
 /// \brief Return the FileID for a SourceLocation with a low offset.
@@ -764,13 +857,21 @@ FileID SourceManager::getFileIDLocal(unsigned SLocOffset) const {
       break;
   }
 
+  // Try the interval index before falling back to the binary search.
+  FileID Indexed = getFileIDLocalIndexed(SLocOffset);
+  if (!Indexed.isInvalid()) {
+    if (!LocalSLocEntryTable[Indexed.ID].isExpansion())
+      LastFileIDLookup = Indexed;
+    return Indexed;
+  }
+
   // Convert "I" back into an index.  We know that it is an entry whose index is
   // larger than the offset we are looking for.
   unsigned GreaterIndex = I - LocalSLocEntryTable.begin();
   // LessIndex - This is the lower bound of the range that we're searching.
   // We know that the offset corresponding to the FileID is is less than
-  // SLocOffset.
-  unsigned LessIndex = 0;
+  // SLocOffset, and that it lies past the prefix covered by the index.
+  unsigned LessIndex = NumIndexedLocalSLocEntries;
   NumProbes = 0;
   while (1) {
     bool Invalid = false;
@@ -2157,8 +2258,14 @@ void SourceManager::PrintStats() const {
   llvm::errs() << NumFileBytesMapped << " bytes of files mapped, "
                << NumLineNumsComputed << " files with line #'s computed, "
                << NumMacroArgsComputed << " files with macro args computed.\n";
+  llvm::errs() << NumMacroExpansionEntries << " macro expansion SLocEntries ("
+               << MacroExpansionSLocBytes << "B of Sloc address space), "
+               << NumMacroArgExpansionEntries
+               << " macro argument expansion SLocEntries ("
+               << MacroArgExpansionSLocBytes << "B of Sloc address space).\n";
   llvm::errs() << "FileID scans: " << NumLinearScans << " linear, "
-               << NumBinaryProbes << " binary.\n";
+               << NumBinaryProbes << " binary, " << NumIndexedLookups
+               << " indexed, " << NumFileIDCacheHits << " cache hits.\n";
 }
 
 LLVM_DUMP_METHOD void SourceManager::dump() const {
@@ -18,12 +18,16 @@
 #include "llvm/ADT/iterator_range.h"
 #include "llvm/Config/llvm-config.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/Endian.h"
 #include "llvm/Support/Errc.h"
+#include "llvm/Support/MathExtras.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Process.h"
 #include "llvm/Support/YAMLParser.h"
 #include <atomic>
+#include <cstring>
+#include <map>
 #include <memory>
 #include <utility>
 
@@ -1882,3 +1886,611 @@ recursive_directory_iterator::increment(std::error_code &EC) {
 
   return *this;
 }
+
+//===-----------------------------------------------------------------------===/
+// ArchiveFileSystem implementation
+//===-----------------------------------------------------------------------===/
+
+namespace {
+
+/// The on-disk layout of an archive. All integers are little-endian.
+///
+///   Header:  Magic[8], Version (u32), NumEntries (u32),
+///            StringTableOffset (u64), StringTableSize (u64)
+///   Entries: NumEntries records of EntrySize bytes, sorted by path:
+///            PathOffset (u32), PathLength (u32), ContentOffset (u64),
+///            Size (u64), MTime (u64, seconds since the epoch),
+///            Type (u32, 0 = directory, 1 = file), Perms (u32)
+///   Strings: the paths, concatenated
+///   Content: each file at a page-aligned offset, followed by a null byte
+namespace archive {
+const char Magic[8] = {'C', 'L', 'V', 'F', 'S', 'A', 'R', 'C'};
+const uint32_t Version = 1;
+const uint64_t HeaderSize = 32;
+const uint64_t EntrySize = 40;
+const uint64_t ContentAlignment = 4096;
+enum EntryType : uint32_t { ET_Directory = 0, ET_File = 1 };
+} // end namespace archive
+
+/// Remove the trailing separators of \p Path, other than those of its root
+/// directory. The archive stores paths in this form.
+static void removeTrailingSeparators(SmallVectorImpl<char> &Path) {
+  size_t RootSize =
+      llvm::sys::path::root_path(StringRef(Path.data(), Path.size())).size();
+  while (Path.size() > RootSize && llvm::sys::path::is_separator(Path.back()))
+    Path.pop_back();
+}
+
+/// A decoded entry of the archive's entry table.
+struct ArchiveEntry {
+  StringRef Path;
+  uint64_t ContentOffset;
+  uint64_t Size;
+  uint64_t MTime;
+  archive::EntryType Type;
+  uint32_t Perms;
+};
+
+class ArchiveFileSystem : public FileSystem {
+  std::unique_ptr<MemoryBuffer> Archive;
+  const char *Entries = nullptr;
+  uint32_t NumEntries = 0;
+  StringRef Strings;
+  /// Unique IDs of the entries, so that status() is stable across calls.
+  std::vector<UniqueID> UIDs;
+  std::string WorkingDirectory = "/";
+
+  static uint32_t read32(const char *P) {
+    return support::endian::read32le(P);
+  }
+  static uint64_t read64(const char *P) {
+    return support::endian::read64le(P);
+  }
+
+  ArchiveEntry getEntry(uint32_t I) const {
+    const char *P = Entries + I * archive::EntrySize;
+    ArchiveEntry E;
+    E.Path = Strings.substr(read32(P), read32(P + 4));
+    E.ContentOffset = read64(P + 8);
+    E.Size = read64(P + 16);
+    E.MTime = read64(P + 24);
+    E.Type = static_cast<archive::EntryType>(read32(P + 32));
+    E.Perms = read32(P + 36);
+    return E;
+  }
+
+  /// Find the first entry whose path is not less than \p Path.
+  uint32_t lowerBound(StringRef Path) const {
+    uint32_t Lo = 0, Hi = NumEntries;
+    while (Lo < Hi) {
+      uint32_t Mid = Lo + (Hi - Lo) / 2;
+      if (getEntry(Mid).Path < Path)
+        Lo = Mid + 1;
+      else
+        Hi = Mid;
+    }
+    return Lo;
+  }
+
+  std::error_code normalize(const Twine &P, SmallVectorImpl<char> &Path) const {
+    P.toVector(Path);
+    if (std::error_code EC = makeAbsolute(Path))
+      return EC;
+    llvm::sys::path::remove_dots(Path, /*remove_dot_dot=*/true);
+    removeTrailingSeparators(Path);
+    return std::error_code();
+  }
+
+public:
+  explicit ArchiveFileSystem(std::unique_ptr<MemoryBuffer> Archive)
+      : Archive(std::move(Archive)) {}
+
+  /// Validate the archive and decode its header.
+  bool initialize();
+
+  ErrorOr<uint32_t> lookup(const Twine &P) const;
+  Status getStatus(uint32_t I) const;
+  StringRef getContents(const ArchiveEntry &E) const {
+    return Archive->getBuffer().substr(E.ContentOffset, E.Size);
+  }
+  uint32_t getNumEntries() const { return NumEntries; }
+  ArchiveEntry entry(uint32_t I) const { return getEntry(I); }
+
+  ErrorOr<Status> status(const Twine &Path) override;
+  ErrorOr<std::unique_ptr<File>> openFileForRead(const Twine &Path) override;
+  directory_iterator dir_begin(const Twine &Dir, std::error_code &EC) override;
+  ErrorOr<std::string> getCurrentWorkingDirectory() const override {
+    return WorkingDirectory;
+  }
+  std::error_code setCurrentWorkingDirectory(const Twine &Path) override;
+};
+
+/// A buffer pointing into the archive. It keeps the file system, and thus the
+/// archive mapping, alive for as long as the buffer is in use.
+class ArchiveMemoryBuffer : public MemoryBuffer {
+  IntrusiveRefCntPtr<ArchiveFileSystem> FS;
+  std::string Name;
+
+public:
+  ArchiveMemoryBuffer(IntrusiveRefCntPtr<ArchiveFileSystem> FS,
+                      StringRef Contents, StringRef Name)
+      : FS(std::move(FS)), Name(Name) {
+    // The archive stores a null byte after the contents of every file.
+    init(Contents.begin(), Contents.end(), /*RequiresNullTerminator=*/true);
+  }
+
+  StringRef getBufferIdentifier() const override { return Name; }
+  BufferKind getBufferKind() const override { return MemoryBuffer_MMap; }
+};
+
+class ArchiveFileHandle : public File {
+  IntrusiveRefCntPtr<ArchiveFileSystem> FS;
+  uint32_t Index;
+  Status S;
+
+public:
+  ArchiveFileHandle(IntrusiveRefCntPtr<ArchiveFileSystem> FS, uint32_t Index)
+      : FS(std::move(FS)), Index(Index), S(this->FS->getStatus(Index)) {}
+
+  ErrorOr<Status> status() override { return S; }
+  ErrorOr<std::unique_ptr<MemoryBuffer>>
+  getBuffer(const Twine &Name, int64_t FileSize, bool RequiresNullTerminator,
+            bool IsVolatile) override {
+    return std::unique_ptr<MemoryBuffer>(new ArchiveMemoryBuffer(
+        FS, FS->getContents(FS->entry(Index)), Name.str()));
+  }
+  std::error_code close() override { return std::error_code(); }
+};
+
+/// Iterates over the direct children of a directory. They are among the
+/// entries following it in path order that start with its path, and are the
+/// ones whose parent path is the directory's.
+class ArchiveDirIterImpl : public clang::vfs::detail::DirIterImpl {
+  ArchiveFileSystem *FS = nullptr;
+  std::string DirPath;
+  uint32_t Current = 0;
+
+  std::error_code advance() {
+    for (uint32_t E = FS->getNumEntries(); Current != E; ++Current) {
+      StringRef Path = FS->entry(Current).Path;
+      if (!Path.startswith(DirPath))
+        break;
+      if (llvm::sys::path::parent_path(Path) == DirPath) {
+        CurrentEntry = FS->getStatus(Current);
+        return std::error_code();
+      }
+    }
+    // Reached the end of the directory.
+    Current = FS->getNumEntries();
+    CurrentEntry = Status();
+    return std::error_code();
+  }
+
+public:
+  ArchiveDirIterImpl() {}
+  ArchiveDirIterImpl(ArchiveFileSystem &FS, uint32_t DirIndex)
+      : FS(&FS), DirPath(FS.entry(DirIndex).Path), Current(DirIndex + 1) {
+    advance();
+  }
+
+  std::error_code increment() override {
+    ++Current;
+    return advance();
+  }
+};
+
+} // end anonymous namespace
+
+bool ArchiveFileSystem::initialize() {
+  StringRef Data = Archive->getBuffer();
+  if (Data.size() < archive::HeaderSize ||
+      memcmp(Data.data(), archive::Magic, sizeof(archive::Magic)) != 0 ||
+      read32(Data.data() + 8) != archive::Version)
+    return false;
+
+  NumEntries = read32(Data.data() + 12);
+  uint64_t StringTableOffset = read64(Data.data() + 16);
+  uint64_t StringTableSize = read64(Data.data() + 24);
+  if (archive::HeaderSize + uint64_t(NumEntries) * archive::EntrySize >
+          StringTableOffset ||
+      StringTableOffset > Data.size() ||
+      StringTableSize > Data.size() - StringTableOffset)
+    return false;
+
+  Entries = Data.data() + archive::HeaderSize;
+  Strings = Data.substr(StringTableOffset, StringTableSize);
+
+  // Check every entry up front so that lookups can trust the table.
+  StringRef PrevPath;
+  for (uint32_t I = 0; I != NumEntries; ++I) {
+    const char *P = Entries + I * archive::EntrySize;
+    uint64_t PathOffset = read32(P), PathLength = read32(P + 4);
+    if (PathOffset + PathLength > Strings.size())
+      return false;
+    ArchiveEntry E = getEntry(I);
+    if (E.Type != archive::ET_Directory && E.Type != archive::ET_File)
+      return false;
+    if (E.Type == archive::ET_File &&
+        (E.ContentOffset > Data.size() ||
+         E.Size >= Data.size() - E.ContentOffset ||
+         Data[E.ContentOffset + E.Size] != '\0'))
+      return false;
+    if (I != 0 && !(PrevPath < E.Path))
+      return false;
+    PrevPath = E.Path;
+  }
+
+  UIDs.reserve(NumEntries);
+  for (uint32_t I = 0; I != NumEntries; ++I)
+    UIDs.push_back(getNextVirtualUniqueID());
+  return true;
+}
+
+ErrorOr<uint32_t> ArchiveFileSystem::lookup(const Twine &P) const {
+  SmallString<128> Path;
+  if (std::error_code EC = normalize(P, Path))
+    return EC;
+  uint32_t I = lowerBound(Path);
+  if (I == NumEntries || getEntry(I).Path != Path)
+    return make_error_code(llvm::errc::no_such_file_or_directory);
+  return I;
+}
+
+Status ArchiveFileSystem::getStatus(uint32_t I) const {
+  ArchiveEntry E = getEntry(I);
+  return Status(E.Path, UIDs[I],
+                llvm::sys::toTimePoint(static_cast<time_t>(E.MTime)), 0, 0,
+                E.Type == archive::ET_File ? E.Size : 0,
+                E.Type == archive::ET_File ? file_type::regular_file
+                                           : file_type::directory_file,
+                static_cast<perms>(E.Perms));
+}
+
+ErrorOr<Status> ArchiveFileSystem::status(const Twine &Path) {
+  ErrorOr<uint32_t> I = lookup(Path);
+  if (!I)
+    return I.getError();
+  return getStatus(*I);
+}
+
+ErrorOr<std::unique_ptr<File>>
+ArchiveFileSystem::openFileForRead(const Twine &Path) {
+  ErrorOr<uint32_t> I = lookup(Path);
+  if (!I)
+    return I.getError();
+  if (getEntry(*I).Type != archive::ET_File)
+    return make_error_code(llvm::errc::invalid_argument);
+  return std::unique_ptr<File>(new ArchiveFileHandle(this, *I));
+}
+
+directory_iterator ArchiveFileSystem::dir_begin(const Twine &Dir,
+                                                std::error_code &EC) {
+  ErrorOr<uint32_t> I = lookup(Dir);
+  if (!I) {
+    EC = I.getError();
+    return directory_iterator(std::make_shared<ArchiveDirIterImpl>());
+  }
+  if (getEntry(*I).Type != archive::ET_Directory) {
+    EC = make_error_code(llvm::errc::not_a_directory);
+    return directory_iterator(std::make_shared<ArchiveDirIterImpl>());
+  }
+  return directory_iterator(
+      std::make_shared<ArchiveDirIterImpl>(*this, *I));
+}
+
+std::error_code ArchiveFileSystem::setCurrentWorkingDirectory(const Twine &P) {
+  SmallString<128> Path;
+  if (std::error_code EC = normalize(P, Path))
+    return EC;
+  WorkingDirectory = Path.str();
+  return std::error_code();
+}
+
+bool vfs::isVFSArchive(StringRef Buffer) {
+  return Buffer.startswith(StringRef(archive::Magic, sizeof(archive::Magic)));
+}
+
+IntrusiveRefCntPtr<FileSystem>
+vfs::getVFSFromArchive(std::unique_ptr<MemoryBuffer> Buffer) {
+  IntrusiveRefCntPtr<ArchiveFileSystem> FS(
+      new ArchiveFileSystem(std::move(Buffer)));
+  if (!FS->initialize())
+    return nullptr;
+  return FS;
+}
+
+ArchiveVFSWriter::ArchiveVFSWriter() {}
+
+ArchiveVFSWriter::~ArchiveVFSWriter() {}
+
+void ArchiveVFSWriter::addFile(StringRef VirtualPath,
+                               std::unique_ptr<MemoryBuffer> Buffer,
+                               sys::TimePoint<> MTime) {
+  assert(sys::path::is_absolute(VirtualPath) &&
+         "archive paths must be absolute");
+  Files.push_back({VirtualPath.str(), std::move(Buffer), MTime});
+}
+
+void ArchiveVFSWriter::write(llvm::raw_ostream &OS) {
+  // Collect the files and their parent directories, sorted by path. Later
+  // additions of the same path win.
+  std::map<std::string, const ArchiveFile *> Nodes;
+  Nodes["/"] = nullptr;
+  for (const ArchiveFile &F : Files) {
+    SmallString<128> Path(F.VPath);
+    sys::path::remove_dots(Path, /*remove_dot_dot=*/true);
+    removeTrailingSeparators(Path);
+    Nodes[Path.str()] = &F;
+
+    // Add the parent directories, up to and including the root directory.
+    size_t RootSize = sys::path::root_path(Path).size();
+    for (StringRef Parent = sys::path::parent_path(Path);
+         Parent.size() >= RootSize; Parent = sys::path::parent_path(Parent)) {
+      Nodes.insert(std::make_pair(Parent.str(), nullptr));
+      if (Parent.size() == RootSize)
+        break;
+    }
+  }
+
+  auto AlignContent = [](uint64_t Offset) {
+    return alignTo(Offset, archive::ContentAlignment);
+  };
+  static const char Zeros[archive::ContentAlignment] = {};
+
+  // Lay out the archive.
+  uint64_t StringTableOffset =
+      archive::HeaderSize + Nodes.size() * archive::EntrySize;
+  uint64_t StringTableSize = 0;
+  for (const auto &Node : Nodes)
+    StringTableSize += Node.first.size();
+  uint64_t ContentEnd = AlignContent(StringTableOffset + StringTableSize);
+
+  support::endian::Writer<support::little> LE(OS);
+  OS.write(archive::Magic, sizeof(archive::Magic));
+  LE.write<uint32_t>(archive::Version);
+  LE.write<uint32_t>(Nodes.size());
+  LE.write<uint64_t>(StringTableOffset);
+  LE.write<uint64_t>(StringTableSize);
+
+  uint32_t PathOffset = 0;
+  for (const auto &Node : Nodes) {
+    const ArchiveFile *F = Node.second;
+    LE.write<uint32_t>(PathOffset);
+    LE.write<uint32_t>(Node.first.size());
+    PathOffset += Node.first.size();
+    if (F) {
+      LE.write<uint64_t>(ContentEnd);
+      LE.write<uint64_t>(F->Buffer->getBufferSize());
+      LE.write<uint64_t>(sys::toTimeT(F->MTime));
+      LE.write<uint32_t>(archive::ET_File);
+      LE.write<uint32_t>(perms::all_read);
+      // Leave room for the null terminator.
+      ContentEnd = AlignContent(ContentEnd + F->Buffer->getBufferSize() + 1);
+    } else {
+      LE.write<uint64_t>(0);
+      LE.write<uint64_t>(0);
+      LE.write<uint64_t>(0);
+      LE.write<uint32_t>(archive::ET_Directory);
+      LE.write<uint32_t>(perms::all_read | perms::all_exe);
+    }
+  }
+
+  for (const auto &Node : Nodes)
+    OS << Node.first;
+
+  uint64_t Offset = StringTableOffset + StringTableSize;
+  for (const auto &Node : Nodes) {
+    const ArchiveFile *F = Node.second;
+    if (!F)
+      continue;
+    OS.write(Zeros, AlignContent(Offset) - Offset);
+    Offset = AlignContent(Offset);
+    OS << F->Buffer->getBuffer();
+    OS << '\0';
+    Offset += F->Buffer->getBufferSize() + 1;
+  }
+  OS.write(Zeros, AlignContent(Offset) - Offset);
+}
+
+//===-----------------------------------------------------------------------===/
+// SharedFileSystemCache implementation
+//===-----------------------------------------------------------------------===/
+
+SharedFileSystemCache::SharedFileSystemCache(IntrusiveRefCntPtr<FileSystem> FS)
+    : FS(std::move(FS)), NumStatLookups(0), NumStatMisses(0),
+      NumBufferLookups(0), NumBufferMisses(0) {}
+
+SharedFileSystemCache::~SharedFileSystemCache() {}
+
+SharedFileSystemCache::Shard &SharedFileSystemCache::getShard(StringRef Path) {
+  return Shards[llvm::HashString(Path) % NumShards];
+}
+
+ErrorOr<Status> SharedFileSystemCache::status(StringRef Path) {
+  ++NumStatLookups;
+  Shard &S = getShard(Path);
+  {
+    std::lock_guard<std::mutex> Lock(S.Mutex);
+    auto I = S.Entries.find(Path);
+    if (I != S.Entries.end() && I->second.HasStatus) {
+      if (I->second.StatusError)
+        return I->second.StatusError;
+      return I->second.S;
+    }
+  }
+
+  // Don't hold the lock across the stat; if another thread races us to the
+  // same path, the first result recorded wins.
+  ++NumStatMisses;
+  ErrorOr<Status> Result = FS->status(Path);
+
+  std::lock_guard<std::mutex> Lock(S.Mutex);
+  Entry &E = S.Entries[Path];
+  if (!E.HasStatus) {
+    E.HasStatus = true;
+    if (Result)
+      E.S = *Result;
+    else
+      E.StatusError = Result.getError();
+  }
+  if (E.StatusError)
+    return E.StatusError;
+  return E.S;
+}
+
+ErrorOr<std::shared_ptr<MemoryBuffer>>
+SharedFileSystemCache::getBuffer(StringRef Path) {
+  ++NumBufferLookups;
+  Shard &S = getShard(Path);
+  {
+    std::lock_guard<std::mutex> Lock(S.Mutex);
+    auto I = S.Entries.find(Path);
+    if (I != S.Entries.end() && I->second.Buffer)
+      return I->second.Buffer;
+  }
+
+  // Read errors are not cached, so a later request tries again.
+  ++NumBufferMisses;
+  auto F = FS->openFileForRead(Path);
+  if (!F)
+    return F.getError();
+  ErrorOr<Status> Stat = (*F)->status();
+  auto Buffer = (*F)->getBuffer(Path, Stat ? Stat->getSize() : -1,
+                                /*RequiresNullTerminator=*/true,
+                                /*IsVolatile=*/false);
+  if (!Buffer)
+    return Buffer.getError();
+
+  std::lock_guard<std::mutex> Lock(S.Mutex);
+  Entry &E = S.Entries[Path];
+  if (!E.HasStatus && Stat) {
+    E.HasStatus = true;
+    E.S = *Stat;
+  }
+  if (!E.Buffer)
+    E.Buffer = std::move(*Buffer);
+  return E.Buffer;
+}
+
+void SharedFileSystemCache::PrintStats() const {
+  llvm::errs() << "\n*** Shared File System Cache Stats:\n";
+  llvm::errs() << NumStatLookups << " status lookups, "
+               << NumStatMisses << " status cache misses.\n";
+  llvm::errs() << NumBufferLookups << " buffer lookups, "
+               << NumBufferMisses << " buffer cache misses.\n";
+}
+
+namespace {
+
+/// A buffer whose contents are owned by a SharedFileSystemCache entry, which
+/// it keeps alive for as long as the buffer is in use.
+class SharedMemoryBuffer : public MemoryBuffer {
+  std::shared_ptr<MemoryBuffer> Contents;
+  std::string Name;
+
+public:
+  SharedMemoryBuffer(std::shared_ptr<MemoryBuffer> Contents, StringRef Name)
+      : Contents(std::move(Contents)), Name(Name) {
+    // The cache always reads files with a null terminator.
+    init(this->Contents->getBufferStart(), this->Contents->getBufferEnd(),
+         /*RequiresNullTerminator=*/true);
+  }
+
+  StringRef getBufferIdentifier() const override { return Name; }
+  BufferKind getBufferKind() const override {
+    return Contents->getBufferKind();
+  }
+};
+
+class CachedFile : public File {
+  Status S;
+  std::shared_ptr<MemoryBuffer> Contents;
+
+public:
+  CachedFile(Status S, std::shared_ptr<MemoryBuffer> Contents)
+      : S(std::move(S)), Contents(std::move(Contents)) {}
+
+  ErrorOr<Status> status() override { return S; }
+  ErrorOr<std::unique_ptr<MemoryBuffer>>
+  getBuffer(const Twine &Name, int64_t FileSize, bool RequiresNullTerminator,
+            bool IsVolatile) override {
+    return std::unique_ptr<MemoryBuffer>(
+        new SharedMemoryBuffer(Contents, Name.str()));
+  }
+  std::error_code close() override { return std::error_code(); }
+};
+
+/// A view of a SharedFileSystemCache with its own working directory.
+class CachingFileSystem : public FileSystem {
+  IntrusiveRefCntPtr<SharedFileSystemCache> Cache;
+  std::string WorkingDirectory;
+
+  std::error_code getAbsolutePath(const Twine &Path,
+                                  SmallVectorImpl<char> &Result) const {
+    Path.toVector(Result);
+    return makeAbsolute(Result);
+  }
+
+public:
+  CachingFileSystem(IntrusiveRefCntPtr<SharedFileSystemCache> Cache,
+                    StringRef WorkingDirectory)
+      : Cache(std::move(Cache)), WorkingDirectory(WorkingDirectory) {}
+
+  ErrorOr<Status> status(const Twine &Path) override {
+    SmallString<256> AbsPath;
+    if (std::error_code EC = getAbsolutePath(Path, AbsPath))
+      return EC;
+    ErrorOr<Status> S = Cache->status(AbsPath);
+    if (!S)
+      return S.getError();
+    // Report the entry under the name it was asked for, as the underlying
+    // file system would have.
+    return Status::copyWithNewName(*S, Path.str());
+  }
+
+  ErrorOr<std::unique_ptr<File>> openFileForRead(const Twine &Path) override {
+    SmallString<256> AbsPath;
+    if (std::error_code EC = getAbsolutePath(Path, AbsPath))
+      return EC;
+    auto Contents = Cache->getBuffer(AbsPath);
+    if (!Contents)
+      return Contents.getError();
+    ErrorOr<Status> S = Cache->status(AbsPath);
+    if (!S)
+      return S.getError();
+    return std::unique_ptr<File>(new CachedFile(
+        Status::copyWithNewName(*S, Path.str()), std::move(*Contents)));
+  }
+
+  directory_iterator dir_begin(const Twine &Dir, std::error_code &EC) override {
+    SmallString<256> AbsPath;
+    if ((EC = getAbsolutePath(Dir, AbsPath)))
+      return directory_iterator();
+    return Cache->getUnderlyingFS().dir_begin(AbsPath, EC);
+  }
+
+  ErrorOr<std::string> getCurrentWorkingDirectory() const override {
+    return WorkingDirectory;
+  }
+
+  std::error_code setCurrentWorkingDirectory(const Twine &Path) override {
+    SmallString<256> AbsPath;
+    if (std::error_code EC = getAbsolutePath(Path, AbsPath))
+      return EC;
+    ErrorOr<Status> S = Cache->status(AbsPath);
+    if (!S)
+      return S.getError();
+    if (!S->isDirectory())
+      return make_error_code(llvm::errc::not_a_directory);
+    WorkingDirectory = AbsPath.str();
+    return std::error_code();
+  }
+};
+
+} // end anonymous namespace
+
+IntrusiveRefCntPtr<FileSystem>
+vfs::createCachingFileSystem(IntrusiveRefCntPtr<SharedFileSystemCache> Cache,
+                             StringRef WorkingDirectory) {
+  return new CachingFileSystem(std::move(Cache), WorkingDirectory);
+}
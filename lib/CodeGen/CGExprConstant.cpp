@@ -1427,9 +1427,13 @@ llvm::Constant *CodeGenModule::EmitConstantValue(const APValue &Value,
     unsigned NumElements = Value.getArraySize();
     unsigned NumInitElts = Value.getArrayInitializedElts();
 
-    // Emit array filler, if there is one.
+    // Emit array filler, if there is one. Read the elements of a packed
+    // array one at a time, rather than unpacking all of them.
     llvm::Constant *Filler = nullptr;
-    if (Value.hasArrayFiller())
+    if (Value.isPackedArray() && Value.hasArrayFiller())
+      Filler = EmitConstantValueForMemory(Value.getPackedArrayElt(NumInitElts),
+                                          CAT->getElementType(), CGF);
+    else if (Value.hasArrayFiller())
       Filler = EmitConstantValueForMemory(Value.getArrayFiller(),
                                           CAT->getElementType(), CGF);
 
@@ -1448,7 +1452,10 @@ llvm::Constant *CodeGenModule::EmitConstantValue(const APValue &Value,
     Elts.reserve(NumElements);
     for (unsigned I = 0; I < NumElements; ++I) {
       llvm::Constant *C = Filler;
-      if (I < NumInitElts)
+      if (I < NumInitElts && Value.isPackedArray())
+        C = EmitConstantValueForMemory(Value.getPackedArrayElt(I),
+                                       CAT->getElementType(), CGF);
+      else if (I < NumInitElts)
         C = EmitConstantValueForMemory(Value.getArrayInitializedElt(I),
                                        CAT->getElementType(), CGF);
       else
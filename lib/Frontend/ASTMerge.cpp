@@ -39,6 +39,12 @@ void ASTMergeAction::ExecuteAction() {
                                        &CI.getASTContext());
   IntrusiveRefCntPtr<DiagnosticIDs>
       DiagIDs(CI.getDiagnostics().getDiagnosticIDs());
+
+  // The AST files are merged one at a time, and each one is released once it
+  // has been imported, so only the merged AST grows with the number of files.
+  // Files shared between the AST files, such as common headers, are only
+  // added to the merged AST's source manager once.
+  ASTImporter::ImportedFileMap ImportedFiles;
   for (unsigned I = 0, N = ASTFiles.size(); I != N; ++I) {
     IntrusiveRefCntPtr<DiagnosticsEngine>
         Diags(new DiagnosticsEngine(DiagIDs, &CI.getDiagnosticOpts(),
@@ -57,6 +63,7 @@ void ASTMergeAction::ExecuteAction() {
                          Unit->getASTContext(), 
                          Unit->getFileManager(),
                          /*MinimalImport=*/false);
+    Importer.setSharedImportedFiles(&ImportedFiles);
 
     TranslationUnitDecl *TU = Unit->getASTContext().getTranslationUnitDecl();
     for (auto *D : TU->decls()) {
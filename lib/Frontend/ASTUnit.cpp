@@ -35,16 +35,20 @@
 #include "clang/Serialization/ASTReader.h"
 #include "clang/Serialization/ASTWriter.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringSet.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/Support/CrashRecoveryContext.h"
 #include "llvm/Support/Host.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Mutex.h"
 #include "llvm/Support/MutexGuard.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include <atomic>
+#include <chrono>
 #include <cstdio>
 #include <cstdlib>
 
@@ -84,7 +88,11 @@ namespace {
     /// \brief The file in which the precompiled preamble is stored.
     std::string PreambleFile;
 
-    /// \brief Erase the preamble file.
+    /// \brief The files in which the earlier segments of a chained
+    /// precompiled preamble are stored.
+    std::vector<std::string> ChainedPreambleFiles;
+
+    /// \brief Erase the preamble file, along with those it is chained to.
     void CleanPreambleFile();
 
     /// \brief Erase temporary files and the preamble file.
@@ -152,6 +160,11 @@ static void setPreambleFile(const ASTUnit *AU, StringRef preambleFile) {
   getOnDiskData(AU).PreambleFile = preambleFile;
 }
 
+static void setChainedPreambleFiles(const ASTUnit *AU,
+                                    std::vector<std::string> Files) {
+  getOnDiskData(AU).ChainedPreambleFiles = std::move(Files);
+}
+
 static const std::string &getPreambleFile(const ASTUnit *AU) {
   return getOnDiskData(AU).PreambleFile;  
 }
@@ -161,12 +174,43 @@ void OnDiskData::CleanPreambleFile() {
     llvm::sys::fs::remove(PreambleFile);
     PreambleFile.clear();
   }
+  for (const std::string &File : ChainedPreambleFiles)
+    llvm::sys::fs::remove(File);
+  ChainedPreambleFiles.clear();
 }
 
 void OnDiskData::Cleanup() {
   CleanPreambleFile();
 }
 
+/// \brief The inputs and results of building a precompiled preamble on a
+/// background thread. Only the background thread touches it until \c Done is
+/// ready. The segments of a chained preamble are built the same way, but
+/// synchronously.
+struct ASTUnit::BackgroundPreambleBuild {
+  std::shared_ptr<CompilerInvocation> Invocation;
+  std::shared_ptr<PCHContainerOperations> PCHContainerOps;
+  std::vector<std::unique_ptr<llvm::MemoryBuffer>> RemappedBuffers;
+  std::unique_ptr<llvm::MemoryBuffer> PreambleBuffer;
+  bool PreambleEndsAtStartOfLine;
+  std::string PCHPath;
+
+  bool Succeeded;
+  unsigned TopLevelHashValue;
+  std::vector<serialization::DeclID> TopLevelDecls;
+  SmallVector<StandaloneDiagnostic, 4> Diagnostics;
+  unsigned NumWarnings;
+  llvm::StringMap<PreambleFileHash> Files;
+
+  std::shared_future<void> Done;
+
+  BackgroundPreambleBuild()
+      : PreambleEndsAtStartOfLine(false), Succeeded(false),
+        TopLevelHashValue(0), NumWarnings(0) {}
+
+  void run();
+};
+
 struct ASTUnit::ASTWriterData {
   SmallString<128> Buffer;
   llvm::BitstreamWriter Stream;
@@ -199,7 +243,9 @@ ASTUnit::ASTUnit(bool _MainFileIsAST)
     OwnsRemappedFileBuffers(true),
     NumStoredDiagnosticsFromDriver(0),
     PreambleRebuildCounter(0),
-    NumWarningsInPreamble(0),
+    NumWarningsInPreamble(0), PreambleCounter(0),
+    BuildPreambleInBackground(false), ChainPreambleAtIncludes(false),
+    PreambleSegmentCounter(0),
     ShouldCacheCodeCompletionResults(false),
     IncludeBriefCommentsInCodeCompletion(false), UserFilesAreVolatile(false),
     CompletionCacheTopLevelHashValue(0),
@@ -211,6 +257,12 @@ ASTUnit::ASTUnit(bool _MainFileIsAST)
 }
 
 ASTUnit::~ASTUnit() {
+  // Wait for any preamble being built in the background; nobody will use it.
+  if (PendingPreamble) {
+    PendingPreamble->Done.wait();
+    llvm::sys::fs::remove(PendingPreamble->PCHPath);
+  }
+
   // If we loaded from an AST file, balance out the BeginSourceFile call.
   if (MainFileIsAST && getDiagnostics().getClient()) {
     getDiagnostics().getClient()->EndSourceFile();
@@ -882,13 +934,18 @@ public:
   }
 };
 
+/// \brief Action that precompiles a preamble, recording the hash of its
+/// top-level entities and the IDs of its top-level declarations.
 class PrecompilePreambleAction : public ASTFrontendAction {
-  ASTUnit &Unit;
+  unsigned &Hash;
+  std::vector<serialization::DeclID> &TopLevelDeclIDs;
   bool HasEmittedPreamblePCH;
 
 public:
-  explicit PrecompilePreambleAction(ASTUnit &Unit)
-      : Unit(Unit), HasEmittedPreamblePCH(false) {}
+  PrecompilePreambleAction(unsigned &Hash,
+                           std::vector<serialization::DeclID> &TopLevelDeclIDs)
+      : Hash(Hash), TopLevelDeclIDs(TopLevelDeclIDs),
+        HasEmittedPreamblePCH(false) {}
 
   std::unique_ptr<ASTConsumer> CreateASTConsumer(CompilerInstance &CI,
                                                  StringRef InFile) override;
@@ -902,20 +959,22 @@ public:
 };
 
 class PrecompilePreambleConsumer : public PCHGenerator {
-  ASTUnit &Unit;
   unsigned &Hash;
+  std::vector<serialization::DeclID> &TopLevelDeclIDs;
   std::vector<Decl *> TopLevelDecls;
   PrecompilePreambleAction *Action;
   std::unique_ptr<raw_ostream> Out;
 
 public:
-  PrecompilePreambleConsumer(ASTUnit &Unit, PrecompilePreambleAction *Action,
+  PrecompilePreambleConsumer(unsigned &Hash,
+                             std::vector<serialization::DeclID> &TopLevelDeclIDs,
+                             PrecompilePreambleAction *Action,
                              const Preprocessor &PP, StringRef isysroot,
                              std::unique_ptr<raw_ostream> Out)
       : PCHGenerator(PP, "", isysroot, std::make_shared<PCHBuffer>(),
                      ArrayRef<std::shared_ptr<ModuleFileExtension>>(),
                      /*AllowASTWithErrors=*/true),
-        Unit(Unit), Hash(Unit.getCurrentTopLevelHashValue()), Action(Action),
+        Hash(Hash), TopLevelDeclIDs(TopLevelDeclIDs), Action(Action),
         Out(std::move(Out)) {
     Hash = 0;
   }
@@ -953,7 +1012,7 @@ public:
         // Invalid top-level decls may not have been serialized.
         if (D->isInvalidDecl())
           continue;
-        Unit.addTopLevelDeclFromPreamble(getWriter().getDeclID(D));
+        TopLevelDeclIDs.push_back(getWriter().getDeclID(D));
       }
 
       Action->setHasEmittedPreamblePCH();
@@ -978,10 +1037,10 @@ PrecompilePreambleAction::CreateASTConsumer(CompilerInstance &CI,
     Sysroot.clear();
 
   CI.getPreprocessor().addPPCallbacks(
-      llvm::make_unique<MacroDefinitionTrackerPPCallbacks>(
-                                           Unit.getCurrentTopLevelHashValue()));
+      llvm::make_unique<MacroDefinitionTrackerPPCallbacks>(Hash));
   return llvm::make_unique<PrecompilePreambleConsumer>(
-      Unit, this, CI.getPreprocessor(), Sysroot, std::move(OS));
+      Hash, TopLevelDeclIDs, this, CI.getPreprocessor(), Sysroot,
+      std::move(OS));
 }
 
 static bool isNonDriverDiag(const StoredDiagnostic &StoredDiag) {
@@ -1226,12 +1285,23 @@ ASTUnit::ComputePreamble(CompilerInvocation &Invocation, unsigned MaxLines) {
                           Pre.second);
 }
 
+static llvm::MD5::MD5Result computeContentHash(StringRef Contents) {
+  llvm::MD5 MD5Ctx;
+  MD5Ctx.update(Contents);
+  llvm::MD5::MD5Result Result;
+  MD5Ctx.final(Result);
+  return Result;
+}
+
 ASTUnit::PreambleFileHash
-ASTUnit::PreambleFileHash::createForFile(off_t Size, time_t ModTime) {
+ASTUnit::PreambleFileHash::createForFile(off_t Size, time_t ModTime,
+                                         const llvm::MemoryBuffer *Buffer) {
   PreambleFileHash Result;
   Result.Size = Size;
   Result.ModTime = ModTime;
   Result.MD5 = {};
+  if (Buffer && off_t(Buffer->getBufferSize()) == Size)
+    Result.MD5 = computeContentHash(Buffer->getBuffer());
   return Result;
 }
 
@@ -1251,8 +1321,10 @@ ASTUnit::PreambleFileHash ASTUnit::PreambleFileHash::createForMemoryBuffer(
 namespace clang {
 bool operator==(const ASTUnit::PreambleFileHash &LHS,
                 const ASTUnit::PreambleFileHash &RHS) {
+  // The contents of on-disk files are identified by their modification time;
+  // their MD5, if any, only backs that up.
   return LHS.Size == RHS.Size && LHS.ModTime == RHS.ModTime &&
-         LHS.MD5 == RHS.MD5;
+         (LHS.ModTime != 0 || LHS.MD5 == RHS.MD5);
 }
 } // namespace clang
 
@@ -1277,6 +1349,29 @@ static ASTUnit::StandaloneFixIt makeStandaloneFixIt(const SourceManager &SM,
   return OutFix;
 }
 
+/// \brief Record the files a preamble was built from, so that we can check
+/// whether they have changed before reusing it.
+static void
+recordFilesInPreamble(CompilerInstance &Clang,
+                      const DependencyCollector &PreambleDepCollector,
+                      llvm::StringMap<ASTUnit::PreambleFileHash> &Files) {
+  Files.clear();
+  SourceManager &SourceMgr = Clang.getSourceManager();
+  for (auto &Filename : PreambleDepCollector.getDependencies()) {
+    const FileEntry *File = Clang.getFileManager().getFile(Filename);
+    if (!File || File == SourceMgr.getFileEntryForID(SourceMgr.getMainFileID()))
+      continue;
+    if (time_t ModTime = File->getModificationTime()) {
+      Files[File->getName()] = ASTUnit::PreambleFileHash::createForFile(
+          File->getSize(), ModTime, SourceMgr.getMemoryBufferForFile(File));
+    } else {
+      llvm::MemoryBuffer *Buffer = SourceMgr.getMemoryBufferForFile(File);
+      Files[File->getName()] =
+          ASTUnit::PreambleFileHash::createForMemoryBuffer(Buffer);
+    }
+  }
+}
+
 static ASTUnit::StandaloneDiagnostic
 makeStandaloneDiagnostic(const LangOptions &LangOpts,
                          const StoredDiagnostic &InDiag) {
@@ -1301,6 +1396,103 @@ makeStandaloneDiagnostic(const LangOptions &LangOpts,
   return OutDiag;
 }
 
+typedef std::map<llvm::sys::fs::UniqueID, ASTUnit::PreambleFileHash>
+    OverriddenFilesMap;
+
+/// \brief Make a record of those files that have been overridden via
+/// remapping or unsaved_files.
+///
+/// \returns false if one of the files can't be found.
+static bool collectOverriddenFiles(FileManager &FileMgr,
+                                   const PreprocessorOptions &PreprocessorOpts,
+                                   OverriddenFilesMap &OverriddenFiles) {
+  for (const auto &R : PreprocessorOpts.RemappedFiles) {
+    vfs::Status Status;
+    if (FileMgr.getNoncachedStatValue(R.second, Status)) {
+      // If we can't stat the file we're remapping to, assume that something
+      // horrible happened.
+      return false;
+    }
+
+    OverriddenFiles[Status.getUniqueID()] = ASTUnit::PreambleFileHash::
+        createForFile(Status.getSize(),
+                      llvm::sys::toTimeT(Status.getLastModificationTime()));
+  }
+
+  for (const auto &RB : PreprocessorOpts.RemappedFileBuffers) {
+    vfs::Status Status;
+    if (FileMgr.getNoncachedStatValue(RB.first, Status))
+      return false;
+
+    OverriddenFiles[Status.getUniqueID()] =
+        ASTUnit::PreambleFileHash::createForMemoryBuffer(RB.second);
+  }
+  return true;
+}
+
+/// \brief Check whether any of the files a preamble was built from have
+/// changed, remembering the new modification time of those that have only
+/// been touched.
+///
+/// \param AnyFileUnreadable Set when a file has changed in a way that the AST
+/// reader rejects even without validation: it has gone, or its size on disk
+/// has changed.
+static bool
+haveFilesChanged(FileManager &FileMgr,
+                 llvm::StringMap<ASTUnit::PreambleFileHash> &Files,
+                 const OverriddenFilesMap &OverriddenFiles,
+                 bool &AnyFileUnreadable) {
+  bool AnyFileChanged = false;
+  for (llvm::StringMap<ASTUnit::PreambleFileHash>::iterator
+         F = Files.begin(), FEnd = Files.end();
+       !AnyFileChanged && F != FEnd;
+       ++F) {
+    vfs::Status Status;
+    if (FileMgr.getNoncachedStatValue(F->first(), Status)) {
+      // If we can't stat the file, assume that something horrible happened.
+      AnyFileUnreadable = true;
+      return true;
+    }
+
+    OverriddenFilesMap::const_iterator Overridden
+      = OverriddenFiles.find(Status.getUniqueID());
+    if (Overridden != OverriddenFiles.end()) {
+      // This file was remapped; check whether the newly-mapped file
+      // matches up with the previous mapping.
+      if (Overridden->second != F->second)
+        AnyFileChanged = true;
+      continue;
+    }
+
+    // The file was not remapped; check whether it has changed on disk.
+    if (Status.getSize() != uint64_t(F->second.Size)) {
+      AnyFileChanged = AnyFileUnreadable = true;
+      continue;
+    }
+    time_t ModTime = llvm::sys::toTimeT(Status.getLastModificationTime());
+    if (ModTime == F->second.ModTime)
+      continue;
+
+    // The file has been touched. If we know what its contents were, it
+    // has only changed if they have.
+    if (F->second.MD5 == llvm::MD5::MD5Result()) {
+      AnyFileChanged = true;
+      continue;
+    }
+    auto Buffer = FileMgr.getBufferForFile(F->first());
+    if (!Buffer ||
+        !(computeContentHash((*Buffer)->getBuffer()) == F->second.MD5)) {
+      AnyFileChanged = true;
+      continue;
+    }
+
+    // Remember the new modification time, so that we don't read the file
+    // again next time.
+    F->second.ModTime = ModTime;
+  }
+  return AnyFileChanged;
+}
+
 /// \brief Attempt to build or re-use a precompiled preamble when (re-)parsing
 /// the source file.
 ///
@@ -1339,13 +1531,22 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
     // We couldn't find a preamble in the main source. Clear out the current
     // preamble, if we have one. It's obviously no good any more.
     Preamble.clear();
+    PreambleSegments.clear();
     erasePreambleFile(this);
 
     // The next time we actually see a preamble, precompile it.
     PreambleRebuildCounter = 1;
     return nullptr;
   }
-  
+
+  // Chained preambles need a file per segment, which the crash-recovery
+  // tests' CINDEXTEST_PREAMBLE_FILE can't provide.
+  if (ChainPreambleAtIncludes && !BuildPreambleInBackground &&
+      !::getenv("CINDEXTEST_PREAMBLE_FILE"))
+    return getMainBufferWithChainedPreamble(std::move(PCHContainerOps),
+                                            *PreambleInvocation, NewPreamble,
+                                            AllowRebuild);
+
   if (!Preamble.empty()) {
     // We've previously computed a preamble. Check whether we have the same
     // preamble now that we did before, and that there's enough space in
@@ -1359,69 +1560,29 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
       // preamble.
 
       // Check that none of the files used by the preamble have changed.
-      bool AnyFileChanged = false;
-          
-      // First, make a record of those files that have been overridden via
-      // remapping or unsaved_files.
-      std::map<llvm::sys::fs::UniqueID, PreambleFileHash> OverriddenFiles;
-      for (const auto &R : PreprocessorOpts.RemappedFiles) {
-        if (AnyFileChanged)
-          break;
-
-        vfs::Status Status;
-        if (FileMgr->getNoncachedStatValue(R.second, Status)) {
-          // If we can't stat the file we're remapping to, assume that something
-          // horrible happened.
-          AnyFileChanged = true;
-          break;
-        }
+      bool AnyFileChanged = true;
 
-        OverriddenFiles[Status.getUniqueID()] = PreambleFileHash::createForFile(
-            Status.getSize(),
-            llvm::sys::toTimeT(Status.getLastModificationTime()));
-      }
-
-      for (const auto &RB : PreprocessorOpts.RemappedFileBuffers) {
-        if (AnyFileChanged)
-          break;
-
-        vfs::Status Status;
-        if (FileMgr->getNoncachedStatValue(RB.first, Status)) {
-          AnyFileChanged = true;
-          break;
-        }
-
-        OverriddenFiles[Status.getUniqueID()] =
-            PreambleFileHash::createForMemoryBuffer(RB.second);
-      }
-       
-      // Check whether anything has changed.
-      for (llvm::StringMap<PreambleFileHash>::iterator
-             F = FilesInPreamble.begin(), FEnd = FilesInPreamble.end();
-           !AnyFileChanged && F != FEnd; 
-           ++F) {
-        vfs::Status Status;
-        if (FileMgr->getNoncachedStatValue(F->first(), Status)) {
-          // If we can't stat the file, assume that something horrible happened.
-          AnyFileChanged = true;
-          break;
-        }
+      // Whether a file used by the preamble has changed in a way that the
+      // AST reader rejects even without validation: it has gone, or its size
+      // on disk has changed.
+      bool AnyFileUnreadable = false;
 
-        std::map<llvm::sys::fs::UniqueID, PreambleFileHash>::iterator Overridden
-          = OverriddenFiles.find(Status.getUniqueID());
-        if (Overridden != OverriddenFiles.end()) {
-          // This file was remapped; check whether the newly-mapped file 
-          // matches up with the previous mapping.
-          if (Overridden->second != F->second)
-            AnyFileChanged = true;
-          continue;
-        }
-        
-        // The file was not remapped; check whether it has changed on disk.
-        if (Status.getSize() != uint64_t(F->second.Size) ||
-            llvm::sys::toTimeT(Status.getLastModificationTime()) !=
-                F->second.ModTime)
-          AnyFileChanged = true;
+      OverriddenFilesMap OverriddenFiles;
+      if (collectOverriddenFiles(*FileMgr, PreprocessorOpts, OverriddenFiles))
+        AnyFileChanged = haveFilesChanged(*FileMgr, FilesInPreamble,
+                                          OverriddenFiles, AnyFileUnreadable);
+      else
+        AnyFileUnreadable = true;
+
+      // Only files included by the preamble have changed. When preambles are
+      // built in the background, keep using this one until its replacement
+      // is ready, provided the AST reader can still load it. Otherwise, fall
+      // through to parse without a preamble in the meantime.
+      if (AnyFileChanged && !AnyFileUnreadable && BuildPreambleInBackground &&
+          AllowRebuild) {
+        startBackgroundPreambleBuild(PCHContainerOps, *PreambleInvocation,
+                                     NewPreamble);
+        AnyFileChanged = false;
       }
           
       if (!AnyFileChanged) {
@@ -1447,6 +1608,7 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
     // We can't reuse the previously-computed preamble. Build a new one.
     Preamble.clear();
     PreambleDiagnostics.clear();
+    PreambleSegments.clear();
     erasePreambleFile(this);
     PreambleRebuildCounter = 1;
   } else if (!AllowRebuild) {
@@ -1455,6 +1617,13 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
     return nullptr;
   }
 
+  // Parse without a preamble until the new one has been built.
+  if (BuildPreambleInBackground) {
+    startBackgroundPreambleBuild(std::move(PCHContainerOps),
+                                 *PreambleInvocation, NewPreamble);
+    return nullptr;
+  }
+
   // If the preamble rebuild counter > 1, it's because we previously
   // failed to build a preamble and we're not yet ready to try
   // again. Decrement the counter and return a failure.
@@ -1562,7 +1731,8 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
   Clang->addDependencyCollector(PreambleDepCollector);
 
   std::unique_ptr<PrecompilePreambleAction> Act;
-  Act.reset(new PrecompilePreambleAction(*this));
+  Act.reset(new PrecompilePreambleAction(CurrentTopLevelHashValue,
+                                         TopLevelDeclsInPreamble));
   if (!Act->BeginSourceFile(*Clang.get(), Clang->getFrontendOpts().Inputs[0])) {
     llvm::sys::fs::remove(FrontendOpts.OutputFile);
     Preamble.clear();
@@ -1600,27 +1770,501 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
   // Keep track of the preamble we precompiled.
   setPreambleFile(this, FrontendOpts.OutputFile);
   NumWarningsInPreamble = getDiagnostics().getNumWarnings();
+  ++PreambleCounter;
   
   // Keep track of all of the files that the source manager knows about,
   // so we can verify whether they have changed or not.
-  FilesInPreamble.clear();
-  SourceManager &SourceMgr = Clang->getSourceManager();
-  for (auto &Filename : PreambleDepCollector->getDependencies()) {
-    const FileEntry *File = Clang->getFileManager().getFile(Filename);
-    if (!File || File == SourceMgr.getFileEntryForID(SourceMgr.getMainFileID()))
+  recordFilesInPreamble(*Clang, *PreambleDepCollector, FilesInPreamble);
+
+  PreambleRebuildCounter = 1;
+  PreprocessorOpts.RemappedFileBuffers.pop_back();
+
+  // If the hash of top-level entities differs from the hash of the top-level
+  // entities the last time we rebuilt the preamble, clear out the completion
+  // cache.
+  if (CurrentTopLevelHashValue != PreambleTopLevelHashValue) {
+    CompletionCacheTopLevelHashValue = 0;
+    PreambleTopLevelHashValue = CurrentTopLevelHashValue;
+  }
+
+  return llvm::MemoryBuffer::getMemBufferCopy(NewPreamble.Buffer->getBuffer(),
+                                              MainFilename);
+}
+
+void ASTUnit::BackgroundPreambleBuild::run() {
+  // Build the preamble entirely separately from the ASTUnit, capturing its
+  // diagnostics, so that the ASTUnit can keep being used in the meantime.
+  SmallVector<StoredDiagnostic, 4> StoredDiags;
+  StoredDiagnosticConsumer DiagConsumer(StoredDiags);
+  IntrusiveRefCntPtr<DiagnosticsEngine> Diags =
+      CompilerInstance::createDiagnostics(&Invocation->getDiagnosticOpts(),
+                                          &DiagConsumer,
+                                          /*ShouldOwnClient=*/false);
+
+  std::unique_ptr<CompilerInstance> Clang(
+      new CompilerInstance(std::move(PCHContainerOps)));
+
+  // Recover resources if we crash before exiting this method.
+  llvm::CrashRecoveryContextCleanupRegistrar<CompilerInstance>
+    CICleanup(Clang.get());
+
+  Clang->setInvocation(Invocation);
+  Clang->setDiagnostics(Diags.get());
+
+  Clang->setTarget(TargetInfo::CreateTargetInfo(
+      *Diags, Clang->getInvocation().TargetOpts));
+  if (!Clang->hasTarget())
+    return;
+  Clang->getTarget().adjust(Clang->getLangOpts());
+
+  IntrusiveRefCntPtr<vfs::FileSystem> VFS =
+      createVFSFromCompilerInvocation(Clang->getInvocation(), *Diags);
+  if (!VFS)
+    return;
+  Clang->setFileManager(new FileManager(Clang->getFileSystemOpts(), VFS));
+  Clang->setSourceManager(new SourceManager(*Diags, Clang->getFileManager()));
+
+  auto PreambleDepCollector = std::make_shared<DependencyCollector>();
+  Clang->addDependencyCollector(PreambleDepCollector);
+
+  std::unique_ptr<PrecompilePreambleAction> Act(
+      new PrecompilePreambleAction(TopLevelHashValue, TopLevelDecls));
+  if (!Act->BeginSourceFile(*Clang, Clang->getFrontendOpts().Inputs[0]))
+    return;
+
+  Act->Execute();
+
+  for (const StoredDiagnostic &SD : StoredDiags)
+    Diagnostics.push_back(makeStandaloneDiagnostic(Clang->getLangOpts(), SD));
+
+  Act->EndSourceFile();
+
+  if (!Act->hasEmittedPreamblePCH())
+    return;
+
+  NumWarnings = Diags->getNumWarnings();
+  recordFilesInPreamble(*Clang, *PreambleDepCollector, Files);
+  Succeeded = true;
+}
+
+/// \brief Start building a precompiled preamble for \p NewPreamble on the
+/// background thread, unless one is already being built.
+void ASTUnit::startBackgroundPreambleBuild(
+    std::shared_ptr<PCHContainerOperations> PCHContainerOps,
+    const CompilerInvocation &PreambleInvocationIn,
+    const ComputedPreamble &NewPreamble) {
+  // Build one preamble at a time. Once it's ready, we'll find out whether it
+  // is still up to date.
+  if (PendingPreamble)
+    return;
+
+  // If we previously failed to build a preamble, wait a few reparses before
+  // trying again.
+  if (PreambleRebuildCounter > 1) {
+    --PreambleRebuildCounter;
+    return;
+  }
+
+  std::string PreamblePCHPath = GetPreamblePCHPath();
+  if (PreamblePCHPath.empty())
+    return;
+
+  std::unique_ptr<BackgroundPreambleBuild> Build(new BackgroundPreambleBuild);
+  Build->PCHContainerOps = std::move(PCHContainerOps);
+  Build->PCHPath = PreamblePCHPath;
+  Build->PreambleEndsAtStartOfLine = NewPreamble.PreambleEndsAtStartOfLine;
+
+  auto PreambleInvocation =
+      std::make_shared<CompilerInvocation>(PreambleInvocationIn);
+  FrontendOptions &FrontendOpts = PreambleInvocation->getFrontendOpts();
+  PreprocessorOptions &PreprocessorOpts
+    = PreambleInvocation->getPreprocessorOpts();
+
+  // The remapped file buffers are freed by the next reparse, so give the
+  // build its own copies.
+  for (auto &RB : PreprocessorOpts.RemappedFileBuffers) {
+    Build->RemappedBuffers.push_back(llvm::MemoryBuffer::getMemBufferCopy(
+        RB.second->getBuffer(), RB.second->getBufferIdentifier()));
+    RB.second = Build->RemappedBuffers.back().get();
+  }
+  PreprocessorOpts.RetainRemappedFileBuffers = true;
+
+  // Remap the main source file to the preamble buffer.
+  StringRef MainFilePath = FrontendOpts.Inputs[0].getFile();
+  Build->PreambleBuffer = llvm::MemoryBuffer::getMemBufferCopy(
+      NewPreamble.Buffer->getBuffer().slice(0, NewPreamble.Size),
+      MainFilePath);
+  PreprocessorOpts.addRemappedFile(MainFilePath, Build->PreambleBuffer.get());
+
+  FrontendOpts.ProgramAction = frontend::GeneratePCH;
+  FrontendOpts.OutputFile = PreamblePCHPath;
+  PreprocessorOpts.PrecompiledPreambleBytes.first = 0;
+  PreprocessorOpts.PrecompiledPreambleBytes.second = false;
+  Build->Invocation = std::move(PreambleInvocation);
+
+  if (!PreambleThread)
+    PreambleThread.reset(new llvm::ThreadPool(1));
+  BackgroundPreambleBuild *B = Build.get();
+  Build->Done = PreambleThread->async([B] {
+    llvm::CrashRecoveryContext CRC;
+    CRC.RunSafely([B] { B->run(); });
+  });
+  PendingPreamble = std::move(Build);
+}
+
+/// \brief If the preamble being built in the background is ready, make it
+/// the current preamble.
+void ASTUnit::adoptBackgroundPreamble() {
+  if (!PendingPreamble ||
+      PendingPreamble->Done.wait_for(std::chrono::seconds(0)) !=
+          std::future_status::ready)
+    return;
+
+  std::unique_ptr<BackgroundPreambleBuild> Build = std::move(PendingPreamble);
+  if (!Build->Succeeded) {
+    llvm::sys::fs::remove(Build->PCHPath);
+    PreambleRebuildCounter = DefaultPreambleRebuildInterval;
+    return;
+  }
+
+  // The new preamble may itself be out of date by now; if so, the usual
+  // checks will notice and start building another one.
+  StringRef MainFilename = Invocation->getFrontendOpts().Inputs[0].getFile();
+  erasePreambleFile(this);
+  PreambleSegments.clear();
+  setPreambleFile(this, Build->PCHPath);
+  Preamble.assign(FileMgr ? FileMgr->getFile(MainFilename) : nullptr,
+                  Build->PreambleBuffer->getBufferStart(),
+                  Build->PreambleBuffer->getBufferEnd());
+  PreambleEndsAtStartOfLine = Build->PreambleEndsAtStartOfLine;
+  PreambleBuffer = std::move(Build->PreambleBuffer);
+  PreambleDiagnostics = std::move(Build->Diagnostics);
+  NumWarningsInPreamble = Build->NumWarnings;
+  FilesInPreamble = std::move(Build->Files);
+  TopLevelDeclsInPreamble = std::move(Build->TopLevelDecls);
+  PreambleRebuildCounter = 1;
+  ++PreambleCounter;
+
+  // If the hash of top-level entities differs from the hash of the top-level
+  // entities the last time we rebuilt the preamble, clear out the completion
+  // cache.
+  if (Build->TopLevelHashValue != PreambleTopLevelHashValue) {
+    CompletionCacheTopLevelHashValue = 0;
+    PreambleTopLevelHashValue = Build->TopLevelHashValue;
+  }
+}
+
+/// \brief The maximum number of PCH files a chained preamble is split into.
+static const unsigned MaxPreambleSegments = 8;
+
+/// \brief Find the offsets between \p Begin and \p Size at which the
+/// preamble at the start of \p Buffer can be split, so that each segment
+/// ends with a top-level inclusion: the start of the line after each
+/// #include, #import or #include_next directive outside of a conditional.
+static SmallVector<unsigned, 8>
+findPreambleSegmentEnds(StringRef Buffer, unsigned Begin, unsigned Size,
+                        const LangOptions &LangOpts) {
+  SmallVector<unsigned, 8> Ends;
+
+  // Create a lexer starting at the beginning of the segment, using a fake
+  // file location just like Lexer::ComputePreamble does.
+  const unsigned StartOffset = 1;
+  SourceLocation FileLoc = SourceLocation::getFromRawEncoding(StartOffset);
+  Lexer TheLexer(FileLoc, LangOpts, Buffer.begin(), Buffer.begin() + Begin,
+                 Buffer.end());
+
+  unsigned IfCount = 0;
+  bool AfterInclusion = false;
+  Token Tok;
+  TheLexer.LexFromRawLexer(Tok);
+  while (Tok.isNot(tok::eof)) {
+    unsigned Offset = Tok.getLocation().getRawEncoding() - StartOffset;
+    if (Offset >= Size)
+      break;
+    if (!Tok.isAtStartOfLine()) {
+      TheLexer.LexFromRawLexer(Tok);
       continue;
-    if (time_t ModTime = File->getModificationTime()) {
-      FilesInPreamble[File->getName()] = PreambleFileHash::createForFile(
-          File->getSize(), ModTime);
-    } else {
-      llvm::MemoryBuffer *Buffer = SourceMgr.getMemoryBufferForFile(File);
-      FilesInPreamble[File->getName()] =
-          PreambleFileHash::createForMemoryBuffer(Buffer);
     }
+
+    if (AfterInclusion && IfCount == 0)
+      Ends.push_back(Offset);
+    AfterInclusion = false;
+
+    bool IsDirective = Tok.is(tok::hash);
+    TheLexer.LexFromRawLexer(Tok);
+    if (!IsDirective || Tok.isAtStartOfLine() ||
+        Tok.isNot(tok::raw_identifier) || Tok.needsCleaning())
+      continue;
+
+    StringRef Keyword = Tok.getRawIdentifier();
+    if (Keyword == "if" || Keyword == "ifdef" || Keyword == "ifndef")
+      ++IfCount;
+    else if (Keyword == "endif")
+      IfCount = IfCount ? IfCount - 1 : 0;
+    else if (Keyword == "include" || Keyword == "import" ||
+             Keyword == "include_next")
+      AfterInclusion = true;
+    TheLexer.LexFromRawLexer(Tok);
   }
+  return Ends;
+}
 
+/// \brief Attempt to build or re-use a precompiled preamble that is split
+/// into a chain of PCH files at its top-level inclusions.
+///
+/// Only the segments from the first one whose text or files have changed
+/// onwards are precompiled again, each on top of the previous one, so that
+/// editing an inclusion near the end of the preamble doesn't mean
+/// precompiling everything it includes before that.
+std::unique_ptr<llvm::MemoryBuffer> ASTUnit::getMainBufferWithChainedPreamble(
+    std::shared_ptr<PCHContainerOperations> PCHContainerOps,
+    const CompilerInvocation &PreambleInvocationIn,
+    const ComputedPreamble &NewPreamble, bool AllowRebuild) {
+  StringRef MainFilename =
+      PreambleInvocationIn.getFrontendOpts().Inputs[0].getFile();
+  StringRef NewText =
+      NewPreamble.Buffer->getBuffer().slice(0, NewPreamble.Size);
+
+  // Find the segments of the current preamble that are still up to date:
+  // neither the text they cover nor the files they use have changed. A
+  // segment can only be followed by another one if it ends at the start of a
+  // line, and can only end the preamble if it ends where the new one does.
+  unsigned NumValid = 0;
+  bool Complete = false;
+  if (!Preamble.empty() && PreambleSegments.empty() &&
+      !getPreambleFile(this).empty()) {
+    // The preamble was precompiled as a whole before chaining was turned on;
+    // carry on from it as the first segment.
+    PreambleSegment Segment;
+    Segment.End = Preamble.size();
+    Segment.EndsAtStartOfLine = PreambleEndsAtStartOfLine;
+    Segment.PCHPath = getPreambleFile(this);
+    Segment.Files = FilesInPreamble;
+    Segment.TopLevelDecls = TopLevelDeclsInPreamble;
+    Segment.Diagnostics = PreambleDiagnostics;
+    Segment.NumWarnings = NumWarningsInPreamble;
+    Segment.TopLevelHashValue = PreambleTopLevelHashValue;
+    PreambleSegments.push_back(std::move(Segment));
+  }
+  if (!Preamble.empty() && !PreambleSegments.empty()) {
+    StringRef OldText(Preamble.getBufferStart(), Preamble.size());
+    size_t Common = 0;
+    size_t Limit = std::min(OldText.size(), NewText.size());
+    while (Common != Limit && OldText[Common] == NewText[Common])
+      ++Common;
+
+    OverriddenFilesMap OverriddenFiles;
+    bool AnyFileUnreadable = false;
+    if (collectOverriddenFiles(*FileMgr,
+                               PreambleInvocationIn.getPreprocessorOpts(),
+                               OverriddenFiles)) {
+      for (PreambleSegment &Segment : PreambleSegments) {
+        if (Segment.End > Common)
+          break;
+        bool EndsPreamble = Segment.End == NewText.size();
+        if (EndsPreamble ? Segment.EndsAtStartOfLine !=
+                               NewPreamble.PreambleEndsAtStartOfLine
+                         : !Segment.EndsAtStartOfLine)
+          break;
+        if (haveFilesChanged(*FileMgr, Segment.Files, OverriddenFiles,
+                             AnyFileUnreadable))
+          break;
+        ++NumValid;
+        if (EndsPreamble) {
+          Complete = true;
+          break;
+        }
+      }
+    }
+  }
+
+  if (Complete && NumValid == PreambleSegments.size()) {
+    // Okay! We can re-use the precompiled preamble.
+
+    // Set the state of the diagnostic object to mimic its state
+    // after parsing the preamble.
+    getDiagnostics().Reset();
+    ProcessWarningOptions(getDiagnostics(),
+                          PreambleInvocationIn.getDiagnosticOpts());
+    getDiagnostics().setNumWarnings(NumWarningsInPreamble);
+
+    return llvm::MemoryBuffer::getMemBufferCopy(
+        NewPreamble.Buffer->getBuffer(), MainFilename);
+  }
+
+  // If we aren't allowed to rebuild the precompiled preamble, just
+  // return now.
+  if (!AllowRebuild)
+    return nullptr;
+
+  // If the preamble rebuild counter > 1, it's because we previously
+  // failed to build a preamble and we're not yet ready to try
+  // again. Decrement the counter and return a failure.
+  if (PreambleRebuildCounter > 1) {
+    --PreambleRebuildCounter;
+    return nullptr;
+  }
+
+  SimpleTimer PreambleTimer(WantTiming);
+  PreambleTimer.setOutput("Precompiling preamble");
+
+  // Keep the chain from growing indefinitely when inclusions are added to
+  // the end of the preamble one at a time.
+  if (!Complete && NumValid >= MaxPreambleSegments)
+    NumValid = MaxPreambleSegments - 1;
+
+  // Throw away the segments that are out of date.
+  if (!NumValid)
+    erasePreambleFile(this);
+  for (unsigned I = NumValid, N = PreambleSegments.size(); I != N; ++I)
+    llvm::sys::fs::remove(PreambleSegments[I].PCHPath);
+  PreambleSegments.resize(NumValid);
+
+  // Keep track of the files the segments are stored in, so that they are
+  // erased along with the ASTUnit.
+  auto SetPreambleFiles = [this] {
+    std::vector<std::string> Files;
+    for (const PreambleSegment &Segment : PreambleSegments)
+      Files.push_back(Segment.PCHPath);
+    std::string Last;
+    if (!Files.empty()) {
+      Last = std::move(Files.back());
+      Files.pop_back();
+    }
+    setPreambleFile(this, Last);
+    setChainedPreambleFiles(this, std::move(Files));
+  };
+  SetPreambleFiles();
+
+  // Forget that we even tried, and only try again in a while.
+  auto Fail = [this](unsigned RebuildCounter) {
+    erasePreambleFile(this);
+    Preamble.clear();
+    PreambleSegments.clear();
+    PreambleDiagnostics.clear();
+    TopLevelDeclsInPreamble.clear();
+    PreambleRebuildCounter = RebuildCounter;
+  };
+
+  // Clear out old caches and data.
+  getDiagnostics().Reset();
+  ProcessWarningOptions(getDiagnostics(),
+                        PreambleInvocationIn.getDiagnosticOpts());
+  checkAndRemoveNonDriverDiags(StoredDiagnostics);
+  TopLevelDecls.clear();
+
+  // Split whatever is left of the preamble after its last top-level
+  // inclusions, using as many segments as the chain has room for.
+  unsigned Begin = NumValid ? PreambleSegments.back().End : 0;
+  SmallVector<unsigned, 8> Ends;
+  if (!Complete) {
+    Ends = findPreambleSegmentEnds(NewPreamble.Buffer->getBuffer(), Begin,
+                                   NewText.size(),
+                                   *PreambleInvocationIn.getLangOpts());
+    unsigned Room = MaxPreambleSegments - NumValid;
+    if (Ends.size() >= Room) {
+      SmallVector<unsigned, 8> Kept;
+      for (unsigned I = 1; I != Room; ++I)
+        Kept.push_back(Ends[I * Ends.size() / Room]);
+      Ends.swap(Kept);
+    }
+    Ends.push_back(NewText.size());
+  }
+
+  for (unsigned End : Ends) {
+    // Create a temporary file for the segment. In rare circumstances, this
+    // can fail.
+    std::string PCHPath = GetPreamblePCHPath();
+    if (PCHPath.empty()) {
+      // Try again next time.
+      Fail(1);
+      return nullptr;
+    }
+
+    BackgroundPreambleBuild Build;
+    Build.PCHContainerOps = PCHContainerOps;
+    Build.PCHPath = PCHPath;
+    Build.PreambleEndsAtStartOfLine =
+        End == NewText.size() ? NewPreamble.PreambleEndsAtStartOfLine : true;
+
+    auto Invocation = std::make_shared<CompilerInvocation>(PreambleInvocationIn);
+    FrontendOptions &FrontendOpts = Invocation->getFrontendOpts();
+    PreprocessorOptions &PreprocessorOpts = Invocation->getPreprocessorOpts();
+
+    // Remap the main source file to the text up to the end of the segment.
+    Build.PreambleBuffer = llvm::MemoryBuffer::getMemBufferCopy(
+        NewText.slice(0, End), MainFilename);
+    PreprocessorOpts.addRemappedFile(MainFilename, Build.PreambleBuffer.get());
+
+    // Precompile the segment on top of the previous one, skipping the part of
+    // the main file that it covers.
+    FrontendOpts.ProgramAction = frontend::GeneratePCH;
+    FrontendOpts.OutputFile = PCHPath;
+    PreprocessorOpts.PrecompiledPreambleBytes.first = Begin;
+    PreprocessorOpts.PrecompiledPreambleBytes.second = Begin != 0;
+    if (Begin) {
+      PreprocessorOpts.ImplicitPCHInclude = PreambleSegments.back().PCHPath;
+      PreprocessorOpts.DisablePCHValidation = true;
+    }
+    Build.Invocation = std::move(Invocation);
+
+    Build.run();
+    ++PreambleSegmentCounter;
+    if (!Build.Succeeded) {
+      llvm::sys::fs::remove(PCHPath);
+      Fail(DefaultPreambleRebuildInterval);
+      return nullptr;
+    }
+
+    PreambleSegment Segment;
+    Segment.End = End;
+    Segment.EndsAtStartOfLine = Build.PreambleEndsAtStartOfLine;
+    Segment.PCHPath = PCHPath;
+    Segment.Files = std::move(Build.Files);
+    Segment.TopLevelDecls = std::move(Build.TopLevelDecls);
+    Segment.Diagnostics = std::move(Build.Diagnostics);
+    Segment.NumWarnings = Build.NumWarnings;
+    Segment.TopLevelHashValue = Build.TopLevelHashValue;
+    PreambleSegments.push_back(std::move(Segment));
+    SetPreambleFiles();
+    Begin = End;
+  }
+
+  // Save the preamble text for later; we'll need to compare against it for
+  // subsequent reparses.
+  Preamble.assign(FileMgr->getFile(MainFilename), NewText.begin(),
+                  NewText.end());
+  PreambleEndsAtStartOfLine = NewPreamble.PreambleEndsAtStartOfLine;
+  OriginalSourceFile = MainFilename;
+  if (!Ends.empty())
+    ++PreambleCounter;
   PreambleRebuildCounter = 1;
-  PreprocessorOpts.RemappedFileBuffers.pop_back();
+
+  // Put together what the segments know about the preamble as a whole.
+  PreambleDiagnostics.clear();
+  TopLevelDeclsInPreamble.clear();
+  FilesInPreamble.clear();
+  NumWarningsInPreamble = 0;
+  CurrentTopLevelHashValue = 0;
+  for (const PreambleSegment &Segment : PreambleSegments) {
+    PreambleDiagnostics.append(Segment.Diagnostics.begin(),
+                               Segment.Diagnostics.end());
+    TopLevelDeclsInPreamble.insert(TopLevelDeclsInPreamble.end(),
+                                   Segment.TopLevelDecls.begin(),
+                                   Segment.TopLevelDecls.end());
+    for (const auto &F : Segment.Files)
+      FilesInPreamble[F.first()] = F.second;
+    NumWarningsInPreamble += Segment.NumWarnings;
+    CurrentTopLevelHashValue =
+        llvm::hash_combine(CurrentTopLevelHashValue, Segment.TopLevelHashValue);
+  }
+
+  // Set the state of the diagnostic object to mimic its state
+  // after parsing the preamble.
+  getDiagnostics().Reset();
+  ProcessWarningOptions(getDiagnostics(),
+                        PreambleInvocationIn.getDiagnosticOpts());
+  getDiagnostics().setNumWarnings(NumWarningsInPreamble);
 
   // If the hash of top-level entities differs from the hash of the top-level
   // entities the last time we rebuilt the preamble, clear out the completion
@@ -1634,6 +2278,14 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
                                               MainFilename);
 }
 
+void ASTUnit::setBuildPreambleInBackground(bool Enable) {
+#if LLVM_ENABLE_THREADS
+  BuildPreambleInBackground = Enable;
+#else
+  (void)Enable;
+#endif
+}
+
 void ASTUnit::RealizeTopLevelDeclsFromPreamble() {
   std::vector<Decl *> Resolved;
   Resolved.reserve(TopLevelDeclsInPreamble.size());
@@ -2040,6 +2692,9 @@ bool ASTUnit::Reparse(std::shared_ptr<PCHContainerOperations> PCHContainerOps,
                                                       RemappedFile.second);
   }
 
+  // Switch to the preamble built in the background, if it's ready.
+  adoptBackgroundPreamble();
+
   // If we have a preamble file lying around, or if we might try to
   // build a precompiled preamble, do so now.
   std::unique_ptr<llvm::MemoryBuffer> OverrideMainBuffer;
@@ -11,6 +11,8 @@
 #include "clang/AST/ASTConsumer.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/Decl.h"
+#include "clang/AST/Stmt.h"
+#include "clang/Basic/CharInfo.h"
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Basic/FileManager.h"
 #include "clang/Basic/MemoryBufferCache.h"
@@ -33,9 +35,15 @@
 #include "clang/Lex/PreprocessorOptions.h"
 #include "clang/Sema/CodeCompleteConsumer.h"
 #include "clang/Sema/Sema.h"
+#include "clang/Sema/TemplateProfiler.h"
 #include "clang/Serialization/ASTReader.h"
 #include "clang/Serialization/GlobalModuleIndex.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/Support/CrashRecoveryContext.h"
 #include "llvm/Support/Errc.h"
 #include "llvm/Support/FileSystem.h"
@@ -44,9 +52,15 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Program.h"
+#include "llvm/Support/SHA1.h"
 #include "llvm/Support/Signals.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <set>
 #include <sys/stat.h>
 #include <system_error>
 #include <time.h>
@@ -631,6 +645,9 @@ void CompilerInstance::createSema(TranslationUnitKind TUKind,
                                   CodeCompleteConsumer *CompletionConsumer) {
   TheSema.reset(new Sema(getPreprocessor(), getASTContext(), getASTConsumer(),
                          TUKind, CompletionConsumer));
+  if (!getFrontendOpts().TemplateProfileFile.empty())
+    TheSema->setTemplateProfiler(
+        llvm::make_unique<TemplateProfiler>(getASTContext()));
   // Attach the external sema source if there is any.
   if (ExternalSemaSrc) {
     TheSema->addExternalSource(ExternalSemaSrc.get());
@@ -910,6 +927,234 @@ bool CompilerInstance::InitializeSourceManager(
   return true;
 }
 
+// Module Cache
+
+/// \brief The name of the directory, within the module cache, that holds the
+/// content-addressed store of module files.
+static const char ModuleCacheStoreDir[] = "store";
+
+/// \brief Call \p Fn for each module file in the module cache at \p CachePath,
+/// with its status and whether it is in the content store.
+static void forEachCachedModuleFile(
+    StringRef CachePath,
+    llvm::function_ref<void(StringRef, const llvm::sys::fs::file_status &,
+                            bool)> Fn) {
+  std::error_code EC;
+  SmallString<128> CachePathNative;
+  llvm::sys::path::native(CachePath, CachePathNative);
+  for (llvm::sys::fs::directory_iterator Dir(CachePathNative, EC), DirEnd;
+       Dir != DirEnd && !EC; Dir.increment(EC)) {
+    if (!llvm::sys::fs::is_directory(Dir->path()))
+      continue;
+    bool InStore = llvm::sys::path::filename(Dir->path()) == ModuleCacheStoreDir;
+
+    for (llvm::sys::fs::directory_iterator File(Dir->path(), EC), FileEnd;
+         File != FileEnd && !EC; File.increment(EC)) {
+      if (llvm::sys::path::extension(File->path()) != ".pcm")
+        continue;
+      llvm::sys::fs::file_status Status;
+      if (llvm::sys::fs::status(File->path(), Status))
+        continue;
+      Fn(File->path(), Status, InStore);
+    }
+  }
+}
+
+/// \brief The suffix of the file next to a module file in the module cache
+/// whose modification time records when the module file was last used.
+///
+/// Access times can't be relied upon for this, since file systems are often
+/// mounted noatime or relatime, and the module file's own modification time
+/// is checked by the module files that import it.
+static const char ModuleFileUseSuffix[] = ".used";
+
+/// \brief Determine when the module file at \p Path, with status \p Status,
+/// was last used: when it was last marked as used, or else when it was
+/// written.
+static time_t getModuleFileLastUse(StringRef Path,
+                                   const llvm::sys::fs::file_status &Status) {
+  time_t LastUse = llvm::sys::toTimeT(Status.getLastModificationTime());
+  llvm::sys::fs::file_status UseStatus;
+  if (!llvm::sys::fs::status(Path + ModuleFileUseSuffix, UseStatus))
+    LastUse = std::max(
+        LastUse, llvm::sys::toTimeT(UseStatus.getLastModificationTime()));
+  return LastUse;
+}
+
+/// \brief Mark the module files that \p Reader loaded from the module cache
+/// as used now.
+static void markModuleFilesUsed(ASTReader &Reader) {
+  time_t CurrentTime = time(nullptr);
+  for (ModuleFile &MF : Reader.getModuleManager()) {
+    if (MF.Kind != serialization::MK_ImplicitModule)
+      continue;
+
+    // Refreshing a mark at most once a minute keeps this to a stat() for each
+    // module file in a busy build.
+    std::string UseFile = MF.FileName + ModuleFileUseSuffix;
+    llvm::sys::fs::file_status Status;
+    if (!llvm::sys::fs::status(UseFile, Status) &&
+        CurrentTime -
+                llvm::sys::toTimeT(Status.getLastModificationTime()) < 60)
+      continue;
+
+    std::error_code EC;
+    llvm::raw_fd_ostream Out(UseFile, EC, llvm::sys::fs::F_None);
+  }
+}
+
+/// \brief Make the module file just written to \p ModuleFileName share its
+/// storage with an identical module file in the module cache's content
+/// store, or else add it to the store.
+///
+/// Module files are stored under the hash of their contents, and linked into
+/// the directories of each configuration that produced them. Only module
+/// files whose signature is a hash of their AST blocks are shared; imports of
+/// those are validated by signature rather than by size and modification
+/// time, so replacing one by an identical file is invisible to importers.
+///
+/// \returns true if an identical module file was already in the store.
+static bool shareModuleFile(const HeaderSearchOptions &HSOpts,
+                            const PCHContainerReader &PCHContainerRdr,
+                            StringRef ModuleFileName) {
+  SmallString<128> StorePath(HSOpts.ModuleCachePath);
+  llvm::sys::path::append(StorePath, ModuleCacheStoreDir);
+  ASTFileSignature Signature;
+  uint64_t Size;
+  {
+    auto Buffer = llvm::MemoryBuffer::getFile(
+        ModuleFileName, /*FileSize=*/-1, /*RequiresNullTerminator=*/false);
+    if (!Buffer)
+      return false;
+    Signature =
+        ASTReader::readASTFileSignature(PCHContainerRdr.ExtractPCH(**Buffer));
+    if (!Signature)
+      return false;
+    Size = (*Buffer)->getBufferSize();
+
+    StringRef Bytes = (*Buffer)->getBuffer();
+    llvm::SHA1 Hasher;
+    Hasher.update(ArrayRef<uint8_t>(Bytes.bytes_begin(), Bytes.size()));
+    llvm::sys::path::append(StorePath, llvm::toHex(Hasher.result()) + ".pcm");
+  }
+
+  if (llvm::sys::fs::exists(StorePath)) {
+    // Don't trust the store blindly; a damaged file there is replaced below.
+    bool Matches = false;
+    if (auto Stored = llvm::MemoryBuffer::getFile(
+            StorePath, /*FileSize=*/-1, /*RequiresNullTerminator=*/false))
+      Matches = (*Stored)->getBufferSize() == Size &&
+                ASTReader::readASTFileSignature(
+                    PCHContainerRdr.ExtractPCH(**Stored)) == Signature;
+
+    if (Matches) {
+      // We hold the lock on the module file, so nobody else is using this
+      // name. Link and rename, so that the module file is never missing.
+      SmallString<128> TempPath(ModuleFileName);
+      TempPath += ".shared";
+      llvm::sys::fs::remove(TempPath);
+      if (!llvm::sys::fs::create_hard_link(StorePath, TempPath) &&
+          !llvm::sys::fs::rename(TempPath, ModuleFileName))
+        return true;
+      llvm::sys::fs::remove(TempPath);
+      return false;
+    }
+    llvm::sys::fs::remove(StorePath);
+  }
+
+  // Failing to add the module file to the store (e.g., because the file
+  // system doesn't support hard links) only costs us the sharing.
+  llvm::sys::fs::create_directories(llvm::sys::path::parent_path(StorePath));
+  llvm::sys::fs::create_hard_link(ModuleFileName, StorePath);
+  return false;
+}
+
+/// \brief Evict the least recently used module files from the module cache
+/// until it fits within HeaderSearchOptions::ModuleCacheSizeLimit.
+///
+/// \returns the number of module files evicted.
+static unsigned evictFromModuleCache(const HeaderSearchOptions &HSOpts) {
+  // Group the cached module files by the file they are a name for, so that
+  // a module file shared through the store is counted, and evicted, once.
+  struct CachedModuleFile {
+    SmallVector<std::string, 2> Paths;
+    uint64_t Size;
+    time_t LastUse = 0;
+  };
+  std::map<llvm::sys::fs::UniqueID, CachedModuleFile> Files;
+  uint64_t TotalSize = 0;
+  forEachCachedModuleFile(
+      HSOpts.ModuleCachePath,
+      [&](StringRef Path, const llvm::sys::fs::file_status &Status,
+          bool InStore) {
+        CachedModuleFile &File = Files[Status.getUniqueID()];
+        if (File.Paths.empty()) {
+          File.Size = Status.getSize();
+          TotalSize += File.Size;
+        }
+        File.LastUse =
+            std::max(File.LastUse, getModuleFileLastUse(Path, Status));
+        File.Paths.push_back(Path);
+      });
+
+  uint64_t SizeLimit = uint64_t(HSOpts.ModuleCacheSizeLimit) << 20;
+  if (TotalSize <= SizeLimit)
+    return 0;
+
+  std::vector<CachedModuleFile *> LRU;
+  for (auto &File : Files)
+    LRU.push_back(&File.second);
+  std::sort(LRU.begin(), LRU.end(),
+            [](const CachedModuleFile *LHS, const CachedModuleFile *RHS) {
+              return LHS->LastUse < RHS->LastUse;
+            });
+
+  unsigned NumEvicted = 0;
+  for (CachedModuleFile *File : LRU) {
+    if (TotalSize <= SizeLimit)
+      break;
+    for (const std::string &Path : File->Paths) {
+      llvm::sys::fs::remove(Path);
+      llvm::sys::fs::remove(Path + ".timestamp");
+      llvm::sys::fs::remove(Path + ModuleFileUseSuffix);
+    }
+    TotalSize -= File->Size;
+    ++NumEvicted;
+  }
+  return NumEvicted;
+}
+
+/// \brief Print the statistics reported by -module-cache-stats.
+static void printModuleCacheStats(const HeaderSearchOptions &HSOpts,
+                                  const ModuleCacheStatistics &Stats,
+                                  raw_ostream &OS) {
+  unsigned NumModuleFiles = 0, NumStoredFiles = 0;
+  uint64_t Size = 0, DiskSize = 0;
+  std::set<llvm::sys::fs::UniqueID> SeenFiles;
+  forEachCachedModuleFile(
+      HSOpts.ModuleCachePath,
+      [&](StringRef Path, const llvm::sys::fs::file_status &Status,
+          bool InStore) {
+        if (InStore) {
+          ++NumStoredFiles;
+        } else {
+          ++NumModuleFiles;
+          Size += Status.getSize();
+        }
+        if (SeenFiles.insert(Status.getUniqueID()).second)
+          DiskSize += Status.getSize();
+      });
+
+  OS << "*** Module Cache Stats:\n";
+  OS << "  " << NumModuleFiles << " module files (" << Size << " bytes)\n";
+  OS << "  " << NumStoredFiles << " module files in the content store\n";
+  OS << "  " << SeenFiles.size() << " distinct files on disk (" << DiskSize
+     << " bytes)\n";
+  OS << "  " << Stats.NumModulesBuilt << " modules built, "
+     << Stats.NumModulesShared << " identical to a stored module\n";
+  OS << "  " << Stats.NumModuleFilesEvicted << " module files evicted\n";
+}
+
 // High-Level Operations
 
 bool CompilerInstance::ExecuteAction(FrontendAction &Act) {
@@ -960,6 +1205,13 @@ bool CompilerInstance::ExecuteAction(FrontendAction &Act) {
   if (getFrontendOpts().ShowStats || !getFrontendOpts().StatsFile.empty())
     llvm::EnableStatistics(false);
 
+  // The memory report breaks the AST nodes down by kind. Count them from the
+  // start, since Sema and the predefines create some before parsing begins.
+  if (getFrontendOpts().ShowASTMemoryReport) {
+    Decl::EnableStatistics();
+    Stmt::EnableStatistics();
+  }
+
   for (const FrontendInputFile &FIF : getFrontendOpts().Inputs) {
     // Reset the ID tables if we are reusing the SourceManager and parsing
     // regular files.
@@ -998,6 +1250,21 @@ bool CompilerInstance::ExecuteAction(FrontendAction &Act) {
     }
     llvm::PrintStatistics(OS);
   }
+
+  // Trimming the module cache, and reporting on it, is left to the outermost
+  // compiler instance; instances building modules report to it.
+  const HeaderSearchOptions &HSOpts = getHeaderSearchOpts();
+  if (!getFrontendOpts().BuildingImplicitModule &&
+      !HSOpts.ModuleCachePath.empty()) {
+    if (HSOpts.ModuleCacheSizeLimit > 0) {
+      if (ModuleManager)
+        markModuleFilesUsed(*ModuleManager);
+      if (ModuleCacheStats.NumModulesBuilt)
+        ModuleCacheStats.NumModuleFilesEvicted += evictFromModuleCache(HSOpts);
+    }
+    if (getFrontendOpts().ShowModuleCacheStats)
+      printModuleCacheStats(HSOpts, ModuleCacheStats, OS);
+  }
   StringRef StatsFile = getFrontendOpts().StatsFile;
   if (!StatsFile.empty()) {
     std::error_code EC;
@@ -1026,13 +1293,16 @@ static InputKind::Language getLanguageFromOptions(const LangOptions &LangOpts) {
   return LangOpts.CPlusPlus ? InputKind::CXX : InputKind::C;
 }
 
-/// \brief Compile a module file for the given module, using the options 
-/// provided by the importing compiler instance. Returns true if the module
-/// was built without errors.
-static bool compileModuleImpl(CompilerInstance &ImportingInstance,
-                              SourceLocation ImportLoc,
-                              Module *Module,
-                              StringRef ModuleFileName) {
+/// \brief Construct the invocation that builds the module file for the given
+/// module, using the options provided by the importing compiler instance.
+///
+/// If the module has no module map file of its own, its inferred module map
+/// is printed into \p InferredModuleMapContent, and the caller must make it
+/// available as the contents of the invocation's input file.
+static std::shared_ptr<CompilerInvocation>
+createModuleBuildInvocation(CompilerInstance &ImportingInstance,
+                            Module *Module, StringRef ModuleFileName,
+                            std::string &InferredModuleMapContent) {
   ModuleMap &ModMap 
     = ImportingInstance.getPreprocessor().getHeaderSearchInfo().getModuleMap();
     
@@ -1062,16 +1332,6 @@ static bool compileModuleImpl(CompilerInstance &ImportingInstance,
   // Note the name of the module we're building.
   Invocation->getLangOpts()->CurrentModule = Module->getTopLevelModuleName();
 
-  // Make sure that the failed-module structure has been allocated in
-  // the importing instance, and propagate the pointer to the newly-created
-  // instance.
-  PreprocessorOptions &ImportingPPOpts
-    = ImportingInstance.getInvocation().getPreprocessorOpts();
-  if (!ImportingPPOpts.FailedModules)
-    ImportingPPOpts.FailedModules =
-        std::make_shared<PreprocessorOptions::FailedModulesSet>();
-  PPOpts.FailedModules = ImportingPPOpts.FailedModules;
-
   // If there is a module map file, build the module using the module map.
   // Set up the inputs/outputs so that we build the module from its umbrella
   // header.
@@ -1080,10 +1340,17 @@ static bool compileModuleImpl(CompilerInstance &ImportingInstance,
   FrontendOpts.DisableFree = false;
   FrontendOpts.GenerateGlobalModuleIndex = false;
   FrontendOpts.BuildingImplicitModule = true;
+  // Only the importing compilation writes a template profile or memory report.
+  FrontendOpts.TemplateProfileFile.clear();
+  FrontendOpts.ShowASTMemoryReport = false;
   FrontendOpts.OriginalModuleMap =
       ModMap.getModuleMapFileForUniquing(Module)->getName();
   // Force implicitly-built modules to hash the content of the module file.
   HSOpts.ModulesHashContent = true;
+  // The importing compiler has already built, several at a time, whichever
+  // of this module's imports it could find; leave the rest to the usual
+  // one-at-a-time builds.
+  HSOpts.ModuleBuildJobs = 1;
   FrontendOpts.Inputs.clear();
   InputKind IK(getLanguageFromOptions(*Invocation->getLangOpts()),
                InputKind::ModuleMap);
@@ -1094,14 +1361,74 @@ static bool compileModuleImpl(CompilerInstance &ImportingInstance,
   Invocation->getDiagnosticOpts().VerifyDiagnostics = 0;
   assert(ImportingInstance.getInvocation().getModuleHash() ==
          Invocation->getModuleHash() && "Module hash mismatch!");
-  
+
+  // We don't want to produce any dependency output from the module build.
+  Invocation->getDependencyOutputOpts() = DependencyOutputOptions();
+
+  // Get or create the module map that we'll use to build this module.
+  if (const FileEntry *ModuleMapFile =
+          ModMap.getContainingModuleMapFile(Module)) {
+    // Use the module map where this module resides.
+    FrontendOpts.Inputs.emplace_back(ModuleMapFile->getName(), IK,
+                                     +Module->IsSystem);
+  } else {
+    SmallString<128> FakeModuleMapFile(Module->Directory->getName());
+    llvm::sys::path::append(FakeModuleMapFile, "__inferred_module.map");
+    FrontendOpts.Inputs.emplace_back(FakeModuleMapFile, IK, +Module->IsSystem);
+
+    llvm::raw_string_ostream OS(InferredModuleMapContent);
+    Module->print(OS);
+    OS.flush();
+  }
+
+  return Invocation;
+}
+
+/// \brief Make the inferred module map printed by createModuleBuildInvocation,
+/// if any, the contents of \p Instance's input file.
+static void setUpInferredModuleMap(CompilerInstance &Instance,
+                                   const std::string &InferredModuleMapContent) {
+  if (InferredModuleMapContent.empty())
+    return;
+
+  StringRef FakeModuleMapFile =
+      Instance.getFrontendOpts().Inputs[0].getFile();
+  std::unique_ptr<llvm::MemoryBuffer> ModuleMapBuffer =
+      llvm::MemoryBuffer::getMemBuffer(InferredModuleMapContent);
+  const FileEntry *ModuleMapFile = Instance.getFileManager().getVirtualFile(
+      FakeModuleMapFile, InferredModuleMapContent.size(), 0);
+  Instance.getSourceManager().overrideFileContents(ModuleMapFile,
+                                                   std::move(ModuleMapBuffer));
+}
+
+/// \brief Compile a module file for the given module, using the options 
+/// provided by the importing compiler instance. Returns true if the module
+/// was built without errors.
+static bool compileModuleImpl(CompilerInstance &ImportingInstance,
+                              SourceLocation ImportLoc,
+                              Module *Module,
+                              StringRef ModuleFileName) {
+  std::string InferredModuleMapContent;
+  std::shared_ptr<CompilerInvocation> Invocation = createModuleBuildInvocation(
+      ImportingInstance, Module, ModuleFileName, InferredModuleMapContent);
+
+  // Make sure that the failed-module structure has been allocated in
+  // the importing instance, and propagate the pointer to the newly-created
+  // instance.
+  PreprocessorOptions &ImportingPPOpts
+    = ImportingInstance.getInvocation().getPreprocessorOpts();
+  if (!ImportingPPOpts.FailedModules)
+    ImportingPPOpts.FailedModules =
+        std::make_shared<PreprocessorOptions::FailedModulesSet>();
+  Invocation->getPreprocessorOpts().FailedModules =
+      ImportingPPOpts.FailedModules;
+
   // Construct a compiler instance that will be used to actually create the
   // module.  Since we're sharing a PCMCache,
   // CompilerInstance::CompilerInstance is responsible for finalizing the
   // buffers to prevent use-after-frees.
   CompilerInstance Instance(ImportingInstance.getPCHContainerOperations(),
                             &ImportingInstance.getPreprocessor().getPCMCache());
-  auto &Inv = *Invocation;
   Instance.setInvocation(std::move(Invocation));
 
   Instance.createDiagnostics(new ForwardingDiagnosticConsumer(
@@ -1121,33 +1448,10 @@ static bool compileModuleImpl(CompilerInstance &ImportingInstance,
     FullSourceLoc(ImportLoc, ImportingInstance.getSourceManager()));
 
   // If we're collecting module dependencies, we need to share a collector
-  // between all of the module CompilerInstances. Other than that, we don't
-  // want to produce any dependency output from the module build.
+  // between all of the module CompilerInstances.
   Instance.setModuleDepCollector(ImportingInstance.getModuleDepCollector());
-  Inv.getDependencyOutputOpts() = DependencyOutputOptions();
 
-  // Get or create the module map that we'll use to build this module.
-  std::string InferredModuleMapContent;
-  if (const FileEntry *ModuleMapFile =
-          ModMap.getContainingModuleMapFile(Module)) {
-    // Use the module map where this module resides.
-    FrontendOpts.Inputs.emplace_back(ModuleMapFile->getName(), IK,
-                                     +Module->IsSystem);
-  } else {
-    SmallString<128> FakeModuleMapFile(Module->Directory->getName());
-    llvm::sys::path::append(FakeModuleMapFile, "__inferred_module.map");
-    FrontendOpts.Inputs.emplace_back(FakeModuleMapFile, IK, +Module->IsSystem);
-
-    llvm::raw_string_ostream OS(InferredModuleMapContent);
-    Module->print(OS);
-    OS.flush();
-
-    std::unique_ptr<llvm::MemoryBuffer> ModuleMapBuffer =
-        llvm::MemoryBuffer::getMemBuffer(InferredModuleMapContent);
-    ModuleMapFile = Instance.getFileManager().getVirtualFile(
-        FakeModuleMapFile, InferredModuleMapContent.size(), 0);
-    SourceMgr.overrideFileContents(ModuleMapFile, std::move(ModuleMapBuffer));
-  }
+  setUpInferredModuleMap(Instance, InferredModuleMapContent);
 
   ImportingInstance.getDiagnostics().Report(ImportLoc,
                                             diag::remark_module_build)
@@ -1180,7 +1484,18 @@ static bool compileModuleImpl(CompilerInstance &ImportingInstance,
     ImportingInstance.setBuildGlobalModuleIndex(true);
   }
 
-  return !Instance.getDiagnostics().hasErrorOccurred();
+  bool Success = !Instance.getDiagnostics().hasErrorOccurred();
+  ModuleCacheStatistics &Stats = ImportingInstance.getModuleCacheStats();
+  Stats.add(Instance.getModuleCacheStats());
+  if (Success)
+    ++Stats.NumModulesBuilt;
+  if (Success && Instance.getHeaderSearchOpts().ModuleCacheShareIdentical &&
+      shareModuleFile(Instance.getHeaderSearchOpts(),
+                      ImportingInstance.getPCHContainerReader(),
+                      ModuleFileName))
+    ++Stats.NumModulesShared;
+
+  return Success;
 }
 
 static bool compileAndLoadModule(CompilerInstance &ImportingInstance,
@@ -1266,6 +1581,358 @@ static bool compileAndLoadModule(CompilerInstance &ImportingInstance,
   }
 }
 
+#if LLVM_ENABLE_THREADS
+/// \brief Find the headers named by the inclusion directives in \p Buffer, and
+/// the modules named by its \@import declarations, without preprocessing it.
+///
+/// Conditional directives are ignored, so this over-approximates what
+/// building the file would actually include.
+static void
+scanForInclusions(StringRef Buffer,
+                  SmallVectorImpl<std::pair<StringRef, bool>> &Includes,
+                  SmallVectorImpl<StringRef> &ModuleNames) {
+  while (!Buffer.empty()) {
+    StringRef Line;
+    std::tie(Line, Buffer) = Buffer.split('\n');
+    Line = Line.ltrim();
+
+    if (Line.consume_front("@import")) {
+      if (Line.empty() || !isWhitespace(Line[0]))
+        continue;
+      StringRef Name = Line.ltrim().take_while(
+          [](char C) { return isIdentifierBody(C); });
+      if (!Name.empty())
+        ModuleNames.push_back(Name);
+      continue;
+    }
+
+    if (!Line.consume_front("#"))
+      continue;
+    Line = Line.ltrim();
+    if (!Line.consume_front("include") && !Line.consume_front("import"))
+      continue;
+    Line = Line.ltrim();
+
+    char Terminator;
+    if (Line.consume_front("<"))
+      Terminator = '>';
+    else if (Line.consume_front("\""))
+      Terminator = '"';
+    else
+      continue;
+    size_t End = Line.find(Terminator);
+    if (End == 0 || End == StringRef::npos)
+      continue;
+    Includes.push_back(std::make_pair(Line.substr(0, End), Terminator == '>'));
+  }
+}
+
+/// \brief Collect the top-level modules that building \p M is likely to
+/// import: those named by its use declarations and by \@import declarations
+/// in its headers, and those owning the headers that its headers, or the
+/// non-modular headers they include, include.
+///
+/// This is only a hint, so it is limited to the module maps that are already
+/// loaded: loading one here would report its errors, and never again when
+/// the module map is needed for real. Headers of modules whose module maps
+/// aren't loaded yet are scanned as if they were non-modular.
+static void findLikelyImports(CompilerInstance &CI, Module *M,
+                              SmallVectorImpl<Module *> &Imports) {
+  HeaderSearch &HS = CI.getPreprocessor().getHeaderSearchInfo();
+  ModuleMap &ModMap = HS.getModuleMap();
+  Module *TopModule = M->getTopLevelModule();
+
+  llvm::SmallPtrSet<Module *, 8> SeenModules;
+  SeenModules.insert(TopModule);
+  auto AddImport = [&](Module *Imported) {
+    if (!Imported)
+      return;
+    Imported = Imported->getTopLevelModule();
+    if (SeenModules.insert(Imported).second)
+      Imports.push_back(Imported);
+  };
+
+  SmallVector<const FileEntry *, 16> Worklist;
+  llvm::SmallPtrSet<const FileEntry *, 16> SeenFiles;
+  auto AddFile = [&](const FileEntry *File) {
+    if (File && SeenFiles.insert(File).second)
+      Worklist.push_back(File);
+  };
+
+  SmallVector<Module *, 8> Modules(1, TopModule);
+  for (unsigned I = 0; I != Modules.size(); ++I) {
+    Module *Sub = Modules[I];
+    if (!Sub->isAvailable())
+      continue;
+    Modules.append(Sub->submodule_begin(), Sub->submodule_end());
+
+    ModMap.resolveUses(Sub, /*Complain=*/false);
+    for (Module *Used : Sub->DirectUses)
+      AddImport(Used);
+
+    AddFile(Sub->getUmbrellaHeader().Entry);
+    for (unsigned Kind = 0; Kind != Module::HK_Excluded; ++Kind)
+      for (const Module::Header &H : Sub->Headers[Kind])
+        AddFile(H.Entry);
+  }
+
+  while (!Worklist.empty()) {
+    const FileEntry *File = Worklist.pop_back_val();
+    auto Buffer = CI.getFileManager().getBufferForFile(File);
+    if (!Buffer)
+      continue;
+
+    SmallVector<std::pair<StringRef, bool>, 16> Includes;
+    SmallVector<StringRef, 4> ModuleNames;
+    scanForInclusions((*Buffer)->getBuffer(), Includes, ModuleNames);
+
+    for (StringRef Name : ModuleNames)
+      AddImport(HS.lookupModule(Name, /*AllowSearch=*/false));
+
+    // Without a requesting or suggested module, header search neither loads
+    // module maps nor diagnoses anything; with a single includer, it doesn't
+    // compare against MSVC's search either.
+    std::pair<const FileEntry *, const DirectoryEntry *> Includer(
+        File, File->getDir());
+    for (const auto &Include : Includes) {
+      const DirectoryLookup *CurDir = nullptr;
+      const FileEntry *Included = HS.LookupFile(
+          Include.first, SourceLocation(), /*isAngled=*/Include.second,
+          /*FromDir=*/nullptr, CurDir, Includer, /*SearchPath=*/nullptr,
+          /*RelativePath=*/nullptr, /*RequestingModule=*/nullptr,
+          /*SuggestedModule=*/nullptr, /*IsMapped=*/nullptr);
+      if (!Included)
+        continue;
+      ModuleMap::KnownHeader Owner = HS.findModuleForHeader(Included);
+      if (Owner && Owner.getModule()->getTopLevelModule() != TopModule)
+        AddImport(Owner.getModule());
+      else
+        AddFile(Included);
+    }
+  }
+}
+
+namespace {
+
+/// \brief A module that a module about to be built is likely to import, and
+/// which is missing from the module cache.
+struct ModulePrebuildJob {
+  std::string ModuleName;
+  std::string ModuleFileName;
+  std::shared_ptr<CompilerInvocation> Invocation;
+  std::string InferredModuleMapContent;
+
+  /// \brief The jobs for modules that are likely to import this one.
+  SmallVector<unsigned, 4> Dependents;
+
+  /// \brief The number of modules this one is likely to import that are yet
+  /// to be built.
+  unsigned PendingDependencies = 0;
+
+  /// \brief Whether this thread built the module, rather than finding
+  /// another compiler building it or failing to build it.
+  bool Built = false;
+
+  /// \brief The module builds this job performed.
+  ModuleCacheStatistics Stats;
+};
+
+} // end anonymous namespace
+
+/// \brief Build the module described by \p Job, on a worker thread, following
+/// the same lock file protocol as compileAndLoadModule.
+///
+/// The build is speculative, so its diagnostics are discarded. If it fails,
+/// the module is built again, and its errors reported, when it is actually
+/// imported.
+static void prebuildModule(ModulePrebuildJob &Job,
+                           std::shared_ptr<PCHContainerOperations> PCHOps,
+                           IntrusiveRefCntPtr<vfs::FileSystem> VFS) {
+  llvm::sys::fs::create_directories(
+      llvm::sys::path::parent_path(Job.ModuleFileName));
+
+  while (1) {
+    llvm::LockFileManager Locked(Job.ModuleFileName);
+    switch (Locked) {
+    case llvm::LockFileManager::LFS_Error:
+      Locked.unsafeRemoveLockFile();
+      // FALLTHROUGH
+    case llvm::LockFileManager::LFS_Owned:
+      break;
+
+    case llvm::LockFileManager::LFS_Shared:
+      // Someone else is building the module; unless they died, there is
+      // nothing left for us to do.
+      if (Locked.waitForUnlock() == llvm::LockFileManager::Res_OwnerDied)
+        continue;
+      return;
+    }
+
+    // Nothing is shared with the importing compiler instance except the
+    // file system, so nothing else needs to be thread-safe.
+    CompilerInstance Instance(std::move(PCHOps));
+    Instance.setInvocation(Job.Invocation);
+    Instance.createDiagnostics(new IgnoringDiagConsumer,
+                               /*ShouldOwnClient=*/true);
+    Instance.setVirtualFileSystem(std::move(VFS));
+    Instance.createFileManager();
+    Instance.createSourceManager(Instance.getFileManager());
+    Instance.getSourceManager().pushModuleBuildStack(Job.ModuleName,
+                                                     FullSourceLoc());
+    setUpInferredModuleMap(Instance, Job.InferredModuleMapContent);
+
+    const unsigned ThreadStackSize = 8 << 20;
+    llvm::CrashRecoveryContext CRC;
+    bool Ran = CRC.RunSafelyOnThread(
+        [&]() {
+          GenerateModuleFromModuleMapAction Action;
+          Instance.ExecuteAction(Action);
+        },
+        ThreadStackSize);
+
+    Instance.clearOutputFiles(/*EraseFiles=*/true);
+    Job.Stats.add(Instance.getModuleCacheStats());
+
+    // Leave a module that failed to build to be built on demand, which
+    // reports why.
+    if (!Ran || Instance.getDiagnostics().hasErrorOccurred())
+      return;
+
+    Job.Built = true;
+    ++Job.Stats.NumModulesBuilt;
+    if (Instance.getHeaderSearchOpts().ModuleCacheShareIdentical &&
+        shareModuleFile(Instance.getHeaderSearchOpts(),
+                        Instance.getPCHContainerReader(), Job.ModuleFileName))
+      ++Job.Stats.NumModulesShared;
+    return;
+  }
+}
+
+/// \brief Before building \p M, build the missing modules it is likely to
+/// import, up to HeaderSearchOptions::ModuleBuildJobs at a time, each after
+/// the missing modules it is likely to import in turn.
+static void prebuildModuleImports(CompilerInstance &ImportingInstance,
+                                  SourceLocation ImportLoc, Module *M) {
+  HeaderSearch &HS = ImportingInstance.getPreprocessor().getHeaderSearchInfo();
+  PreprocessorOptions &PPOpts = ImportingInstance.getPreprocessorOpts();
+
+  // Discover the modules to build, and the order to build them in.
+  std::vector<ModulePrebuildJob> Jobs;
+  llvm::DenseMap<Module *, unsigned> JobForModule;
+  SmallVector<Module *, 16> Worklist(1, M);
+  while (!Worklist.empty()) {
+    Module *Importer = Worklist.pop_back_val();
+    SmallVector<Module *, 8> Imports;
+    findLikelyImports(ImportingInstance, Importer, Imports);
+
+    for (Module *Imported : Imports) {
+      if (Imported == M || !Imported->isAvailable() ||
+          Imported->getASTFile())
+        continue;
+      if (PPOpts.FailedModules &&
+          PPOpts.FailedModules->hasAlreadyFailed(Imported->Name))
+        continue;
+
+      unsigned ImportedJob;
+      auto Known = JobForModule.find(Imported);
+      if (Known != JobForModule.end()) {
+        ImportedJob = Known->second;
+      } else {
+        // Only modules missing from the cache are built here; anything else
+        // is validated, and rebuilt if need be, when it is imported.
+        std::string ModuleFileName = HS.getModuleFileName(Imported);
+        if (ModuleFileName.empty() || llvm::sys::fs::exists(ModuleFileName))
+          continue;
+
+        ModulePrebuildJob Job;
+        Job.ModuleName = Imported->Name;
+        Job.ModuleFileName = ModuleFileName;
+        Job.Invocation = createModuleBuildInvocation(
+            ImportingInstance, Imported, ModuleFileName,
+            Job.InferredModuleMapContent);
+        // Failures here are not final, so don't record them, and don't let
+        // the builds write the importer's diagnostic files.
+        Job.Invocation->getPreprocessorOpts().FailedModules = nullptr;
+        Job.Invocation->getDiagnosticOpts().DiagnosticLogFile.clear();
+        Job.Invocation->getDiagnosticOpts().DiagnosticSerializationFile.clear();
+        ImportedJob = Jobs.size();
+        JobForModule[Imported] = ImportedJob;
+        Jobs.push_back(std::move(Job));
+        Worklist.push_back(Imported);
+      }
+
+      if (Importer != M) {
+        unsigned ImporterJob = JobForModule[Importer];
+        Jobs[ImportedJob].Dependents.push_back(ImporterJob);
+        ++Jobs[ImporterJob].PendingDependencies;
+      }
+    }
+  }
+
+  if (Jobs.empty())
+    return;
+
+  std::shared_ptr<PCHContainerOperations> PCHOps =
+      ImportingInstance.getPCHContainerOperations();
+  IntrusiveRefCntPtr<vfs::FileSystem> VFS =
+      &ImportingInstance.getVirtualFileSystem();
+
+  std::mutex FinishedMutex;
+  std::condition_variable FinishedCondition;
+  SmallVector<unsigned, 16> FinishedJobs;
+  unsigned Outstanding = 0;
+
+  llvm::ThreadPool Pool(std::min<unsigned>(
+      Jobs.size(), ImportingInstance.getHeaderSearchOpts().ModuleBuildJobs));
+  auto Start = [&](unsigned I) {
+    ++Outstanding;
+    Pool.async([&, I] {
+      prebuildModule(Jobs[I], PCHOps, VFS);
+      std::lock_guard<std::mutex> Lock(FinishedMutex);
+      FinishedJobs.push_back(I);
+      FinishedCondition.notify_one();
+    });
+  };
+
+  for (unsigned I = 0, N = Jobs.size(); I != N; ++I)
+    if (!Jobs[I].PendingDependencies)
+      Start(I);
+
+  // Modules whose likely imports form a cycle are never started; they are
+  // left to be built on demand.
+  bool BuiltAny = false;
+  while (Outstanding) {
+    unsigned I;
+    {
+      std::unique_lock<std::mutex> Lock(FinishedMutex);
+      FinishedCondition.wait(Lock, [&] { return !FinishedJobs.empty(); });
+      I = FinishedJobs.pop_back_val();
+    }
+    --Outstanding;
+
+    ModulePrebuildJob &Job = Jobs[I];
+    ImportingInstance.getModuleCacheStats().add(Job.Stats);
+    if (Job.Built) {
+      BuiltAny = true;
+      ImportingInstance.getDiagnostics().Report(ImportLoc,
+                                                diag::remark_module_build)
+          << Job.ModuleName << Job.ModuleFileName;
+      ImportingInstance.getDiagnostics().Report(ImportLoc,
+                                                diag::remark_module_build_done)
+          << Job.ModuleName;
+    }
+
+    for (unsigned Dependent : Job.Dependents)
+      if (--Jobs[Dependent].PendingDependencies == 0)
+        Start(Dependent);
+  }
+  Pool.wait();
+
+  if (BuiltAny && ImportingInstance.getFrontendOpts().GenerateGlobalModuleIndex)
+    ImportingInstance.setBuildGlobalModuleIndex(true);
+}
+#endif // LLVM_ENABLE_THREADS
+
 /// \brief Diagnose differences between the current definition of the given
 /// configuration macro and the definition provided on the command line.
 static void checkConfigMacro(Preprocessor &PP, StringRef ConfigMacro,
@@ -1398,6 +2065,7 @@ static void pruneModuleCache(const HeaderSearchOptions &HSOpts) {
       // Remove the timestamp file.
       std::string TimpestampFilename = File->path() + ".timestamp";
       llvm::sys::fs::remove(TimpestampFilename);
+      llvm::sys::fs::remove(File->path() + ModuleFileUseSuffix);
     }
 
     // If we removed all of the files in the directory, remove the directory
@@ -1705,6 +2373,17 @@ CompilerInstance::loadModule(SourceLocation ImportLoc,
         return ModuleLoadResult();
       }
 
+#if LLVM_ENABLE_THREADS
+      // Build the missing modules it is likely to import first, several at a
+      // time, if we're allowed to. The AST node counts kept for -print-stats
+      // and -fast-memory-report are process-wide and not thread-safe, so
+      // counting them rules this out.
+      if (getHeaderSearchOpts().ModuleBuildJobs > 1 &&
+          !getFrontendOpts().ShowStats &&
+          !getFrontendOpts().ShowASTMemoryReport)
+        prebuildModuleImports(*this, ImportLoc, Module);
+#endif
+
       // Try to compile and then load the module.
       if (!compileAndLoadModule(*this, ImportLoc, ModuleNameLoc, Module,
                                 ModuleFileName)) {
@@ -23,6 +23,8 @@
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Lex/PreprocessorOptions.h"
 #include "clang/Parse/ParseAST.h"
+#include "clang/Sema/Sema.h"
+#include "clang/Sema/TemplateProfiler.h"
 #include "clang/Serialization/ASTDeserializationListener.h"
 #include "clang/Serialization/ASTReader.h"
 #include "clang/Serialization/GlobalModuleIndex.h"
@@ -780,6 +782,12 @@ bool FrontendAction::BeginSourceFile(CompilerInstance &CI,
     assert((!CI.getLangOpts().Modules || CI.getModuleManager()) &&
            "modules enabled but created an external source that "
            "doesn't support modules");
+
+    // The external source knows about the builtins it used; pick up the
+    // rest as they are mentioned.
+    Preprocessor &PP = CI.getPreprocessor();
+    PP.getBuiltinInfo().initializeLazyBuiltins(PP.getIdentifierTable(),
+                                               PP.getLangOpts());
   }
 
   // If we were asked to load any module map files, do so now.
@@ -850,6 +858,31 @@ bool FrontendAction::Execute() {
   return true;
 }
 
+/// \brief Write the template instantiation profile requested with
+/// -ftemplate-profile, along with a report of the most expensive templates.
+static void writeTemplateProfile(CompilerInstance &CI,
+                                 const TemplateProfiler &Profiler) {
+  std::string TraceFile = CI.getFrontendOpts().TemplateProfileFile;
+  std::string ReportFile = TraceFile + ".report";
+
+  std::error_code EC;
+  llvm::raw_fd_ostream Trace(TraceFile, EC, llvm::sys::fs::F_Text);
+  if (EC) {
+    CI.getDiagnostics().Report(diag::warn_fe_unable_to_open_template_profile)
+        << TraceFile << EC.message();
+    return;
+  }
+  Profiler.writeTrace(Trace);
+
+  llvm::raw_fd_ostream Report(ReportFile, EC, llvm::sys::fs::F_Text);
+  if (EC) {
+    CI.getDiagnostics().Report(diag::warn_fe_unable_to_open_template_profile)
+        << ReportFile << EC.message();
+    return;
+  }
+  Profiler.writeReport(Report, /*MaxEntries=*/20);
+}
+
 void FrontendAction::EndSourceFile() {
   CompilerInstance &CI = getCompilerInstance();
 
@@ -863,6 +896,13 @@ void FrontendAction::EndSourceFile() {
   // Finalize the action.
   EndSourceFileAction();
 
+  if (CI.hasSema())
+    if (TemplateProfiler *Profiler = CI.getSema().getTemplateProfiler())
+      writeTemplateProfile(CI, *Profiler);
+
+  if (CI.getFrontendOpts().ShowASTMemoryReport && CI.hasASTContext())
+    CI.getASTContext().printMemoryReport(llvm::errs());
+
   // Sema references the ast consumer, so reset sema first.
   //
   // FIXME: There is more per-file stuff we could just drop here?
@@ -96,7 +96,9 @@ GeneratePCHAction::CreateASTConsumer(CompilerInstance &CI, StringRef InFile) {
                         Buffer, CI.getFrontendOpts().ModuleFileExtensions,
       /*AllowASTWithErrors*/CI.getPreprocessorOpts().AllowPCHWithCompilerErrors,
                         /*IncludeTimestamps*/
-                          +CI.getFrontendOpts().IncludeTimestamps));
+                          +CI.getFrontendOpts().IncludeTimestamps,
+                        /*ParallelRecordEncoding*/
+                          +CI.getFrontendOpts().ParallelASTSerialization));
   Consumers.push_back(CI.getPCHContainerWriter().CreatePCHContainerGenerator(
       CI, InFile, OutputFile, std::move(OS), Buffer));
 
@@ -158,7 +160,9 @@ GenerateModuleAction::CreateASTConsumer(CompilerInstance &CI,
                         Buffer, CI.getFrontendOpts().ModuleFileExtensions,
                         /*AllowASTWithErrors=*/false,
                         /*IncludeTimestamps=*/
-                          +CI.getFrontendOpts().BuildingImplicitModule));
+                          +CI.getFrontendOpts().BuildingImplicitModule,
+                        /*ParallelRecordEncoding=*/
+                          +CI.getFrontendOpts().ParallelASTSerialization));
   Consumers.push_back(CI.getPCHContainerWriter().CreatePCHContainerGenerator(
       CI, InFile, OutputFile, std::move(OS), Buffer));
   return llvm::make_unique<MultiplexConsumer>(std::move(Consumers));
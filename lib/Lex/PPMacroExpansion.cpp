@@ -574,6 +574,7 @@ bool Preprocessor::HandleMacroExpandedIdentifier(Token &Identifier,
     // identifier to the expanded token.
     bool isAtStartOfLine = Identifier.isAtStartOfLine();
     bool hasLeadingSpace = Identifier.hasLeadingSpace();
+    const IdentifierInfo *MacroII = Identifier.getIdentifierInfo();
 
     // Replace the result token.
     Identifier = MI->getReplacementToken(0);
@@ -584,10 +585,14 @@ bool Preprocessor::HandleMacroExpandedIdentifier(Token &Identifier,
 
     // Update the tokens location to include both its expansion and physical
     // locations.
+    unsigned StartNumSLocEntries = SourceMgr.local_sloc_entry_size();
+    unsigned StartSLocOffset = SourceMgr.getNextLocalOffset();
     SourceLocation Loc =
       SourceMgr.createExpansionLoc(Identifier.getLocation(), ExpandLoc,
                                    ExpansionEnd,Identifier.getLength());
     Identifier.setLocation(Loc);
+    if (RecordMacroSLocUsage)
+      noteMacroSLocUsage(MacroII, StartNumSLocEntries, StartSLocOffset);
 
     // If this is a disabled macro or #define X X, we must mark the result as
     // unexpandable.
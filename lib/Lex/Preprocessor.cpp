@@ -101,6 +101,7 @@ Preprocessor::Preprocessor(std::shared_ptr<PreprocessorOptions> PPOpts,
   NumFastMacroExpanded = NumTokenPaste = NumFastTokenPaste = 0;
   MaxIncludeStackDepth = 0;
   NumSkipped = 0;
+  RecordMacroSLocUsage = this->PPOpts->RecordMacroSLocUsage;
   
   // Default to discarding comments.
   KeepComments = false;
@@ -253,6 +254,17 @@ void Preprocessor::DumpMacro(const MacroInfo &MI) const {
   llvm::errs() << "\n";
 }
 
+void Preprocessor::noteMacroSLocUsage(const IdentifierInfo *II,
+                                      unsigned StartEntries,
+                                      unsigned StartOffset) {
+  if (!II)
+    return;
+  MacroSLocUsage &Usage = MacroSLocUsageMap[II];
+  ++Usage.NumExpansions;
+  Usage.NumSLocEntries += SourceMgr.local_sloc_entry_size() - StartEntries;
+  Usage.SLocBytes += SourceMgr.getNextLocalOffset() - StartOffset;
+}
+
 void Preprocessor::PrintStats() {
   llvm::errs() << "\n*** Preprocessor Stats:\n";
   llvm::errs() << NumDirectives << " directives found:\n";
@@ -274,6 +286,30 @@ void Preprocessor::PrintStats() {
              << " token paste (##) operations performed, "
              << NumFastTokenPaste << " on the fast path.\n";
 
+  if (!MacroSLocUsageMap.empty()) {
+    // Report the macros whose expansions consumed the most address space.
+    std::vector<std::pair<const IdentifierInfo *, MacroSLocUsage>> Usages(
+        MacroSLocUsageMap.begin(), MacroSLocUsageMap.end());
+    std::sort(Usages.begin(), Usages.end(),
+              [](const std::pair<const IdentifierInfo *, MacroSLocUsage> &LHS,
+                 const std::pair<const IdentifierInfo *, MacroSLocUsage> &RHS) {
+                if (LHS.second.SLocBytes != RHS.second.SLocBytes)
+                  return LHS.second.SLocBytes > RHS.second.SLocBytes;
+                return LHS.first->getName() < RHS.first->getName();
+              });
+    const unsigned NumToShow = 20;
+    llvm::errs() << "\nSloc address space used by macro expansions "
+                 << "(inclusive of nested expansions):\n";
+    for (unsigned I = 0, E = std::min<size_t>(NumToShow, Usages.size());
+         I != E; ++I) {
+      const MacroSLocUsage &Usage = Usages[I].second;
+      llvm::errs() << "  " << Usages[I].first->getName() << ": "
+                   << Usage.NumExpansions << " expansions, "
+                   << Usage.NumSLocEntries << " SLocEntries, "
+                   << Usage.SLocBytes << "B\n";
+    }
+  }
+
   llvm::errs() << "\nPreprocessor Memory: " << getTotalMemory() << "B total";
 
   llvm::errs() << "\n  BumpPtr: " << BP.getTotalMemory();
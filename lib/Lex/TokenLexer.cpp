@@ -18,6 +18,7 @@
 #include "clang/Lex/MacroInfo.h"
 #include "clang/Lex/Preprocessor.h"
 #include "llvm/ADT/SmallString.h"
+#include <algorithm>
 
 using namespace clang;
 
@@ -43,9 +44,12 @@ void TokenLexer::Init(Token &Tok, SourceLocation ELEnd, MacroInfo *MI,
   DisableMacroExpansion = false;
   NumTokens = Macro->tokens_end()-Macro->tokens_begin();
   MacroExpansionStart = SourceLocation();
+  PasteOperandInstLocs.clear();
 
   SourceManager &SM = PP.getSourceManager();
   MacroStartSLocOffset = SM.getNextLocalOffset();
+  MacroStartNumSLocEntries = SM.local_sloc_entry_size();
+  MacroName = Tok.getIdentifierInfo();
 
   if (NumTokens > 0) {
     assert(Tokens[0].getLocation().isValid());
@@ -85,6 +89,7 @@ void TokenLexer::Init(const Token *TokArray, unsigned NumToks,
   destroy();
 
   Macro = nullptr;
+  MacroName = nullptr;
   ActualArgs = nullptr;
   Tokens = TokArray;
   OwnsTokens = ownsTokens;
@@ -96,6 +101,7 @@ void TokenLexer::Init(const Token *TokArray, unsigned NumToks,
   HasLeadingSpace = false;
   NextTokGetsSpace = false;
   MacroExpansionStart = SourceLocation();
+  PasteOperandInstLocs.clear();
 
   // Set HasLeadingSpace/AtStartOfLine so that the first token will be
   // returned unmodified.
@@ -348,8 +354,18 @@ void TokenLexer::ExpandFunctionArguments() {
       }
 
       if (ExpandLocStart.isValid()) {
-        updateLocForMacroArgTokens(CurTok.getLocation(),
-                                   ResultToks.end()-NumToks, ResultToks.end());
+        // A single-token operand is normally consumed by the paste, which
+        // gives the result a location of its own, so only create the macro
+        // argument expansion for it if Lex ends up returning it unpasted.
+        if (NumToks == 1 &&
+            (PasteAfter || (NonEmptyPasteBefore && !VaArgsPseudoPaste)))
+          PasteOperandInstLocs.push_back(std::make_pair(
+              ResultToks.size() - 1,
+              getExpansionLocForMacroDefLoc(CurTok.getLocation())));
+        else
+          updateLocForMacroArgTokens(CurTok.getLocation(),
+                                     ResultToks.end()-NumToks,
+                                     ResultToks.end());
       }
 
       // Transfer the leading whitespace information from the token
@@ -426,7 +442,12 @@ bool TokenLexer::Lex(Token &Tok) {
   if (isAtEnd()) {
     // If this is a macro (not a token stream), mark the macro enabled now
     // that it is no longer being expanded.
-    if (Macro) Macro->EnableMacro();
+    if (Macro) {
+      Macro->EnableMacro();
+      if (PP.isRecordingMacroSLocUsage())
+        PP.noteMacroSLocUsage(MacroName, MacroStartNumSLocEntries,
+                              MacroStartSLocOffset);
+    }
 
     Tok.startToken();
     Tok.setFlagValue(Token::StartOfLine , AtStartOfLine);
@@ -443,7 +464,8 @@ bool TokenLexer::Lex(Token &Tok) {
   bool isFirstToken = CurToken == 0;
 
   // Get the next token to return.
-  Tok = Tokens[CurToken++];
+  unsigned TokIdx = CurToken++;
+  Tok = Tokens[TokIdx];
 
   bool TokenIsFromPaste = false;
 
@@ -473,7 +495,13 @@ bool TokenLexer::Lex(Token &Tok) {
       // Check that the token's location was not already set properly.
       SM.isBeforeInSLocAddrSpace(Tok.getLocation(), MacroStartSLocOffset)) {
     SourceLocation instLoc;
-    if (Tok.is(tok::comment)) {
+    SourceLocation ArgInstLoc = getPasteOperandInstLoc(TokIdx);
+    if (ArgInstLoc.isValid()) {
+      // A macro argument that was left unpasted, e.g. because the other
+      // operand of the ## was empty.
+      instLoc = SM.createMacroArgExpansionLoc(Tok.getLocation(), ArgInstLoc,
+                                              Tok.getLength());
+    } else if (Tok.is(tok::comment)) {
       instLoc = SM.createExpansionLoc(Tok.getLocation(),
                                       ExpandLocStart,
                                       ExpandLocEnd,
@@ -535,7 +563,12 @@ bool TokenLexer::PasteTokens(Token &Tok) {
   
   SmallString<128> Buffer;
   const char *ResultTokStrPtr = nullptr;
-  SourceLocation StartLoc = Tok.getLocation();
+  // A macro argument on the LHS that is still waiting to be pasted is
+  // expanded at the argument use, which is where an argument expansion
+  // location would lead back to.
+  SourceLocation LHSInstLoc = getPasteOperandInstLoc(CurToken - 1);
+  SourceLocation StartLoc =
+      LHSInstLoc.isValid() ? LHSInstLoc : Tok.getLocation();
   SourceLocation PasteOpLoc;
   do {
     // Consume the ## operator if any.
@@ -629,6 +662,12 @@ bool TokenLexer::PasteTokens(Token &Tok) {
       // error.  This occurs with "x ## +"  and other stuff.  Return with Tok
       // unmodified and with RHS as the next token to lex.
       if (isInvalid) {
+        // The LHS is returned unpasted, so give it the macro argument
+        // expansion it was spared.
+        if (LHSInstLoc.isValid())
+          Tok.setLocation(SourceMgr.createMacroArgExpansionLoc(
+              Tok.getLocation(), LHSInstLoc, Tok.getLength()));
+
         // Explicitly convert the token location to have proper expansion
         // information so that the user knows where it came from.
         SourceManager &SM = PP.getSourceManager();
@@ -670,9 +709,12 @@ bool TokenLexer::PasteTokens(Token &Tok) {
     // Finally, replace LHS with the result, consume the RHS, and iterate.
     ++CurToken;
     Tok = Result;
+    LHSInstLoc = SourceLocation();
   } while (!isAtEnd() && Tokens[CurToken].is(tok::hashhash));
 
-  SourceLocation EndLoc = Tokens[CurToken - 1].getLocation();
+  SourceLocation EndLoc = getPasteOperandInstLoc(CurToken - 1);
+  if (EndLoc.isInvalid())
+    EndLoc = Tokens[CurToken - 1].getLocation();
 
   // The token's current location indicate where the token was lexed from.  We
   // need this information to compute the spelling of the token, but any
@@ -758,6 +800,17 @@ TokenLexer::getExpansionLocForMacroDefLoc(SourceLocation loc) const {
   return MacroExpansionStart.getLocWithOffset(relativeOffset);
 }
 
+SourceLocation TokenLexer::getPasteOperandInstLoc(unsigned TokIdx) const {
+  auto I = std::lower_bound(
+      PasteOperandInstLocs.begin(), PasteOperandInstLocs.end(), TokIdx,
+      [](const std::pair<unsigned, SourceLocation> &Operand, unsigned Idx) {
+        return Operand.first < Idx;
+      });
+  if (I != PasteOperandInstLocs.end() && I->first == TokIdx)
+    return I->second;
+  return SourceLocation();
+}
+
 /// \brief Finds the tokens that are consecutive (from the same FileID)
 /// creates a single SLocEntry, and assigns SourceLocations to each token that
 /// point to that SLocEntry. e.g for
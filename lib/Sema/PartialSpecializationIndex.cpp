@@ -0,0 +1,175 @@
+//===--- PartialSpecializationIndex.cpp - Partial spec lookup -------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the PartialSpecializationIndex class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Sema/PartialSpecializationIndex.h"
+#include "clang/AST/DeclTemplate.h"
+#include "clang/AST/TemplateBase.h"
+#include "clang/AST/Type.h"
+#include <algorithm>
+#include <iterator>
+
+using namespace clang;
+
+namespace {
+/// \brief The categories of template argument keys.
+enum KeyCategory : unsigned {
+  /// \brief Might match any template argument.
+  KC_Any,
+  KC_Pointer,
+  KC_LValueReference,
+  KC_RValueReference,
+  KC_MemberPointer,
+  KC_Array,
+  KC_Function,
+  /// \brief A class type. The key also holds the class template it's a
+  /// specialization of, or the class itself, if known.
+  KC_Class,
+  /// \brief A builtin type. The key also holds its BuiltinType::Kind.
+  KC_Builtin
+};
+} // end anonymous namespace
+
+static PartialSpecializationIndex::Key makeKey(KeyCategory Category,
+                                               const void *Detail = nullptr) {
+  return PartialSpecializationIndex::Key(Category, Detail);
+}
+
+PartialSpecializationIndex::Key
+PartialSpecializationIndex::getKey(const TemplateArgument &Arg) {
+  if (Arg.getKind() != TemplateArgument::Type)
+    return makeKey(KC_Any);
+
+  QualType T = Arg.getAsType().getCanonicalType();
+  switch (T->getTypeClass()) {
+  case Type::Pointer:
+    return makeKey(KC_Pointer);
+  case Type::LValueReference:
+    return makeKey(KC_LValueReference);
+  case Type::RValueReference:
+    return makeKey(KC_RValueReference);
+  case Type::MemberPointer:
+    return makeKey(KC_MemberPointer);
+  case Type::ConstantArray:
+  case Type::IncompleteArray:
+  case Type::VariableArray:
+  case Type::DependentSizedArray:
+    return makeKey(KC_Array);
+  case Type::FunctionProto:
+  case Type::FunctionNoProto:
+    return makeKey(KC_Function);
+
+  case Type::Builtin: {
+    const BuiltinType *BT = cast<BuiltinType>(T);
+    if (BT->isPlaceholderType() || BT->isDependentType())
+      return makeKey(KC_Any);
+    // Offset the kind so that it's never null.
+    return makeKey(KC_Builtin, reinterpret_cast<const void *>(
+                                   uintptr_t(BT->getKind()) + 1));
+  }
+
+  case Type::Record: {
+    const RecordDecl *RD = cast<RecordType>(T)->getDecl();
+    if (const auto *Spec = dyn_cast<ClassTemplateSpecializationDecl>(RD))
+      return makeKey(KC_Class,
+                     Spec->getSpecializedTemplate()->getCanonicalDecl());
+    return makeKey(KC_Class, RD->getCanonicalDecl());
+  }
+
+  case Type::TemplateSpecialization: {
+    // A dependent specialization of a class template, or of a template
+    // template parameter, which might be any class template.
+    TemplateName Name = cast<TemplateSpecializationType>(T)->getTemplateName();
+    if (const auto *ClassTemplate =
+            dyn_cast_or_null<ClassTemplateDecl>(Name.getAsTemplateDecl()))
+      return makeKey(KC_Class, ClassTemplate->getCanonicalDecl());
+    return makeKey(KC_Class);
+  }
+
+  default:
+    return makeKey(KC_Any);
+  }
+}
+
+bool PartialSpecializationIndex::mightMatch(Key Pattern, Key Arg) {
+  if (Pattern.first == KC_Any || Arg.first == KC_Any)
+    return true;
+  if (Pattern.first != Arg.first)
+    return false;
+  if (!Pattern.second || !Arg.second)
+    return Pattern.first == KC_Class;
+  return Pattern.second == Arg.second;
+}
+
+/// \brief Determine whether any class or template argument might match a
+/// template argument with the given key, when it's the first one.
+static bool matchesAnyFirstArgument(PartialSpecializationIndex::Key K) {
+  return K.first == KC_Any || (K.first == KC_Class && !K.second);
+}
+
+void PartialSpecializationIndex::getCandidates(
+    ClassTemplateDecl *Template, ArrayRef<TemplateArgument> Args,
+    SmallVectorImpl<ClassTemplatePartialSpecializationDecl *> &PartialSpecs) {
+  SmallVector<ClassTemplatePartialSpecializationDecl *, 4> All;
+  Template->getPartialSpecializations(All);
+
+  // Index any partial specializations that have been declared or loaded
+  // since we last looked. They're listed in the order they were added.
+  TemplateIndex &Index = Templates[Template->getCanonicalDecl()];
+  for (unsigned I = Index.NumIndexed, N = All.size(); I != N; ++I) {
+    const TemplateArgumentList &PatternArgs = All[I]->getTemplateArgs();
+    Index.Signatures.emplace_back();
+    SmallVectorImpl<Key> &Signature = Index.Signatures.back();
+    for (const TemplateArgument &Arg : PatternArgs.asArray())
+      Signature.push_back(getKey(Arg));
+
+    if (Signature.empty() || matchesAnyFirstArgument(Signature.front()))
+      Index.AnyFirstArgument.push_back(I);
+    else
+      Index.ByFirstArgument[Signature.front()].push_back(I);
+  }
+  Index.NumIndexed = All.size();
+
+  SmallVector<Key, 4> ArgKeys;
+  for (const TemplateArgument &Arg : Args)
+    ArgKeys.push_back(getKey(Arg));
+
+  // Find the partial specializations that might match the first template
+  // argument, in the order they were declared.
+  SmallVector<unsigned, 16> Candidates;
+  if (ArgKeys.empty() || matchesAnyFirstArgument(ArgKeys.front())) {
+    for (unsigned I = 0, N = All.size(); I != N; ++I)
+      Candidates.push_back(I);
+  } else {
+    auto Known = Index.ByFirstArgument.find(ArgKeys.front());
+    if (Known == Index.ByFirstArgument.end())
+      Candidates.append(Index.AnyFirstArgument.begin(),
+                        Index.AnyFirstArgument.end());
+    else
+      std::merge(Known->second.begin(), Known->second.end(),
+                 Index.AnyFirstArgument.begin(), Index.AnyFirstArgument.end(),
+                 std::back_inserter(Candidates));
+  }
+
+  // Check all of the template arguments of each of them.
+  PartialSpecs.clear();
+  for (unsigned I : Candidates) {
+    ArrayRef<Key> Signature = Index.Signatures[I];
+    bool Plausible = true;
+    if (Signature.size() == ArgKeys.size())
+      for (unsigned ArgIdx = 0, N = ArgKeys.size(); Plausible && ArgIdx != N;
+           ++ArgIdx)
+        Plausible = mightMatch(Signature[ArgIdx], ArgKeys[ArgIdx]);
+    if (Plausible)
+      PartialSpecs.push_back(All[I]);
+  }
+}
@@ -31,12 +31,15 @@
 #include "clang/Sema/Initialization.h"
 #include "clang/Sema/MultiplexExternalSemaSource.h"
 #include "clang/Sema/ObjCMethodList.h"
+#include "clang/Sema/PartialSpecializationIndex.h"
 #include "clang/Sema/PrettyDeclStackTrace.h"
 #include "clang/Sema/Scope.h"
 #include "clang/Sema/ScopeInfo.h"
 #include "clang/Sema/SemaConsumer.h"
 #include "clang/Sema/SemaInternal.h"
 #include "clang/Sema/TemplateDeduction.h"
+#include "clang/Sema/TemplateProfiler.h"
+#include "clang/Sema/TypoCorrectionIndex.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallSet.h"
 using namespace clang;
@@ -97,7 +100,9 @@ Sema::Sema(Preprocessor &pp, ASTContext &ctxt, ASTConsumer &consumer,
       InNonInstantiationSFINAEContext(false), NonInstantiationEntries(0),
       ArgumentPackSubstitutionIndex(-1), CurrentInstantiationScope(nullptr),
       CurrentInjectionContext(nullptr),
-      DisableTypoCorrection(false), TyposCorrected(0), AnalysisWarnings(*this),
+      DisableTypoCorrection(false), TyposCorrected(0),
+      TypoCorrectionTime(std::chrono::steady_clock::duration::zero()),
+      AnalysisWarnings(*this),
       ThreadSafetyDeclCache(nullptr), VarDataSharingAttributesStack(nullptr),
       CurScope(nullptr), Ident_super(nullptr), Ident___float128(nullptr) {
   TUScope = nullptr;
@@ -289,6 +294,8 @@ Sema::~Sema() {
   if (FunctionScopes.size() == 1)
     delete FunctionScopes[0];
 
+  clearDeductionCache();
+
   // Tell the SemaConsumer to forget about us; we're going out of scope.
   if (SemaConsumer *SC = dyn_cast<SemaConsumer>(&Consumer))
     SC->ForgetSema();
@@ -362,6 +369,24 @@ void Sema::addExternalSource(ExternalSemaSource *E) {
   }
 }
 
+void Sema::setTemplateProfiler(std::unique_ptr<TemplateProfiler> Profiler) {
+  assert(CodeSynthesisContexts.empty() &&
+         "cannot start profiling during template instantiation");
+  TemplateProf = std::move(Profiler);
+}
+
+PartialSpecializationIndex &Sema::getPartialSpecializationIndex() {
+  if (!PartialSpecIndex)
+    PartialSpecIndex.reset(new PartialSpecializationIndex);
+  return *PartialSpecIndex;
+}
+
+TypoCorrectionIndex &Sema::getTypoCorrectionIndex() {
+  if (!TypoCorrectionIdx)
+    TypoCorrectionIdx.reset(new TypoCorrectionIndex(Context));
+  return *TypoCorrectionIdx;
+}
+
 /// \brief Print out statistics about the semantic analysis.
 void Sema::PrintStats() const {
   llvm::errs() << "\n*** Semantic Analysis Stats:\n";
@@ -752,6 +777,20 @@ void Sema::ActOnEndOfTranslationUnit() {
       LateTemplateParserCleanup(OpaqueParser);
 
     CheckDelayedMemberExceptionSpecs();
+  } else if (getLangOpts().PCHInstantiateTemplates) {
+    // Perform the implicit instantiations that the prefix needs now, so that
+    // they're stored in the PCH file rather than repeated by every
+    // translation unit that uses it. Names declared after the prefix aren't
+    // visible to these instantiations; if that changes their meaning, the
+    // program is ill-formed, no diagnostic required ([temp.point]p8).
+    // Include those left pending by an earlier PCH in the chain.
+    if (ExternalSource) {
+      SmallVector<PendingImplicitInstantiation, 4> Pending;
+      ExternalSource->ReadPendingInstantiations(Pending);
+      PendingInstantiations.insert(PendingInstantiations.begin(),
+                                   Pending.begin(), Pending.end());
+    }
+    PerformPendingInstantiations();
   }
 
   DiagnoseUnterminatedPragmaAttribute();
@@ -1359,6 +1359,12 @@ static bool AllowOverloadingOfFunction(LookupResult &Previous,
 
 /// Add this decl to the scope shadowed decl chains.
 void Sema::PushOnScopeChains(NamedDecl *D, Scope *S, bool AddToContext) {
+  // A new declaration outside of a function body can change the outcome of
+  // template argument deduction, e.g. by adding an overload that is found by
+  // argument-dependent lookup during substitution.
+  if (!D->getDeclContext()->isFunctionOrMethod())
+    clearDeductionCache();
+
   // Move up the scope chain until we find the nearest enclosing
   // non-transparent context. The declaration will be introduced into this
   // scope.
@@ -14106,6 +14112,10 @@ void Sema::ActOnTagFinishDefinition(Scope *S, Decl *&TagD,
 
   Tag->setBraceRange(BraceRange);
 
+  // Substitution into a template may have failed because this type was
+  // incomplete.
+  clearDeductionCache();
+
   // Make sure we "complete" the definition even it is invalid.
   if (Tag->isBeingDefined()) {
     assert(Tag->isInvalidDecl() && "We should already have completed it");
@@ -16226,6 +16236,10 @@ Sema::DeclGroupPtrTy Sema::ActOnModuleDecl(SourceLocation StartLoc,
 DeclResult Sema::ActOnModuleImport(SourceLocation StartLoc,
                                    SourceLocation ImportLoc,
                                    ModuleIdPath Path) {
+  // Declarations that become visible can change the outcome of template
+  // argument deduction.
+  clearDeductionCache();
+
   Module *Mod =
       getModuleLoader().loadModule(ImportLoc, Path, Module::AllVisible,
                                    /*IsIncludeDirective=*/false);
@@ -16301,6 +16315,7 @@ void Sema::BuildModuleInclude(SourceLocation DirectiveLoc, Module *Mod) {
 
   getModuleLoader().makeModuleVisible(Mod, Module::AllVisible, DirectiveLoc);
   VisibleModules.setVisible(Mod, DirectiveLoc);
+  clearDeductionCache();
 }
 
 void Sema::ActOnModuleBegin(SourceLocation DirectiveLoc, Module *Mod) {
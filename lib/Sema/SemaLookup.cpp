@@ -35,6 +35,7 @@
 #include "clang/Sema/SemaInternal.h"
 #include "clang/Sema/TemplateDeduction.h"
 #include "clang/Sema/TypoCorrection.h"
+#include "clang/Sema/TypoCorrectionIndex.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/TinyPtrVector.h"
@@ -3871,6 +3872,12 @@ void TypoCorrectionConsumer::addKeywordResult(StringRef Keyword) {
   addName(Keyword, nullptr, nullptr, true);
 }
 
+/// \brief Determine the largest edit distance at which a name is considered
+/// as a correction for the given typo.
+static unsigned getMaxTypoEditDistance(StringRef Typo) {
+  return (Typo.size() + 2) / 3;
+}
+
 void TypoCorrectionConsumer::addName(StringRef Name, NamedDecl *ND,
                                      NestedNameSpecifier *NNS, bool isKeyword) {
   // Use a simple length-based heuristic to determine the minimum possible
@@ -3882,7 +3889,7 @@ void TypoCorrectionConsumer::addName(StringRef Name, NamedDecl *ND,
 
   // Compute an upper bound on the allowable edit distance, so that the
   // edit-distance algorithm can short-circuit.
-  unsigned UpperBound = (TypoStr.size() + 2) / 3 + 1;
+  unsigned UpperBound = getMaxTypoEditDistance(TypoStr) + 1;
   unsigned ED = TypoStr.edit_distance(Name, true, UpperBound);
   if (ED >= UpperBound) return;
 
@@ -3969,12 +3976,45 @@ void TypoCorrectionConsumer::addNamespaces(
   }
 }
 
+namespace {
+/// \brief Adds the time spent in its scope to the time Sema has spent on
+/// typo correction, and checks it against -ftypo-correction-budget-ms.
+class TypoCorrectionTimer {
+  Sema &SemaRef;
+  std::chrono::steady_clock::time_point Start;
+
+public:
+  explicit TypoCorrectionTimer(Sema &SemaRef)
+      : SemaRef(SemaRef), Start(std::chrono::steady_clock::now()) {}
+
+  ~TypoCorrectionTimer() {
+    SemaRef.TypoCorrectionTime += std::chrono::steady_clock::now() - Start;
+  }
+
+  /// \brief Determine whether the time budget for typo correction has been
+  /// spent, including the time spent in this scope so far.
+  bool isBudgetExhausted() const {
+    unsigned BudgetMs = SemaRef.getDiagnostics()
+                            .getDiagnosticOptions()
+                            .TypoCorrectionBudgetMs;
+    return BudgetMs && SemaRef.TypoCorrectionTime +
+                               (std::chrono::steady_clock::now() - Start) >=
+                           std::chrono::milliseconds(BudgetMs);
+  }
+};
+} // end anonymous namespace
+
 const TypoCorrection &TypoCorrectionConsumer::getNextCorrection() {
   if (++CurrentTCIndex < ValidatedCorrections.size())
     return ValidatedCorrections[CurrentTCIndex];
 
+  TypoCorrectionTimer Timer(SemaRef);
   CurrentTCIndex = ValidatedCorrections.size();
   while (!CorrectionResults.empty()) {
+    // Give up on the remaining candidates once we're out of time.
+    if (Timer.isBudgetExhausted())
+      break;
+
     auto DI = CorrectionResults.begin();
     if (DI->second.empty()) {
       CorrectionResults.erase(DI);
@@ -4503,6 +4543,12 @@ std::unique_ptr<TypoCorrectionConsumer> Sema::makeTypoCorrectionConsumer(
   unsigned Limit = getDiagnostics().getDiagnosticOptions().SpellCheckingLimit;
   if (Limit && TyposCorrected >= Limit)
     return nullptr;
+
+  // Likewise, once typo correction has used up its time budget, report
+  // errors without trying to correct them.
+  TypoCorrectionTimer Timer(*this);
+  if (Timer.isBudgetExhausted())
+    return nullptr;
   ++TyposCorrected;
 
   // If we're handling a missing symbol error, using modules, and the
@@ -4548,24 +4594,12 @@ std::unique_ptr<TypoCorrectionConsumer> Sema::makeTypoCorrectionConsumer(
 
   if (IsUnqualifiedLookup || SearchNamespaces) {
     // For unqualified lookup, look through all of the names that we have
-    // seen in this translation unit.
-    // FIXME: Re-add the ability to skip very unlikely potential corrections.
-    for (const auto &I : Context.Idents)
-      Consumer->FoundName(I.getKey());
-
-    // Walk through identifiers in external identifier sources.
-    // FIXME: Re-add the ability to skip very unlikely potential corrections.
-    if (IdentifierInfoLookup *External
-                            = Context.Idents.getExternalIdentifierLookup()) {
-      std::unique_ptr<IdentifierIterator> Iter(External->getIdentifiers());
-      do {
-        StringRef Name = Iter->Next();
-        if (Name.empty())
-          break;
-
-        Consumer->FoundName(Name);
-      } while (true);
-    }
+    // seen in this translation unit, the names of the builtins and the
+    // identifiers in external identifier sources. The index skips those
+    // that are too far from the typo for the consumer to accept.
+    getTypoCorrectionIndex().lookup(
+        Typo->getName(), getMaxTypoEditDistance(Typo->getName()),
+        [&](StringRef Name) { Consumer->FoundName(Name); });
   }
 
   AddKeywordsToConsumer(*this, *Consumer, S, CCCRef, SS && SS->isNotEmpty());
@@ -8916,12 +8916,56 @@ static Comparison compareEnableIfAttrs(const Sema &S, const FunctionDecl *Cand1,
   return Cand1I == Cand1Attrs.end() ? Comparison::Equal : Comparison::Better;
 }
 
-/// isBetterOverloadCandidate - Determines whether the first overload
-/// candidate is a better candidate than the second (C++ 13.3.3p1).
-bool clang::isBetterOverloadCandidate(Sema &S, const OverloadCandidate &Cand1,
-                                      const OverloadCandidate &Cand2,
-                                      SourceLocation Loc,
-                                      bool UserDefinedConversion) {
+namespace {
+/// \brief The results of comparing the conversion sequences of two overload
+/// candidates, argument by argument.
+///
+/// BestViableFunction compares each viable candidate against the best
+/// candidate found so far, and then compares the best candidate against each
+/// of them again to check for ambiguity. Comparing conversion sequences is
+/// antisymmetric, so the second comparison can reuse the results of the
+/// first one.
+class ConversionComparisons {
+  /// \brief One result per argument, oriented as a comparison of the later
+  /// candidate against the earlier one, or Unknown.
+  signed char *Results;
+
+  /// \brief Whether the candidates are being compared in the opposite order
+  /// from the one the results are stored in.
+  bool Reversed;
+
+public:
+  enum : signed char { Unknown = 2 };
+
+  ConversionComparisons(signed char *Results, bool Reversed)
+      : Results(Results), Reversed(Reversed) {}
+
+  ImplicitConversionSequence::CompareKind
+  compare(Sema &S, SourceLocation Loc, const OverloadCandidate &Cand1,
+          const OverloadCandidate &Cand2, unsigned ArgIdx) {
+    if (Results && Results[ArgIdx] != Unknown)
+      return ImplicitConversionSequence::CompareKind(
+          Reversed ? -Results[ArgIdx] : Results[ArgIdx]);
+
+    ImplicitConversionSequence::CompareKind Result =
+        CompareImplicitConversionSequences(S, Loc, Cand1.Conversions[ArgIdx],
+                                           Cand2.Conversions[ArgIdx]);
+    if (Results)
+      Results[ArgIdx] = Reversed ? -Result : Result;
+    return Result;
+  }
+};
+} // end anonymous namespace
+
+/// \brief Determines whether the first overload candidate is a better
+/// candidate than the second (C++ 13.3.3p1), comparing their conversion
+/// sequences through \p Comparisons.
+static bool isBetterOverloadCandidateImpl(Sema &S,
+                                          const OverloadCandidate &Cand1,
+                                          const OverloadCandidate &Cand2,
+                                          SourceLocation Loc,
+                                          bool UserDefinedConversion,
+                                          ConversionComparisons &Comparisons) {
   // Define viable functions to be better candidates than non-viable
   // functions.
   if (!Cand2.Viable)
@@ -8974,9 +9018,7 @@ bool clang::isBetterOverloadCandidate(Sema &S, const OverloadCandidate &Cand1,
   //   viable function F2 if for all arguments i, ICSi(F1) is not a worse
   //   conversion sequence than ICSi(F2), and then...
   for (unsigned ArgIdx = StartArg; ArgIdx < NumArgs; ++ArgIdx) {
-    switch (CompareImplicitConversionSequences(S, Loc,
-                                               Cand1.Conversions[ArgIdx],
-                                               Cand2.Conversions[ArgIdx])) {
+    switch (Comparisons.compare(S, Loc, Cand1, Cand2, ArgIdx)) {
     case ImplicitConversionSequence::Better:
       // Cand1 has a better conversion sequence.
       HasBetterConversion = true;
@@ -9095,6 +9137,17 @@ bool clang::isBetterOverloadCandidate(Sema &S, const OverloadCandidate &Cand1,
   return HasPS1 != HasPS2 && HasPS1;
 }
 
+/// isBetterOverloadCandidate - Determines whether the first overload
+/// candidate is a better candidate than the second (C++ 13.3.3p1).
+bool clang::isBetterOverloadCandidate(Sema &S, const OverloadCandidate &Cand1,
+                                      const OverloadCandidate &Cand2,
+                                      SourceLocation Loc,
+                                      bool UserDefinedConversion) {
+  ConversionComparisons Comparisons(/*Results=*/nullptr, /*Reversed=*/false);
+  return isBetterOverloadCandidateImpl(S, Cand1, Cand2, Loc,
+                                       UserDefinedConversion, Comparisons);
+}
+
 /// Determine whether two declarations are "equivalent" for the purposes of
 /// name lookup and overload resolution. This applies when the same internal/no
 /// linkage entity is defined by two modules (probably by textually including
@@ -9176,10 +9229,6 @@ OverloadingResult
 OverloadCandidateSet::BestViableFunction(Sema &S, SourceLocation Loc,
                                          iterator &Best,
                                          bool UserDefinedConversion) {
-  llvm::SmallVector<OverloadCandidate *, 16> Candidates;
-  std::transform(begin(), end(), std::back_inserter(Candidates),
-                 [](OverloadCandidate &Cand) { return &Cand; });
-
   // [CUDA] HD->H or HD->D calls are technically not allowed by CUDA but
   // are accepted by both clang and NVCC. However, during a particular
   // compilation mode only one call variant is viable. We need to
@@ -9187,45 +9236,75 @@ OverloadCandidateSet::BestViableFunction(Sema &S, SourceLocation Loc,
   // only on their host/device attributes. Specifically, if one
   // candidate call is WrongSide and the other is SameSide, we ignore
   // the WrongSide candidate.
+  const FunctionDecl *Caller = nullptr;
+  bool ContainsSameSideCandidate = false;
   if (S.getLangOpts().CUDA) {
-    const FunctionDecl *Caller = dyn_cast<FunctionDecl>(S.CurContext);
-    bool ContainsSameSideCandidate =
-        llvm::any_of(Candidates, [&](OverloadCandidate *Cand) {
-          return Cand->Function &&
-                 S.IdentifyCUDAPreference(Caller, Cand->Function) ==
+    Caller = dyn_cast<FunctionDecl>(S.CurContext);
+    ContainsSameSideCandidate =
+        std::any_of(begin(), end(), [&](OverloadCandidate &Cand) {
+          return Cand.Function &&
+                 S.IdentifyCUDAPreference(Caller, Cand.Function) ==
                      Sema::CFP_SameSide;
         });
-    if (ContainsSameSideCandidate) {
-      auto IsWrongSideCandidate = [&](OverloadCandidate *Cand) {
-        return Cand->Function &&
-               S.IdentifyCUDAPreference(Caller, Cand->Function) ==
-                   Sema::CFP_WrongSide;
-      };
-      llvm::erase_if(Candidates, IsWrongSideCandidate);
-    }
   }
 
-  // Find the best viable function.
-  Best = end();
-  for (auto *Cand : Candidates)
-    if (Cand->Viable)
-      if (Best == end() || isBetterOverloadCandidate(S, *Cand, *Best, Loc,
-                                                     UserDefinedConversion))
-        Best = Cand;
+  // Only a viable candidate can be the best one, so set aside the others
+  // before comparing any candidates.
+  llvm::SmallVector<OverloadCandidate *, 16> Candidates;
+  for (OverloadCandidate &Cand : *this) {
+    if (!Cand.Viable)
+      continue;
+    if (ContainsSameSideCandidate && Cand.Function &&
+        S.IdentifyCUDAPreference(Caller, Cand.Function) == Sema::CFP_WrongSide)
+      continue;
+    Candidates.push_back(&Cand);
+  }
 
   // If we didn't find any viable functions, abort.
-  if (Best == end())
+  if (Candidates.empty()) {
+    Best = end();
     return OR_No_Viable_Function;
+  }
+
+  // The results of comparing each candidate's conversion sequences against
+  // those of the best candidate at the time it was visited. They're
+  // allocated in the slab, which is reset along with the candidates.
+  unsigned NumArgs = Candidates.front()->Conversions.size();
+  signed char *Results = nullptr;
+  if (Candidates.size() > 1) {
+    size_t NumResults = Candidates.size() * NumArgs;
+    Results = SlabAllocator.Allocate<signed char>(NumResults);
+    std::fill(Results, Results + NumResults, ConversionComparisons::Unknown);
+  }
+
+  // Find the best viable function.
+  unsigned BestIdx = 0;
+  for (unsigned I = 1, N = Candidates.size(); I != N; ++I) {
+    ConversionComparisons Comparisons(Results + I * NumArgs,
+                                      /*Reversed=*/false);
+    if (isBetterOverloadCandidateImpl(S, *Candidates[I],
+                                      *Candidates[BestIdx], Loc,
+                                      UserDefinedConversion, Comparisons))
+      BestIdx = I;
+  }
+  Best = Candidates[BestIdx];
 
   llvm::SmallVector<const NamedDecl *, 4> EquivalentCands;
 
   // Make sure that this function is better than every other viable
   // function. If not, we have an ambiguity.
-  for (auto *Cand : Candidates) {
-    if (Cand->Viable &&
-        Cand != Best &&
-        !isBetterOverloadCandidate(S, *Best, *Cand, Loc,
-                                   UserDefinedConversion)) {
+  for (unsigned I = 0, N = Candidates.size(); I != N; ++I) {
+    if (I == BestIdx)
+      continue;
+
+    // Every candidate after the best one was compared against it above, so
+    // reuse the results of comparing their conversion sequences.
+    OverloadCandidate *Cand = Candidates[I];
+    ConversionComparisons Comparisons(I > BestIdx ? Results + I * NumArgs
+                                                  : nullptr,
+                                      /*Reversed=*/true);
+    if (!isBetterOverloadCandidateImpl(S, *Best, *Cand, Loc,
+                                       UserDefinedConversion, Comparisons)) {
       if (S.isEquivalentInternalLinkageDeclaration(Best->Function,
                                                    Cand->Function)) {
         EquivalentCands.push_back(Cand->Function);
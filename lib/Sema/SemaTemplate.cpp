@@ -3401,6 +3401,9 @@ DeclResult Sema::ActOnVarTemplateSpecialization(
   assert(D.getName().getKind() == UnqualifiedId::IK_TemplateId &&
          "Variable template specialization is declared with a template it.");
 
+  // A new specialization can change which one substitution picks.
+  clearDeductionCache();
+
   TemplateIdAnnotation *TemplateId = D.getName().TemplateId;
   TemplateArgumentListInfo TemplateArgs =
       makeTemplateArgumentListInfo(*this, *TemplateId);
@@ -7187,6 +7190,9 @@ Sema::ActOnClassTemplateSpecialization(Scope *S, unsigned TagSpec,
                                        SkipBodyInfo *SkipBody) {
   assert(TUK != TUK_Reference && "References are not specializations");
 
+  // A new specialization can change which one substitution picks.
+  clearDeductionCache();
+
   CXXScopeSpec &SS = TemplateId.SS;
 
   // NOTE: KWLoc is the location of the tag keyword. This will instead
@@ -3463,6 +3463,64 @@ static Sema::TemplateDeductionResult DeduceTemplateArgumentsFromCallArgument(
                                             ArgType, Info, Deduced, TDF);
 }
 
+/// \brief Compute the key under which the outcome of deducing the arguments
+/// of \p FunctionTemplate from the call arguments \p Args is cached.
+///
+/// \returns false if the outcome may depend on more than the types and value
+/// kinds of the arguments, so must not be cached.
+static bool profileDeductionFromCall(llvm::FoldingSetNodeID &ID,
+                                     FunctionTemplateDecl *FunctionTemplate,
+                                     ArrayRef<Expr *> Args,
+                                     const TemplateDeductionInfo &Info) {
+  // The deduction must start from scratch.
+  if (Info.diag_begin() != Info.diag_end() || Info.hasSFINAEDiagnostic())
+    return false;
+
+  ID.AddPointer(FunctionTemplate->getCanonicalDecl());
+  ID.AddInteger(Info.getDeducedDepth());
+  ID.AddInteger(Args.size());
+  for (Expr *Arg : Args) {
+    // Deduction from braced-init-lists and overload sets looks at the
+    // expressions themselves.
+    if (Arg->isInstantiationDependent() || isa<InitListExpr>(Arg) ||
+        Arg->getType()->isPlaceholderType() || Arg->refersToBitField())
+      return false;
+
+    ID.AddPointer(Arg->getType().getCanonicalType().getAsOpaquePtr());
+    ID.AddInteger(Arg->getValueKind());
+  }
+  return true;
+}
+
+/// \brief Determine whether a deduction with the given result can be
+/// reused for later calls with the same argument types.
+static bool isCacheableDeductionResult(Sema::TemplateDeductionResult Result) {
+  switch (Result) {
+  case Sema::TDK_Success:
+  case Sema::TDK_Incomplete:
+  case Sema::TDK_Inconsistent:
+  case Sema::TDK_Underqualified:
+  case Sema::TDK_SubstitutionFailure:
+  case Sema::TDK_DeducedMismatch:
+  case Sema::TDK_DeducedMismatchNested:
+  case Sema::TDK_NonDeducedMismatch:
+  case Sema::TDK_TooManyArguments:
+  case Sema::TDK_TooFewArguments:
+    return true;
+
+  default:
+    return false;
+  }
+}
+
+/// \brief Determine whether a cached deduction can still be used.
+static bool isUsableCachedDeduction(const Sema::DeductionCacheEntry *Entry) {
+  // A specialization that we deduced may since have been found to be
+  // invalid, for instance by a later error in its instantiation.
+  return Entry->Result != Sema::TDK_Success ||
+         !Entry->Specialization->isInvalidDecl();
+}
+
 /// \brief Perform template argument deduction from a function call
 /// (C++ [temp.deduct.call]).
 ///
@@ -3497,6 +3555,122 @@ Sema::TemplateDeductionResult Sema::DeduceTemplateArguments(
   if (FunctionTemplate->isInvalidDecl())
     return TDK_Invalid;
 
+  // Overload resolution often deduces a template's arguments from calls whose
+  // arguments have the same types and value kinds, and every such deduction
+  // has the same outcome. Only the conversions for non-dependent parameters
+  // depend on the argument expressions themselves.
+  llvm::FoldingSetNodeID ID;
+  if (ExplicitTemplateArgs || PartialOverloading ||
+      !profileDeductionFromCall(ID, FunctionTemplate, Args, Info))
+    return DeduceTemplateArgumentsFromCall(FunctionTemplate,
+                                           ExplicitTemplateArgs, Args,
+                                           Specialization, Info,
+                                           PartialOverloading,
+                                           CheckNonDependent);
+
+  void *InsertPos;
+  DeductionCacheEntry *Entry =
+      DeductionCache.FindNodeOrInsertPos(ID, InsertPos);
+  if (Entry && Entry->CheckedNonDependent &&
+      isUsableCachedDeduction(Entry)) {
+    // Check the conversions for the non-dependent parameters, as deduction
+    // would have done before substituting. That may clear the cache, so copy
+    // the parameter types first and look the entry up again afterwards.
+    SmallVector<QualType, 4> ParamTypes(
+        Entry->ParamTypesForArgChecking.begin(),
+        Entry->ParamTypesForArgChecking.end());
+    SFINAETrap Trap(*this);
+    if (CheckNonDependent(ParamTypes))
+      return TDK_NonDependentConversionFailure;
+    Entry = Trap.hasErrorOccurred()
+                ? nullptr
+                : DeductionCache.FindNodeOrInsertPos(ID, InsertPos);
+  }
+  if (Entry && isUsableCachedDeduction(Entry)) {
+    if (Entry->Result == TDK_Success) {
+      Specialization = Entry->Specialization;
+      return TDK_Success;
+    }
+
+    Info.reset(Entry->Deduced);
+    Info.Param = Entry->Param;
+    Info.FirstArg = Entry->FirstArg;
+    Info.SecondArg = Entry->SecondArg;
+    Info.CallArgIndex = Entry->CallArgIndex;
+    for (const PartialDiagnosticAt &Diag : Entry->Diagnostics) {
+      if (Entry->HasSFINAEDiagnostic)
+        Info.addSFINAEDiagnostic(Diag.first, Diag.second);
+      else
+        Info.addSuppressedDiagnostic(Diag.first, Diag.second);
+    }
+    return static_cast<TemplateDeductionResult>(Entry->Result);
+  }
+
+  bool CheckedNonDependent = false;
+  bool NonDependentConversionFailed = false;
+  SmallVector<QualType, 4> ParamTypesForArgChecking;
+  DiagnosticErrorTrap ErrorTrap(Diags);
+  TemplateDeductionResult Result = DeduceTemplateArgumentsFromCall(
+      FunctionTemplate, ExplicitTemplateArgs, Args, Specialization, Info,
+      PartialOverloading, [&](ArrayRef<QualType> ParamTypes) {
+        CheckedNonDependent = true;
+        ParamTypesForArgChecking.assign(ParamTypes.begin(), ParamTypes.end());
+        NonDependentConversionFailed = CheckNonDependent(ParamTypes);
+        return NonDependentConversionFailed;
+      });
+
+  // Don't remember outcomes that depend on the argument expressions, or
+  // that may have been affected by an error. In a SFINAE context, errors
+  // outside of the substitution itself are suppressed rather than
+  // diagnosed, so we can't tell.
+  if (NonDependentConversionFailed || ErrorTrap.hasErrorOccurred() ||
+      isSFINAEContext() || !isCacheableDeductionResult(Result) ||
+      (Result == TDK_Success && !Specialization))
+    return Result;
+
+  // Deduction may have added entries to the cache, or cleared it.
+  if (DeductionCache.FindNodeOrInsertPos(ID, InsertPos))
+    return Result;
+
+  Entry = DeductionCacheAllocator.Allocate<DeductionCacheEntry>();
+  Entry = new (Entry) DeductionCacheEntry(ID);
+  Entry->Result = Result;
+  Entry->CheckedNonDependent = CheckedNonDependent;
+  Entry->ParamTypesForArgChecking.append(ParamTypesForArgChecking.begin(),
+                                         ParamTypesForArgChecking.end());
+  Entry->Specialization = Result == TDK_Success ? Specialization : nullptr;
+  Entry->Deduced = Info.take();
+  Info.reset(Entry->Deduced);
+  Entry->Param = Info.Param;
+  Entry->FirstArg = Info.FirstArg;
+  Entry->SecondArg = Info.SecondArg;
+  Entry->CallArgIndex = Info.CallArgIndex;
+  Entry->HasSFINAEDiagnostic = Info.hasSFINAEDiagnostic();
+  if (Result != TDK_Success)
+    Entry->Diagnostics.append(Info.diag_begin(), Info.diag_end());
+  DeductionCache.InsertNode(Entry, InsertPos);
+  return Result;
+}
+
+void Sema::clearDeductionCache() {
+  if (DeductionCache.empty())
+    return;
+
+  SmallVector<DeductionCacheEntry *, 64> Entries;
+  for (DeductionCacheEntry &Entry : DeductionCache)
+    Entries.push_back(&Entry);
+  DeductionCache.clear();
+  for (DeductionCacheEntry *Entry : Entries)
+    Entry->~DeductionCacheEntry();
+  DeductionCacheAllocator.Reset();
+}
+
+Sema::TemplateDeductionResult Sema::DeduceTemplateArgumentsFromCall(
+    FunctionTemplateDecl *FunctionTemplate,
+    TemplateArgumentListInfo *ExplicitTemplateArgs, ArrayRef<Expr *> Args,
+    FunctionDecl *&Specialization, TemplateDeductionInfo &Info,
+    bool PartialOverloading,
+    llvm::function_ref<bool(ArrayRef<QualType>)> CheckNonDependent) {
   FunctionDecl *Function = FunctionTemplate->getTemplatedDecl();
   unsigned NumParams = Function->getNumParams();
 
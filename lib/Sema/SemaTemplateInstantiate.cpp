@@ -22,9 +22,11 @@
 #include "clang/Sema/DeclSpec.h"
 #include "clang/Sema/Initialization.h"
 #include "clang/Sema/Lookup.h"
+#include "clang/Sema/PartialSpecializationIndex.h"
 #include "clang/Sema/PrettyDeclStackTrace.h"
 #include "clang/Sema/Template.h"
 #include "clang/Sema/TemplateDeduction.h"
+#include "clang/Sema/TemplateProfiler.h"
 
 using namespace clang;
 using namespace sema;
@@ -365,6 +367,38 @@ Sema::InstantiatingTemplate::InstantiatingTemplate(
   Inst.Loop = S;
 }
 
+/// \brief Describe the kind of a code synthesis context in a template
+/// profile.
+static const char *
+getSynthesisKindName(Sema::CodeSynthesisContext::SynthesisKind Kind) {
+  switch (Kind) {
+  case Sema::CodeSynthesisContext::TemplateInstantiation:
+    return "instantiate";
+  case Sema::CodeSynthesisContext::DefaultTemplateArgumentInstantiation:
+    return "default template argument";
+  case Sema::CodeSynthesisContext::DefaultFunctionArgumentInstantiation:
+    return "default function argument";
+  case Sema::CodeSynthesisContext::ExplicitTemplateArgumentSubstitution:
+    return "explicit template argument substitution";
+  case Sema::CodeSynthesisContext::DeducedTemplateArgumentSubstitution:
+    return "deduce";
+  case Sema::CodeSynthesisContext::PriorTemplateArgumentSubstitution:
+    return "prior template argument substitution";
+  case Sema::CodeSynthesisContext::DefaultTemplateArgumentChecking:
+    return "default template argument checking";
+  case Sema::CodeSynthesisContext::ExceptionSpecInstantiation:
+    return "exception specification";
+  case Sema::CodeSynthesisContext::ForLoopInstantiation:
+    return "for loop";
+  case Sema::CodeSynthesisContext::DeclaringSpecialMember:
+    return "declare special member";
+  case Sema::CodeSynthesisContext::SourceCodeInjection:
+    return "source code injection";
+  }
+
+  llvm_unreachable("Invalid SynthesisKind!");
+}
+
 void Sema::pushCodeSynthesisContext(CodeSynthesisContext Ctx) {
   Ctx.SavedInNonInstantiationSFINAEContext = InNonInstantiationSFINAEContext;
   InNonInstantiationSFINAEContext = false;
@@ -373,6 +407,10 @@ void Sema::pushCodeSynthesisContext(CodeSynthesisContext Ctx) {
 
   if (!Ctx.isInstantiationRecord())
     ++NonInstantiationEntries;
+
+  if (TemplateProf)
+    TemplateProf->beginSpan(getSynthesisKindName(Ctx.Kind), Ctx.Entity,
+                            Ctx.Template, Ctx.PointOfInstantiation);
 }
 
 void Sema::popCodeSynthesisContext() {
@@ -401,6 +439,9 @@ void Sema::popCodeSynthesisContext() {
       LastEmittedCodeSynthesisContextDepth)
     LastEmittedCodeSynthesisContextDepth = 0;
 
+  if (TemplateProf)
+    TemplateProf->endSpan();
+
   CodeSynthesisContexts.pop_back();
 }
 
@@ -2578,8 +2619,12 @@ getPatternForClassTemplateSpecialization(
   //   specializations.
   typedef PartialSpecMatchResult MatchResult;
   SmallVector<MatchResult, 4> Matched;
+
+  // Only try the partial specializations whose template arguments have the
+  // right outermost form to match.
   SmallVector<ClassTemplatePartialSpecializationDecl *, 4> PartialSpecs;
-  Template->getPartialSpecializations(PartialSpecs);
+  S.getPartialSpecializationIndex().getCandidates(
+      Template, ClassTemplateSpec->getTemplateArgs().asArray(), PartialSpecs);
   TemplateSpecCandidateSet FailedCandidates(PointOfInstantiation);
   for (unsigned I = 0, N = PartialSpecs.size(); I != N; ++I) {
     ClassTemplatePartialSpecializationDecl *Partial = PartialSpecs[I];
@@ -0,0 +1,236 @@
+//===--- TemplateProfiler.cpp - Template instantiation profiling ----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the TemplateProfiler class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Sema/TemplateProfiler.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/DeclTemplate.h"
+#include "clang/Basic/SourceManager.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+
+using namespace clang;
+
+TemplateProfiler::TemplateProfiler(ASTContext &Context)
+    : Context(Context), Origin(std::chrono::steady_clock::now()) {}
+
+uint64_t TemplateProfiler::now() const {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - Origin)
+      .count();
+}
+
+static std::string getDeclName(const Decl *D, const PrintingPolicy &Policy) {
+  std::string Name;
+  llvm::raw_string_ostream OS(Name);
+  if (const auto *ND = dyn_cast<NamedDecl>(D))
+    ND->getNameForDiagnostic(OS, Policy, /*Qualified=*/true);
+  else
+    OS << D->getDeclKindName();
+  return OS.str();
+}
+
+/// \brief Find the template that the work on \p D should be attributed to.
+static const Decl *getAttributedTemplate(const Decl *D) {
+  if (const auto *Spec = dyn_cast<ClassTemplateSpecializationDecl>(D))
+    return Spec->getSpecializedTemplate();
+  if (const auto *Spec = dyn_cast<VarTemplateSpecializationDecl>(D))
+    return Spec->getSpecializedTemplate();
+  if (const auto *FD = dyn_cast<FunctionDecl>(D)) {
+    if (const FunctionTemplateDecl *Primary = FD->getPrimaryTemplate())
+      return Primary;
+    if (const FunctionDecl *Pattern = FD->getInstantiatedFromMemberFunction())
+      return Pattern;
+  }
+  if (const auto *RD = dyn_cast<CXXRecordDecl>(D))
+    if (const CXXRecordDecl *Pattern = RD->getInstantiatedFromMemberClass())
+      return Pattern;
+  if (const auto *Param = dyn_cast<ParmVarDecl>(D))
+    if (const auto *FD = dyn_cast<FunctionDecl>(Param->getDeclContext()))
+      return getAttributedTemplate(FD);
+  return D;
+}
+
+void TemplateProfiler::beginSpan(const char *Kind, const Decl *Entity,
+                                 const NamedDecl *Template,
+                                 SourceLocation Loc) {
+  const PrintingPolicy &Policy = Context.getPrintingPolicy();
+
+  Span S;
+  S.Kind = Kind;
+  if (Template) {
+    // We're substituting into one of the template's parameters.
+    S.Template = getDeclName(Template, Policy);
+    S.Name = S.Template;
+    if (Entity)
+      S.Name += " (" + getDeclName(Entity, Policy) + ")";
+  } else if (Entity) {
+    S.Name = getDeclName(Entity, Policy);
+    S.Template = getDeclName(getAttributedTemplate(Entity), Policy);
+  } else {
+    S.Name = S.Template = Kind;
+  }
+
+  PresumedLoc PLoc = Context.getSourceManager().getPresumedLoc(Loc);
+  if (PLoc.isValid()) {
+    llvm::raw_string_ostream OS(S.Location);
+    OS << PLoc.getFilename() << ':' << PLoc.getLine() << ':'
+       << PLoc.getColumn();
+  }
+
+  S.Parent = OpenSpans.empty() ? -1 : static_cast<int>(OpenSpans.back().Index);
+  S.Duration = S.SelfDuration = S.Bytes = S.SelfBytes = 0;
+
+  OpenSpan Open;
+  Open.Index = Spans.size();
+  Open.StartBytes = Context.getAllocator().getBytesAllocated();
+  Open.ChildDuration = Open.ChildBytes = 0;
+  OpenSpans.push_back(Open);
+
+  // Start the clock last, so that the time spent computing names is not
+  // attributed to the span.
+  S.Start = now();
+  Spans.push_back(std::move(S));
+}
+
+void TemplateProfiler::endSpan() {
+  assert(!OpenSpans.empty() && "no span to end");
+  uint64_t End = now();
+  OpenSpan Open = OpenSpans.back();
+  OpenSpans.pop_back();
+
+  Span &S = Spans[Open.Index];
+  S.Duration = End - S.Start;
+  S.Bytes = Context.getAllocator().getBytesAllocated() - Open.StartBytes;
+  S.SelfDuration = S.Duration - std::min(S.Duration, Open.ChildDuration);
+  S.SelfBytes = S.Bytes - std::min(S.Bytes, Open.ChildBytes);
+
+  if (!OpenSpans.empty()) {
+    OpenSpans.back().ChildDuration += S.Duration;
+    OpenSpans.back().ChildBytes += S.Bytes;
+  }
+}
+
+/// \brief Write \p Str as a JSON string literal.
+static void writeJSONString(raw_ostream &OS, StringRef Str) {
+  OS << '"';
+  for (char C : Str) {
+    switch (C) {
+    case '"':
+      OS << "\\\"";
+      break;
+    case '\\':
+      OS << "\\\\";
+      break;
+    case '\n':
+      OS << "\\n";
+      break;
+    case '\t':
+      OS << "\\t";
+      break;
+    default:
+      if (static_cast<unsigned char>(C) < 0x20)
+        OS << llvm::format("\\u%04x", static_cast<unsigned char>(C));
+      else
+        OS << C;
+      break;
+    }
+  }
+  OS << '"';
+}
+
+void TemplateProfiler::writeTrace(raw_ostream &OS) const {
+  OS << "{\"traceEvents\": [\n";
+  bool First = true;
+  for (const Span &S : Spans) {
+    if (!First)
+      OS << ",\n";
+    First = false;
+
+    OS << "{\"name\": ";
+    writeJSONString(OS, S.Name);
+    OS << ", \"cat\": ";
+    writeJSONString(OS, S.Kind);
+    OS << ", \"ph\": \"X\", \"pid\": 1, \"tid\": 1, \"ts\": " << S.Start
+       << ", \"dur\": " << S.Duration << ", \"args\": {\"template\": ";
+    writeJSONString(OS, S.Template);
+    OS << ", \"location\": ";
+    writeJSONString(OS, S.Location);
+    OS << ", \"bytes\": " << S.Bytes << ", \"self bytes\": " << S.SelfBytes
+       << "}}";
+  }
+  OS << "\n]}\n";
+}
+
+namespace {
+/// \brief The cost of all the work attributed to one template.
+struct TemplateCost {
+  StringRef Template;
+  unsigned Count;
+  uint64_t Duration;
+  uint64_t SelfDuration;
+  uint64_t Bytes;
+  uint64_t SelfBytes;
+};
+} // end anonymous namespace
+
+void TemplateProfiler::writeReport(raw_ostream &OS,
+                                   unsigned MaxEntries) const {
+  llvm::StringMap<unsigned> CostIndex;
+  std::vector<TemplateCost> Costs;
+  for (unsigned I = 0, N = Spans.size(); I != N; ++I) {
+    const Span &S = Spans[I];
+    auto Known = CostIndex.insert(
+        std::make_pair(StringRef(S.Template), unsigned(Costs.size())));
+    if (Known.second) {
+      TemplateCost Cost = {S.Template, 0, 0, 0, 0, 0};
+      Costs.push_back(Cost);
+    }
+    TemplateCost &Cost = Costs[Known.first->second];
+    ++Cost.Count;
+    Cost.SelfDuration += S.SelfDuration;
+    Cost.SelfBytes += S.SelfBytes;
+
+    // Only count the total cost of the outermost span attributed to a
+    // template, so that recursive instantiations aren't counted repeatedly.
+    bool Nested = false;
+    for (int P = S.Parent; P != -1 && !Nested; P = Spans[P].Parent)
+      Nested = Spans[P].Template == S.Template;
+    if (!Nested) {
+      Cost.Duration += S.Duration;
+      Cost.Bytes += S.Bytes;
+    }
+  }
+
+  std::stable_sort(Costs.begin(), Costs.end(),
+                   [](const TemplateCost &LHS, const TemplateCost &RHS) {
+                     return LHS.Duration > RHS.Duration;
+                   });
+
+  unsigned NumShown = std::min<size_t>(MaxEntries, Costs.size());
+  OS << "*** Template Profile:\n";
+  OS << Spans.size() << " instantiations and substitutions of "
+     << Costs.size() << " templates\n";
+  OS << "Top " << NumShown << " templates by time:\n";
+  OS << "   Time (ms)   Self (ms)        Bytes   Self bytes    Count  "
+        "Template\n";
+  for (unsigned I = 0; I != NumShown; ++I) {
+    const TemplateCost &Cost = Costs[I];
+    OS << llvm::format("%12.3f%12.3f%13llu%13llu%9u  ",
+                       Cost.Duration / 1000.0, Cost.SelfDuration / 1000.0,
+                       (unsigned long long)Cost.Bytes,
+                       (unsigned long long)Cost.SelfBytes, Cost.Count)
+       << Cost.Template << '\n';
+  }
+}
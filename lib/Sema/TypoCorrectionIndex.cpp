@@ -0,0 +1,122 @@
+//===--- TypoCorrectionIndex.cpp - Typo correction candidates -------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the TypoCorrectionIndex class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Sema/TypoCorrectionIndex.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/ExternalASTSource.h"
+#include "clang/Basic/IdentifierTable.h"
+#include "llvm/ADT/SmallVector.h"
+#include <memory>
+
+using namespace clang;
+
+void TypoCorrectionIndex::insert(StringRef Name) {
+  if (!IndexedNames.insert(Name).second)
+    return;
+
+  if (Nodes.empty()) {
+    Nodes.push_back(Node(Name, 0));
+    return;
+  }
+
+  unsigned Current = 0;
+  while (true) {
+    unsigned Distance =
+        Name.edit_distance(Nodes[Current].Name, /*AllowReplacements=*/true);
+    if (Distance == 0)
+      return;
+
+    // Descend into the child at the same distance, if there is one.
+    unsigned LastChild = 0;
+    unsigned Child = Nodes[Current].FirstChild;
+    while (Child && Nodes[Child].Distance != Distance) {
+      LastChild = Child;
+      Child = Nodes[Child].NextSibling;
+    }
+    if (Child) {
+      Current = Child;
+      continue;
+    }
+
+    unsigned NewNode = Nodes.size();
+    Nodes.push_back(Node(Name, Distance));
+    if (LastChild)
+      Nodes[LastChild].NextSibling = NewNode;
+    else
+      Nodes[Current].FirstChild = NewNode;
+    return;
+  }
+}
+
+void TypoCorrectionIndex::update() {
+  ExternalASTSource *Source = Context.getExternalSource();
+  uint32_t Generation = Source ? Source->getGeneration() : 0;
+  bool IndexExternal = !Built || Generation != ExternalGeneration;
+
+  if (!Built) {
+    Built = true;
+
+    // Builtins only get identifiers once they are mentioned, so index the
+    // names of the rest separately.
+    Context.BuiltinInfo.forEachSupportedBuiltinName(
+        [&](StringRef Name) { insert(Name); });
+  }
+
+  // Loading a module brings in new external identifiers, which we have no
+  // way to enumerate separately. Enumerate them all again; those already
+  // indexed cost no more than a hash lookup.
+  if (IndexExternal) {
+    ExternalGeneration = Generation;
+    if (IdentifierInfoLookup *External =
+            Context.Idents.getExternalIdentifierLookup()) {
+      std::unique_ptr<IdentifierIterator> Iter(External->getIdentifiers());
+      for (StringRef Name = Iter->Next(); !Name.empty(); Name = Iter->Next())
+        insert(Name);
+    }
+  }
+
+  // Identifiers are never removed from the table, so if its size hasn't
+  // changed, we've seen all of them.
+  if (IndexedIdentifiers.size() == Context.Idents.size())
+    return;
+  for (const auto &Ident : Context.Idents)
+    if (IndexedIdentifiers.insert(Ident.getValue()).second)
+      insert(Ident.getKey());
+}
+
+void TypoCorrectionIndex::lookup(StringRef Typo, unsigned MaxDistance,
+                                 llvm::function_ref<void(StringRef)> Callback) {
+  update();
+  if (Nodes.empty())
+    return;
+
+  SmallVector<unsigned, 32> Worklist;
+  Worklist.push_back(0);
+  while (!Worklist.empty()) {
+    const Node &N = Nodes[Worklist.pop_back_val()];
+    unsigned Distance =
+        Typo.edit_distance(N.Name, /*AllowReplacements=*/true);
+    if (Distance <= MaxDistance)
+      Callback(N.Name);
+
+    // By the triangle inequality, only the children whose distance from this
+    // node is within MaxDistance of the typo's can hold any matches.
+    for (unsigned Child = N.FirstChild; Child;
+         Child = Nodes[Child].NextSibling) {
+      unsigned ChildDistance = Nodes[Child].Distance;
+      if (ChildDistance + MaxDistance >= Distance &&
+          ChildDistance <= Distance + MaxDistance)
+        Worklist.push_back(Child);
+    }
+  }
+}
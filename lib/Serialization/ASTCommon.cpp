@@ -17,6 +17,8 @@
 #include "clang/Basic/IdentifierTable.h"
 #include "clang/Serialization/ASTDeserializationListener.h"
 #include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/Endian.h"
+#include <algorithm>
 
 using namespace clang;
 
@@ -172,6 +174,45 @@ unsigned serialization::ComputeHash(Selector Sel) {
   return R;
 }
 
+/// \brief Find the bits that the identifier whose hash is \p Hash sets in
+/// an identifier filter of \p NumWords words.
+///
+/// Each identifier sets two bits within a single word, so that a lookup
+/// touches only one word of the filter. The identifier table picks buckets
+/// by the low bits of the hash, so mix it before picking bits.
+static void getIdentifierFilterBits(unsigned Hash, unsigned NumWords,
+                                    unsigned &Word, uint64_t &Mask) {
+  uint64_t Mixed = uint64_t(Hash) * 0x9E3779B97F4A7C15ULL;
+  Word = unsigned(Mixed >> 32) % NumWords;
+  Mask = (uint64_t(1) << ((Mixed >> 20) & 63)) |
+         (uint64_t(1) << ((Mixed >> 26) & 63));
+}
+
+unsigned serialization::getIdentifierFilterSize(unsigned NumIdentifiers) {
+  // Twelve bits per identifier keeps false positives to a few percent.
+  return std::max(1u, (NumIdentifiers * 12 + 63) / 64);
+}
+
+void serialization::addToIdentifierFilter(MutableArrayRef<uint64_t> Filter,
+                                          unsigned Hash) {
+  unsigned Word;
+  uint64_t Mask;
+  getIdentifierFilterBits(Hash, Filter.size(), Word, Mask);
+  Filter[Word] |= Mask;
+}
+
+bool serialization::identifierFilterMayContain(const unsigned char *Filter,
+                                               unsigned NumWords,
+                                               unsigned Hash) {
+  using namespace llvm::support;
+  unsigned Word;
+  uint64_t Mask;
+  getIdentifierFilterBits(Hash, NumWords, Word, Mask);
+  uint64_t Bits =
+      endian::read<uint64_t, little, unaligned>(Filter + Word * sizeof(Bits));
+  return (Bits & Mask) == Mask;
+}
+
 const DeclContext *
 serialization::getDefinitiveDeclContext(const DeclContext *DC) {
   switch (DC->getDeclKind()) {
@@ -71,6 +71,20 @@ TypeID MakeTypeID(ASTContext &Context, QualType T, IdxForTypeTy IdxForType) {
 
 unsigned ComputeHash(Selector Sel);
 
+/// \brief The number of 64-bit words in the identifier filter (see
+/// IDENTIFIER_FILTER) for an identifier table with \p NumIdentifiers
+/// entries.
+unsigned getIdentifierFilterSize(unsigned NumIdentifiers);
+
+/// \brief Add the identifier whose hash is \p Hash to \p Filter.
+void addToIdentifierFilter(MutableArrayRef<uint64_t> Filter, unsigned Hash);
+
+/// \brief Determine whether the identifier whose hash is \p Hash may be in
+/// the table summarized by the identifier filter with \p NumWords words
+/// stored at \p Filter.
+bool identifierFilterMayContain(const unsigned char *Filter, unsigned NumWords,
+                                unsigned Hash);
+
 /// \brief Retrieve the "definitive" declaration that provides all of the
 /// visible entries for the given declaration context, if there is one.
 ///
@@ -68,6 +68,7 @@
 #include "llvm/ADT/APInt.h"
 #include "llvm/ADT/APSInt.h"
 #include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/Triple.h"
@@ -875,6 +876,11 @@ IdentifierInfo *ASTIdentifierLookupTrait::ReadData(const internal_key_type& k,
 
   IdentID ID = Reader.getGlobalIdentifierID(F, RawID);
   if (!IsInteresting) {
+    // A PCH records every identifier with a builtin ID as interesting, so any
+    // builtin ID here was assigned lazily when getOwn() created it.
+    if (!F.isModule() && II->getBuiltinID())
+      II->setBuiltinID(0);
+
     // For uninteresting identifiers, there's nothing else to do. Just notify
     // the reader that we've finished loading this identifier.
     Reader.SetIdentifierInfo(ID, II);
@@ -1789,16 +1795,19 @@ namespace {
     unsigned PriorGeneration;
     unsigned &NumIdentifierLookups;
     unsigned &NumIdentifierLookupHits;
+    unsigned &NumIdentifierFilterRejects;
     IdentifierInfo *Found;
 
   public:
     IdentifierLookupVisitor(StringRef Name, unsigned PriorGeneration,
                             unsigned &NumIdentifierLookups,
-                            unsigned &NumIdentifierLookupHits)
+                            unsigned &NumIdentifierLookupHits,
+                            unsigned &NumIdentifierFilterRejects)
       : Name(Name), NameHash(ASTIdentifierLookupTrait::ComputeHash(Name)),
         PriorGeneration(PriorGeneration),
         NumIdentifierLookups(NumIdentifierLookups),
         NumIdentifierLookupHits(NumIdentifierLookupHits),
+        NumIdentifierFilterRejects(NumIdentifierFilterRejects),
         Found()
     {
     }
@@ -1813,9 +1822,16 @@ namespace {
       if (!IdTable)
         return false;
 
+      ++NumIdentifierLookups;
+      if (M.IdentifierFilter &&
+          !identifierFilterMayContain(M.IdentifierFilter,
+                                      M.IdentifierFilterSize, NameHash)) {
+        ++NumIdentifierFilterRejects;
+        return false;
+      }
+
       ASTIdentifierLookupTrait Trait(IdTable->getInfoObj().getReader(), M,
                                      Found);
-      ++NumIdentifierLookups;
       ASTIdentifierLookupTable::iterator Pos =
           IdTable->find_hashed(Name, NameHash, &Trait);
       if (Pos == IdTable->end())
@@ -1856,7 +1872,8 @@ void ASTReader::updateOutOfDateIdentifier(IdentifierInfo &II) {
 
   IdentifierLookupVisitor Visitor(II.getName(), PriorGeneration,
                                   NumIdentifierLookups,
-                                  NumIdentifierLookupHits);
+                                  NumIdentifierLookupHits,
+                                  NumIdentifierFilterRejects);
   ModuleMgr.visit(Visitor, HitsPtr);
   markIdentifierUpToDate(&II);
 }
@@ -2776,6 +2793,13 @@ ASTReader::ReadASTBlock(ModuleFile &F, unsigned ClientLoadCapabilities) {
       }
       break;
 
+    case IDENTIFIER_FILTER:
+      F.IdentifierFilter = (const unsigned char *)Blob.data();
+      F.IdentifierFilterSize = Blob.size() / sizeof(uint64_t);
+      if (!F.IdentifierFilterSize)
+        F.IdentifierFilter = nullptr;
+      break;
+
     case IDENTIFIER_OFFSET: {
       if (F.LocalNumIdentifiers != 0) {
         Error("duplicate IDENTIFIER_OFFSET record in AST file");
@@ -3082,9 +3106,16 @@ ASTReader::ReadASTBlock(ModuleFile &F, unsigned ClientLoadCapabilities) {
         Error("invalid DECL_UPDATE_OFFSETS block in AST file");
         return Failure;
       }
+      if (F.DeclUpdateOffsets.empty())
+        ModulesWithDeclUpdates.push_back(&F);
+      F.DeclUpdateOffsets.reserve(F.DeclUpdateOffsets.size() +
+                                  Record.size() / 2);
       for (unsigned I = 0, N = Record.size(); I != N; I += 2) {
         GlobalDeclID ID = getGlobalDeclID(F, Record[I]);
-        DeclUpdateOffsets[ID].push_back(std::make_pair(&F, Record[I + 1]));
+        F.DeclUpdateOffsets.push_back(std::make_pair(ID, Record[I + 1]));
+        if (ID >= DeclsWithUpdates.size())
+          DeclsWithUpdates.resize(ID + 1);
+        DeclsWithUpdates.set(ID);
 
         // If we've already loaded the decl, perform the updates when we finish
         // loading this block.
@@ -3092,6 +3123,12 @@ ASTReader::ReadASTBlock(ModuleFile &F, unsigned ClientLoadCapabilities) {
           PendingUpdateRecords.push_back(
               PendingUpdateRecord(ID, D, /*JustLoaded=*/false));
       }
+
+      // Updates to the same declaration must be applied in the order they
+      // were written.
+      std::stable_sort(F.DeclUpdateOffsets.begin(), F.DeclUpdateOffsets.end(),
+                       llvm::less_first());
+      F.DeclUpdateOffsetsApplied.resize(F.DeclUpdateOffsets.size());
       break;
     }
 
@@ -3919,8 +3956,6 @@ ASTReader::ASTReadResult ASTReader::ReadAST(StringRef FileName,
   return Success;
 }
 
-static ASTFileSignature readASTFileSignature(StringRef PCH);
-
 /// \brief Whether \p Stream starts with the AST/PCH file magic number 'CPCH'.
 static bool startsWithASTFileMagic(BitstreamCursor &Stream) {
   return Stream.canSkipToPos(4) &&
@@ -4417,9 +4452,7 @@ void ASTReader::finalizeForWriting() {
   // Nothing to do for now.
 }
 
-/// \brief Reads and return the signature record from \p PCH's control block, or
-/// else returns 0.
-static ASTFileSignature readASTFileSignature(StringRef PCH) {
+ASTFileSignature ASTReader::readASTFileSignature(StringRef PCH) {
   BitstreamCursor Stream(PCH);
   if (!startsWithASTFileMagic(Stream))
     return ASTFileSignature();
@@ -7286,6 +7319,15 @@ void ASTReader::StartTranslationUnit(ASTConsumer *Consumer) {
     DeserializationListener->ReaderInitialized(this);
 }
 
+/// \brief Count the entities in [Base, Base + Num) of one of the reader's
+/// "loaded" tables that have actually been deserialized.
+template <typename T>
+static unsigned countLoaded(const std::vector<T> &Loaded, unsigned Base,
+                            unsigned Num, const T &Empty) {
+  return Num - std::count(Loaded.begin() + Base, Loaded.begin() + Base + Num,
+                          Empty);
+}
+
 void ASTReader::PrintStats() {
   std::fprintf(stderr, "*** AST File Statistics:\n");
 
@@ -7374,6 +7416,43 @@ void ASTReader::PrintStats() {
                  NumIdentifierLookupHits, NumIdentifierLookups,
                  (double)NumIdentifierLookupHits*100.0/NumIdentifierLookups);
   }
+  if (NumIdentifierFilterRejects) {
+    std::fprintf(stderr,
+                 "  %u / %u identifier table lookups rejected by filters "
+                 "(%f%%)\n",
+                 NumIdentifierFilterRejects, NumIdentifierLookups,
+                 (double)NumIdentifierFilterRejects*100.0/NumIdentifierLookups);
+  }
+
+  // Break the above down by the AST file that provides each entity, so that
+  // it's clear how much of each module or PCH was actually deserialized.
+  auto PrintLoaded = [](const char *What, unsigned NumLoaded, unsigned Num) {
+    if (Num)
+      std::fprintf(stderr, "    %u/%u %s read (%f%%)\n", NumLoaded, Num, What,
+                   ((float)NumLoaded/Num * 100));
+  };
+  for (ModuleFile &F : ModuleMgr) {
+    std::fprintf(stderr, "  AST file '%s':\n", F.FileName.c_str());
+    PrintLoaded("types",
+                countLoaded(TypesLoaded, F.BaseTypeIndex, F.LocalNumTypes,
+                            QualType()),
+                F.LocalNumTypes);
+    PrintLoaded("declarations",
+                countLoaded(DeclsLoaded, F.BaseDeclID, F.LocalNumDecls,
+                            (Decl *)nullptr),
+                F.LocalNumDecls);
+    PrintLoaded("identifiers",
+                countLoaded(IdentifiersLoaded, F.BaseIdentifierID,
+                            F.LocalNumIdentifiers, (IdentifierInfo *)nullptr),
+                F.LocalNumIdentifiers);
+    PrintLoaded("macros",
+                countLoaded(MacrosLoaded, F.BaseMacroID, F.LocalNumMacros,
+                            (MacroInfo *)nullptr),
+                F.LocalNumMacros);
+    PrintLoaded("declaration updates",
+                F.DeclUpdateOffsetsApplied.count(),
+                F.DeclUpdateOffsets.size());
+  }
 
   if (GlobalIndex) {
     std::fprintf(stderr, "\n");
@@ -7530,7 +7609,8 @@ IdentifierInfo *ASTReader::get(StringRef Name) {
 
   IdentifierLookupVisitor Visitor(Name, /*PriorGeneration=*/0,
                                   NumIdentifierLookups,
-                                  NumIdentifierLookupHits);
+                                  NumIdentifierLookupHits,
+                                  NumIdentifierFilterRejects);
 
   // We don't need to do identifier table lookups in C++ modules (we preload
   // all interesting declarations, and don't need to use the scope for name
@@ -3701,10 +3701,8 @@ void ASTReader::loadDeclUpdateRecords(PendingUpdateRecord &Record) {
   serialization::GlobalDeclID ID = Record.ID;
   Decl *D = Record.D;
   ProcessingUpdatesRAIIObj ProcessingUpdates(*this);
-  DeclUpdateOffsetsMap::iterator UpdI = DeclUpdateOffsets.find(ID);
-  if (UpdI != DeclUpdateOffsets.end()) {
-    auto UpdateOffsets = std::move(UpdI->second);
-    DeclUpdateOffsets.erase(UpdI);
+  if (ID < DeclsWithUpdates.size() && DeclsWithUpdates.test(ID)) {
+    DeclsWithUpdates.reset(ID);
 
     // Check if this decl was interesting to the consumer. If we just loaded
     // the declaration, then we know it was interesting and we skip the call
@@ -3712,29 +3710,41 @@ void ASTReader::loadDeclUpdateRecords(PendingUpdateRecord &Record) {
     // current ASTReader state.
     bool WasInteresting =
         Record.JustLoaded || isConsumerInterestedIn(Context, D, false);
-    for (auto &FileAndOffset : UpdateOffsets) {
-      ModuleFile *F = FileAndOffset.first;
-      uint64_t Offset = FileAndOffset.second;
-      llvm::BitstreamCursor &Cursor = F->DeclsCursor;
-      SavedStreamPosition SavedPosition(Cursor);
-      Cursor.JumpToBit(Offset);
-      unsigned Code = Cursor.ReadCode();
-      ASTRecordReader Record(*this, *F);
-      unsigned RecCode = Record.readRecord(Cursor, Code);
-      (void)RecCode;
-      assert(RecCode == DECL_UPDATES && "Expected DECL_UPDATES record!");
-
-      ASTDeclReader Reader(*this, Record, RecordLocation(F, Offset), ID,
-                           SourceLocation());
-      Reader.UpdateDecl(D);
-
-      // We might have made this declaration interesting. If so, remember that
-      // we need to hand it off to the consumer.
-      if (!WasInteresting &&
-          isConsumerInterestedIn(Context, D, Reader.hasPendingBody())) {
-        PotentiallyInterestingDecls.push_back(
-            InterestingDecl(D, Reader.hasPendingBody()));
-        WasInteresting = true;
+
+    // Apply the updates from each module file in load order, skipping any we
+    // applied when the declaration was last loaded.
+    for (ModuleFile *F : ModulesWithDeclUpdates) {
+      auto Updates = std::equal_range(
+          F->DeclUpdateOffsets.begin(), F->DeclUpdateOffsets.end(),
+          std::make_pair(ID, uint64_t()), llvm::less_first());
+      for (auto UpdI = Updates.first; UpdI != Updates.second; ++UpdI) {
+        unsigned Index = UpdI - F->DeclUpdateOffsets.begin();
+        if (F->DeclUpdateOffsetsApplied.test(Index))
+          continue;
+        F->DeclUpdateOffsetsApplied.set(Index);
+
+        uint64_t Offset = UpdI->second;
+        llvm::BitstreamCursor &Cursor = F->DeclsCursor;
+        SavedStreamPosition SavedPosition(Cursor);
+        Cursor.JumpToBit(Offset);
+        unsigned Code = Cursor.ReadCode();
+        ASTRecordReader Record(*this, *F);
+        unsigned RecCode = Record.readRecord(Cursor, Code);
+        (void)RecCode;
+        assert(RecCode == DECL_UPDATES && "Expected DECL_UPDATES record!");
+
+        ASTDeclReader Reader(*this, Record, RecordLocation(F, Offset), ID,
+                             SourceLocation());
+        Reader.UpdateDecl(D);
+
+        // We might have made this declaration interesting. If so, remember
+        // that we need to hand it off to the consumer.
+        if (!WasInteresting &&
+            isConsumerInterestedIn(Context, D, Reader.hasPendingBody())) {
+          PotentiallyInterestingDecls.push_back(
+              InterestingDecl(D, Reader.hasPendingBody()));
+          WasInteresting = true;
+        }
       }
     }
   }
@@ -73,6 +73,7 @@
 #include "llvm/Bitcode/BitstreamWriter.h"
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/Compression.h"
+#include "llvm/Support/Endian.h"
 #include "llvm/Support/EndianStream.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/ErrorHandling.h"
@@ -81,6 +82,7 @@
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Process.h"
 #include "llvm/Support/SHA1.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cassert>
@@ -846,7 +848,7 @@ void ASTWriter::WriteTypeAbbrevs() {
   Abv->Add(BitCodeAbbrevOp(serialization::TYPE_EXT_QUAL));
   Abv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6));   // Type
   Abv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 3));   // Quals
-  TypeExtQualAbbrev = Stream.EmitAbbrev(std::move(Abv));
+  TypeExtQualAbbrev = EmitDeclTypesAbbrev(std::move(Abv));
 
   // Abbreviation for TYPE_FUNCTION_PROTO
   Abv = std::make_shared<BitCodeAbbrev>();
@@ -868,7 +870,7 @@ void ASTWriter::WriteTypeAbbrevs() {
   Abv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6));   // NumParams
   Abv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Array));
   Abv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6));   // Params
-  TypeFunctionProtoAbbrev = Stream.EmitAbbrev(std::move(Abv));
+  TypeFunctionProtoAbbrev = EmitDeclTypesAbbrev(std::move(Abv));
 }
 
 //===----------------------------------------------------------------------===//
@@ -1065,6 +1067,7 @@ void ASTWriter::WriteBlockInfoBlock() {
   RECORD(DECL_OFFSET);
   RECORD(IDENTIFIER_OFFSET);
   RECORD(IDENTIFIER_TABLE);
+  RECORD(IDENTIFIER_FILTER);
   RECORD(EAGERLY_DESERIALIZED_DECLS);
   RECORD(MODULAR_CODEGEN_DECLS);
   RECORD(SPECIAL_TYPES);
@@ -2058,28 +2061,72 @@ void ASTWriter::WriteHeaderSearch(const HeaderSearch &HS) {
     free(const_cast<char *>(SavedStrings[I]));
 }
 
-static void emitBlob(llvm::BitstreamWriter &Stream, StringRef Blob,
+namespace {
+
+/// \brief A buffer to be embedded in the source manager block, compressed
+/// if possible.
+struct SLocBlob {
+  /// \brief The buffer, including its terminating null character.
+  StringRef Blob;
+
+  /// \brief The buffer without its terminating null character, compressed.
+  SmallString<0> CompressedBlob;
+
+  /// \brief Whether \c CompressedBlob holds the compressed buffer.
+  bool Compressed = false;
+
+  void compress() {
+    // We expect that almost all PCM consumers will not want the contents of
+    // the buffer.
+    if (!llvm::zlib::isAvailable())
+      return;
+    llvm::Error E = llvm::zlib::compress(Blob.drop_back(1), CompressedBlob);
+    if (E) {
+      llvm::consumeError(std::move(E));
+      return;
+    }
+    Compressed = true;
+  }
+};
+
+} // end anonymous namespace
+
+/// \brief Compress \p Blobs, in parallel if there is enough data to make it
+/// worthwhile. Compression is the only expensive part of embedding a buffer,
+/// and it doesn't depend on anything else being written, so the output is
+/// the same either way.
+static void compressBlobs(MutableArrayRef<SLocBlob> Blobs) {
+  uint64_t TotalSize = 0;
+  for (const SLocBlob &B : Blobs)
+    TotalSize += B.Blob.size();
+
+  if (Blobs.size() < 2 || TotalSize < (1 << 20)) {
+    for (SLocBlob &B : Blobs)
+      B.compress();
+    return;
+  }
+
+  llvm::ThreadPool Pool;
+  for (SLocBlob &B : Blobs)
+    Pool.async([&B] { B.compress(); });
+  Pool.wait();
+}
+
+static void emitBlob(llvm::BitstreamWriter &Stream, const SLocBlob &B,
                      unsigned SLocBufferBlobCompressedAbbrv,
                      unsigned SLocBufferBlobAbbrv) {
   typedef ASTWriter::RecordData::value_type RecordDataType;
 
-  // Compress the buffer if possible. We expect that almost all PCM
-  // consumers will not want its contents.
-  SmallString<0> CompressedBuffer;
-  if (llvm::zlib::isAvailable()) {
-    llvm::Error E = llvm::zlib::compress(Blob.drop_back(1), CompressedBuffer);
-    if (!E) {
-      RecordDataType Record[] = {SM_SLOC_BUFFER_BLOB_COMPRESSED,
-                                 Blob.size() - 1};
-      Stream.EmitRecordWithBlob(SLocBufferBlobCompressedAbbrv, Record,
-                                CompressedBuffer);
-      return;
-    }
-    llvm::consumeError(std::move(E));
+  if (B.Compressed) {
+    RecordDataType Record[] = {SM_SLOC_BUFFER_BLOB_COMPRESSED,
+                               B.Blob.size() - 1};
+    Stream.EmitRecordWithBlob(SLocBufferBlobCompressedAbbrv, Record,
+                              B.CompressedBlob);
+    return;
   }
 
   RecordDataType Record[] = {SM_SLOC_BUFFER_BLOB};
-  Stream.EmitRecordWithBlob(SLocBufferBlobAbbrv, Record, Blob);
+  Stream.EmitRecordWithBlob(SLocBufferBlobAbbrv, Record, B.Blob);
 }
 
 /// \brief Writes the block containing the serialized form of the
@@ -2105,6 +2152,28 @@ void ASTWriter::WriteSourceManagerBlock(SourceManager &SourceMgr,
       CreateSLocBufferBlobAbbrev(Stream, true);
   unsigned SLocExpansionAbbrv = CreateSLocExpansionAbbrev(Stream);
 
+  // Collect the buffers we will embed, and compress them up front. We add
+  // one to their sizes so that we capture the trailing NULL that is required
+  // by llvm::MemoryBuffer::getMemBuffer (on the reader side) when a buffer is
+  // written uncompressed.
+  std::vector<SLocBlob> Blobs;
+  for (unsigned I = 1, N = SourceMgr.local_sloc_entry_size(); I != N; ++I) {
+    const SrcMgr::SLocEntry &SLoc = SourceMgr.getLocalSLocEntry(I);
+    if (!SLoc.isFile())
+      continue;
+    const SrcMgr::ContentCache *Content = SLoc.getFile().getContentCache();
+    if (Content->OrigEntry && !Content->BufferOverridden &&
+        !Content->IsTransient)
+      continue;
+    const llvm::MemoryBuffer *Buffer =
+        Content->getBuffer(PP.getDiagnostics(), PP.getSourceManager());
+    Blobs.emplace_back();
+    Blobs.back().Blob =
+        StringRef(Buffer->getBufferStart(), Buffer->getBufferSize() + 1);
+  }
+  compressBlobs(Blobs);
+  unsigned NextBlob = 0;
+
   // Write out the source location entry table. We skip the first
   // entry, which is always the same dummy entry.
   std::vector<uint32_t> SLocEntryOffsets;
@@ -2185,12 +2254,8 @@ void ASTWriter::WriteSourceManagerBlock(SourceManager &SourceMgr,
       }
 
       if (EmitBlob) {
-        // Include the implicit terminating null character in the on-disk buffer
-        // if we're writing it uncompressed.
-        const llvm::MemoryBuffer *Buffer =
-            Content->getBuffer(PP.getDiagnostics(), PP.getSourceManager());
-        StringRef Blob(Buffer->getBufferStart(), Buffer->getBufferSize() + 1);
-        emitBlob(Stream, Blob, SLocBufferBlobCompressedAbbrv,
+        assert(NextBlob < Blobs.size() && "Missed embedded buffer");
+        emitBlob(Stream, Blobs[NextBlob++], SLocBufferBlobCompressedAbbrv,
                  SLocBufferBlobAbbrv);
       }
     } else {
@@ -2212,6 +2277,7 @@ void ASTWriter::WriteSourceManagerBlock(SourceManager &SourceMgr,
     }
   }
 
+  assert(NextBlob == Blobs.size() && "Embedded buffers out of sync");
   Stream.ExitBlock();
 
   if (SLocEntryOffsets.empty())
@@ -2944,6 +3010,192 @@ void ASTWriter::WritePragmaDiagnosticMappings(const DiagnosticsEngine &Diag,
   Stream.EmitRecord(DIAG_PRAGMA_MAPPINGS, Record);
 }
 
+//===----------------------------------------------------------------------===//
+// Deferred Record Emission
+//===----------------------------------------------------------------------===//
+
+unsigned
+ASTWriter::EmitDeclTypesAbbrev(std::shared_ptr<llvm::BitCodeAbbrev> Abbrev) {
+  DeclTypesAbbrevs.push_back(Abbrev);
+  return Stream.EmitAbbrev(std::move(Abbrev));
+}
+
+uint64_t ASTWriter::getCurrentRecordOffset() const {
+  if (DeferringRecords)
+    return DeferredRecordOffsets.size() + DeferredRecords.size() + 1;
+  return Stream.GetCurrentBitNo();
+}
+
+uint64_t ASTWriter::EmitRecord(unsigned Code, RecordDataImpl &Record,
+                               unsigned Abbrev,
+                               ArrayRef<unsigned> RelativeOffsets,
+                               ArrayRef<unsigned> AbsoluteOffsets) {
+  uint64_t Offset = getCurrentRecordOffset();
+  if (!DeferringRecords) {
+    // Convert offsets into relative form.
+    for (unsigned I : RelativeOffsets) {
+      auto &StoredOffset = Record[I];
+      assert(StoredOffset < Offset && "invalid offset");
+      if (StoredOffset)
+        StoredOffset = Offset - StoredOffset;
+    }
+    Stream.EmitRecord(Code, Record, Abbrev);
+    return Offset;
+  }
+
+  DeferredRecords.emplace_back();
+  DeferredRecord &R = DeferredRecords.back();
+  R.Code = Code;
+  R.Abbrev = Abbrev;
+  R.Vals.append(Record.begin(), Record.end());
+  R.HasBlob = false;
+  for (unsigned I : RelativeOffsets) {
+    assert(Record[I] < Offset && "invalid offset");
+    if (Record[I])
+      R.Offsets.push_back({I, true});
+  }
+  for (unsigned I : AbsoluteOffsets)
+    R.Offsets.push_back({I, false});
+
+  // Keep the amount of queued data bounded.
+  if (DeferredRecords.size() >= (1 << 14))
+    WriteDeferredRecords();
+  return Offset;
+}
+
+uint64_t ASTWriter::EmitRecordWithBlob(unsigned Abbrev, RecordDataRef Record,
+                                       StringRef Blob) {
+  uint64_t Offset = getCurrentRecordOffset();
+  if (!DeferringRecords) {
+    Stream.EmitRecordWithBlob(Abbrev, Record, Blob);
+    return Offset;
+  }
+
+  DeferredRecords.emplace_back();
+  DeferredRecord &R = DeferredRecords.back();
+  R.Code = 0;
+  R.Abbrev = Abbrev;
+  R.Vals.append(Record.begin(), Record.end());
+  R.Blob = Blob.str();
+  R.HasBlob = true;
+  return Offset;
+}
+
+uint64_t ASTWriter::resolveRecordOffset(uint64_t Offset) const {
+  assert(Offset && Offset <= DeferredRecordOffsets.size() &&
+         "record has not been written");
+  return DeferredRecordOffsets[Offset - 1];
+}
+
+/// \brief Whether the encoding of \p R depends on where it ends up.
+static bool isPositionDependent(const ASTWriter::DeferredRecord &R) {
+  return R.HasBlob || !R.Offsets.empty();
+}
+
+namespace {
+
+/// \brief A run of deferred records, encoded into a buffer of its own.
+struct DeferredRecordChunk {
+  unsigned Begin = 0;
+  ArrayRef<ASTWriter::DeferredRecord> Records;
+  SmallVector<char, 0> Buffer;
+
+  /// \brief The bit position of each record in \c Buffer, followed by the
+  /// end of the last one. Records that depend on their position take up
+  /// no bits here.
+  std::vector<uint64_t> Bits;
+
+  void encode(ArrayRef<std::shared_ptr<llvm::BitCodeAbbrev>> Abbrevs) {
+    // Set up the same abbreviations as the DECLTYPES block, so that records
+    // are encoded exactly as they would be there.
+    llvm::BitstreamWriter Stream(Buffer);
+    Stream.EnterSubblock(DECLTYPES_BLOCK_ID, /*bits for abbreviations*/5);
+    for (const auto &Abbrev : Abbrevs)
+      Stream.EmitAbbrev(Abbrev);
+
+    Bits.reserve(Records.size() + 1);
+    for (const ASTWriter::DeferredRecord &R : Records) {
+      Bits.push_back(Stream.GetCurrentBitNo());
+      if (!isPositionDependent(R))
+        Stream.EmitRecord(R.Code, R.Vals, R.Abbrev);
+    }
+    Bits.push_back(Stream.GetCurrentBitNo());
+    Stream.ExitBlock();
+  }
+};
+
+} // end anonymous namespace
+
+/// \brief Append bits [\p Begin, \p End) of \p Buffer, which was written by
+/// a BitstreamWriter, to \p Stream.
+static void appendBits(llvm::BitstreamWriter &Stream, ArrayRef<char> Buffer,
+                       uint64_t Begin, uint64_t End) {
+  using namespace llvm::support;
+
+  while (Begin != End) {
+    uint32_t Word = endian::read32le(Buffer.data() + Begin / 32 * 4);
+    unsigned Shift = Begin % 32;
+    unsigned NumBits = std::min<uint64_t>(32 - Shift, End - Begin);
+    Word >>= Shift;
+    if (NumBits != 32)
+      Word &= (1U << NumBits) - 1;
+    Stream.Emit(Word, NumBits);
+    Begin += NumBits;
+  }
+}
+
+void ASTWriter::WriteDeferredRecords() {
+  // Encode runs of records on separate threads. A record doesn't depend on
+  // where it ends up unless it contains a blob or the offset of another
+  // record, so the encoding of everything else can just be copied into the
+  // stream afterwards, giving the same bits as writing it there directly.
+  const unsigned ChunkSize = 256;
+  std::vector<DeferredRecordChunk> Chunks((DeferredRecords.size() +
+                                           ChunkSize - 1) / ChunkSize);
+  for (unsigned I = 0, N = Chunks.size(); I != N; ++I) {
+    Chunks[I].Begin = I * ChunkSize;
+    Chunks[I].Records = makeArrayRef(DeferredRecords).slice(
+        I * ChunkSize,
+        std::min<size_t>(ChunkSize, DeferredRecords.size() - I * ChunkSize));
+  }
+
+  if (ParallelRecordEncoding && Chunks.size() > 1) {
+    llvm::ThreadPool Pool;
+    for (DeferredRecordChunk &C : Chunks)
+      Pool.async([&C, this] { C.encode(DeclTypesAbbrevs); });
+    Pool.wait();
+  } else {
+    for (DeferredRecordChunk &C : Chunks)
+      C.encode(DeclTypesAbbrevs);
+  }
+
+  // Stitch the chunks together, writing the remaining records in between
+  // now that the offsets they refer to are known.
+  for (DeferredRecordChunk &C : Chunks) {
+    for (unsigned I = 0, N = C.Records.size(); I != N; ++I) {
+      uint64_t Offset = Stream.GetCurrentBitNo();
+      DeferredRecordOffsets.push_back(Offset);
+
+      DeferredRecord &R = DeferredRecords[C.Begin + I];
+      if (!isPositionDependent(R)) {
+        appendBits(Stream, C.Buffer, C.Bits[I], C.Bits[I + 1]);
+        continue;
+      }
+
+      for (const auto &O : R.Offsets) {
+        uint64_t Target = resolveRecordOffset(R.Vals[O.first]);
+        R.Vals[O.first] = O.second ? Offset - Target : Target;
+      }
+      if (R.HasBlob)
+        Stream.EmitRecordWithBlob(R.Abbrev, R.Vals, R.Blob);
+      else
+        Stream.EmitRecord(R.Code, R.Vals, R.Abbrev);
+    }
+  }
+
+  DeferredRecords.clear();
+}
+
 //===----------------------------------------------------------------------===//
 // Type Serialization
 //===----------------------------------------------------------------------===//
@@ -2990,7 +3242,7 @@ uint64_t ASTWriter::WriteDeclContextLexicalBlock(ASTContext &Context,
   if (DC->decls_empty())
     return 0;
 
-  uint64_t Offset = Stream.GetCurrentBitNo();
+  uint64_t Offset = getCurrentRecordOffset();
   SmallVector<uint32_t, 128> KindDeclPairs;
   for (const auto *D : DC->decls()) {
     KindDeclPairs.push_back(D->getKind());
@@ -2999,8 +3251,7 @@ uint64_t ASTWriter::WriteDeclContextLexicalBlock(ASTContext &Context,
 
   ++NumLexicalDeclContexts;
   RecordData::value_type Record[] = {DECL_CONTEXT_LEXICAL};
-  Stream.EmitRecordWithBlob(DeclContextLexicalAbbrev, Record,
-                            bytes(KindDeclPairs));
+  EmitRecordWithBlob(DeclContextLexicalAbbrev, Record, bytes(KindDeclPairs));
   return Offset;
 }
 
@@ -3544,6 +3795,7 @@ void ASTWriter::WriteIdentifierTable(Preprocessor &PP,
     // Create the on-disk hash table representation. We only store offsets
     // for identifiers that appear here for the first time.
     IdentifierOffsets.resize(NextIdentID - FirstIdentID);
+    SmallVector<unsigned, 128> IdentifierHashes;
     for (auto IdentIDPair : IdentifierIDs) {
       auto *II = const_cast<IdentifierInfo *>(IdentIDPair.first);
       IdentID ID = IdentIDPair.second;
@@ -3553,8 +3805,10 @@ void ASTWriter::WriteIdentifierTable(Preprocessor &PP,
       if (ID >= FirstIdentID || !Chain || !II->isFromAST()
           || II->hasChangedSinceDeserialization() ||
           (Trait.needDecls() &&
-           II->hasFETokenInfoChangedSinceDeserialization()))
+           II->hasFETokenInfoChangedSinceDeserialization())) {
         Generator.insert(II, ID, Trait);
+        IdentifierHashes.push_back(Trait.ComputeHash(II));
+      }
     }
 
     // Create the on-disk hash table in a buffer.
@@ -3578,6 +3832,33 @@ void ASTWriter::WriteIdentifierTable(Preprocessor &PP,
     // Write the identifier table
     RecordData::value_type Record[] = {IDENTIFIER_TABLE, BucketOffset};
     Stream.EmitRecordWithBlob(IDTableAbbrev, Record, IdentifierTable);
+
+    // Write the filter over the identifier table, so that lookups of
+    // identifiers that aren't in it (most of them, when many AST files are
+    // loaded) needn't touch it.
+    if (!IdentifierHashes.empty()) {
+      std::vector<uint64_t> Filter(
+          getIdentifierFilterSize(IdentifierHashes.size()));
+      for (unsigned Hash : IdentifierHashes)
+        addToIdentifierFilter(Filter, Hash);
+
+      SmallString<256> FilterData;
+      {
+        using namespace llvm::support;
+        llvm::raw_svector_ostream Out(FilterData);
+        endian::Writer<little> Writer(Out);
+        for (uint64_t Word : Filter)
+          Writer.write<uint64_t>(Word);
+      }
+
+      Abbrev = std::make_shared<BitCodeAbbrev>();
+      Abbrev->Add(BitCodeAbbrevOp(IDENTIFIER_FILTER));
+      Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob));
+      unsigned FilterAbbrev = Stream.EmitAbbrev(std::move(Abbrev));
+
+      RecordData::value_type FilterRecord[] = {IDENTIFIER_FILTER};
+      Stream.EmitRecordWithBlob(FilterAbbrev, FilterRecord, FilterData);
+    }
   }
 
   // Write the offsets table for identifier IDs.
@@ -4005,7 +4286,7 @@ uint64_t ASTWriter::WriteDeclContextVisibleBlock(ASTContext &Context,
   // representation is the same for both cases: a declaration name,
   // followed by a size, followed by references to the visible
   // declarations that have that name.
-  uint64_t Offset = Stream.GetCurrentBitNo();
+  uint64_t Offset = getCurrentRecordOffset();
   StoredDeclsMap *Map = DC->buildLookup();
   if (!Map || Map->empty())
     return 0;
@@ -4016,8 +4297,7 @@ uint64_t ASTWriter::WriteDeclContextVisibleBlock(ASTContext &Context,
 
   // Write the lookup table
   RecordData::value_type Record[] = {DECL_CONTEXT_VISIBLE};
-  Stream.EmitRecordWithBlob(DeclContextVisibleLookupAbbrev, Record,
-                            LookupTable);
+  EmitRecordWithBlob(DeclContextVisibleLookupAbbrev, Record, LookupTable);
   ++NumVisibleDeclContexts;
   return Offset;
 }
@@ -4362,9 +4642,10 @@ void ASTWriter::SetSelectorOffset(Selector Sel, uint32_t Offset) {
 ASTWriter::ASTWriter(llvm::BitstreamWriter &Stream,
                      SmallVectorImpl<char> &Buffer, MemoryBufferCache &PCMCache,
                      ArrayRef<std::shared_ptr<ModuleFileExtension>> Extensions,
-                     bool IncludeTimestamps)
+                     bool IncludeTimestamps, bool ParallelRecordEncoding)
     : Stream(Stream), Buffer(Buffer), PCMCache(PCMCache),
-      IncludeTimestamps(IncludeTimestamps) {
+      IncludeTimestamps(IncludeTimestamps),
+      ParallelRecordEncoding(ParallelRecordEncoding) {
   for (const auto &Ext : Extensions) {
     if (auto Writer = Ext->createExtensionWriter(*this))
       ModuleFileExtensionWriters.push_back(std::move(Writer));
@@ -4761,8 +5042,10 @@ ASTFileSignature ASTWriter::WriteASTCore(Sema &SemaRef, StringRef isysroot,
   // Keep writing types, declarations, and declaration update records
   // until we've emitted all of them.
   Stream.EnterSubblock(DECLTYPES_BLOCK_ID, /*bits for abbreviations*/5);
+  DeclTypesAbbrevs.clear();
   WriteTypeAbbrevs();
   WriteDeclAbbrevs();
+  DeferringRecords = ParallelRecordEncoding;
   do {
     WriteDeclUpdatesBlocks(DeclUpdatesOffsetsRecord);
     while (!DeclTypesToEmit.empty()) {
@@ -4774,6 +5057,23 @@ ASTFileSignature ASTWriter::WriteASTCore(Sema &SemaRef, StringRef isysroot,
         WriteDecl(Context, DOT.getDecl());
     }
   } while (!DeclUpdates.empty());
+  if (DeferringRecords) {
+    WriteDeferredRecords();
+    DeferringRecords = false;
+
+    // Replace the offsets handed out for deferred records with the bit
+    // positions the records were written at.
+    for (DeclOffset &DO : DeclOffsets)
+      if (DO.BitOffset)
+        DO.BitOffset = resolveRecordOffset(DO.BitOffset);
+    for (uint32_t &Offset : TypeOffsets)
+      if (Offset)
+        Offset = resolveRecordOffset(Offset);
+    for (unsigned I = 1, N = DeclUpdatesOffsetsRecord.size(); I < N; I += 2)
+      DeclUpdatesOffsetsRecord[I] =
+          resolveRecordOffset(DeclUpdatesOffsetsRecord[I]);
+    DeferredRecordOffsets.clear();
+  }
   Stream.ExitBlock();
 
   DoneWritingDeclsAndTypes = true;
@@ -2674,14 +2674,15 @@ void ASTWriter::WriteSubStmt(Stmt *S) {
   ++NumStatements;
   
   if (!S) {
-    Stream.EmitRecord(serialization::STMT_NULL_PTR, Record);
+    EmitRecord(serialization::STMT_NULL_PTR, Record);
     return;
   }
 
   llvm::DenseMap<Stmt *, uint64_t>::iterator I = SubStmtEntries.find(S);
   if (I != SubStmtEntries.end()) {
     Record.push_back(I->second);
-    Stream.EmitRecord(serialization::STMT_REF_PTR, Record);
+    EmitRecord(serialization::STMT_REF_PTR, Record, /*Abbrev=*/0,
+               /*RelativeOffsets=*/None, /*AbsoluteOffsets=*/{0u});
     return;
   }
 
@@ -2726,7 +2727,8 @@ void ASTRecordWriter::FlushStmts() {
     // Note that we are at the end of a full expression. Any
     // expression records that follow this one are part of a different
     // expression.
-    Writer->Stream.EmitRecord(serialization::STMT_STOP, ArrayRef<uint32_t>());
+    ASTWriter::RecordData Stop;
+    Writer->EmitRecord(serialization::STMT_STOP, Stop);
 
     Writer->SubStmtEntries.clear();
     Writer->ParentStmts.clear();
@@ -14,22 +14,28 @@
 #include "ASTReaderInternals.h"
 #include "clang/Frontend/PCHContainerOperations.h"
 #include "clang/Basic/FileManager.h"
+#include "clang/Basic/VirtualFileSystem.h"
 #include "clang/Lex/HeaderSearch.h"
 #include "clang/Serialization/ASTBitCodes.h"
 #include "clang/Serialization/GlobalModuleIndex.h"
 #include "clang/Serialization/Module.h"
+#include "llvm/ADT/BitVector.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/Bitcode/BitstreamReader.h"
 #include "llvm/Bitcode/BitstreamWriter.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/LockFileManager.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/OnDiskHashTable.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/ThreadPool.h"
+#include <algorithm>
 #include <cstdio>
+#include <thread>
 using namespace clang;
 using namespace serialization;
 
@@ -58,7 +64,7 @@ namespace {
 static const char * const IndexFileName = "modules.idx";
 
 /// \brief The global index file version.
-static const unsigned CurrentVersion = 1;
+static const unsigned CurrentVersion = 2;
 
 //----------------------------------------------------------------------------//
 // Global module index reader.
@@ -121,6 +127,22 @@ public:
 typedef llvm::OnDiskIterableChainedHashTable<IdentifierIndexReaderTrait>
     IdentifierIndexTable;
 
+/// \brief Trait used to read back each identifier in the identifier index
+/// along with its module IDs, when updating the index.
+class IdentifierIndexEntryTrait : public IdentifierIndexReaderTrait {
+public:
+  typedef std::pair<StringRef, SmallVector<unsigned, 2>> data_type;
+
+  static data_type ReadData(const internal_key_type& k,
+                            const unsigned char* d,
+                            unsigned DataLen) {
+    return data_type(k, IdentifierIndexReaderTrait::ReadData(k, d, DataLen));
+  }
+};
+
+typedef llvm::OnDiskIterableChainedHashTable<IdentifierIndexEntryTrait>
+    IdentifierIndexEntryTable;
+
 }
 
 GlobalModuleIndex::GlobalModuleIndex(std::unique_ptr<llvm::MemoryBuffer> Buffer,
@@ -202,6 +224,10 @@ GlobalModuleIndex::GlobalModuleIndex(std::unique_ptr<llvm::MemoryBuffer> Buffer,
                                       Record.begin() + Idx + NumDeps);
       Idx += NumDeps;
 
+      // Signature.
+      for (unsigned I = 0; I != 5; ++I)
+        Modules[ID].Signature[I] = Record[Idx++];
+
       // Make sure we're at the end of the record.
       assert(Idx == Record.size() && "More module info?");
 
@@ -239,8 +265,10 @@ GlobalModuleIndex::readIndex(StringRef Path) {
   IndexPath += Path;
   llvm::sys::path::append(IndexPath, IndexFileName);
 
+  // The identifier index is read in place, so there's no need to copy it.
   llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> BufferOrErr =
-      llvm::MemoryBuffer::getFile(IndexPath.c_str());
+      llvm::MemoryBuffer::getFile(IndexPath.c_str(), /*FileSize=*/-1,
+                                  /*RequiresNullTerminator=*/false);
   if (!BufferOrErr)
     return std::make_pair(nullptr, EC_NotFound);
   std::unique_ptr<llvm::MemoryBuffer> Buffer = std::move(BufferOrErr.get());
@@ -387,6 +415,36 @@ namespace {
         : StoredSize(Size), StoredModTime(ModTime), StoredSignature(Sig) {}
   };
 
+  /// \brief The parts of a module file that the global index cares about.
+  ///
+  /// These are read without touching the builder or the file manager, so
+  /// that several module files can be read at once.
+  struct ModuleFileContents {
+    /// \brief A module file imported by this one.
+    struct Import {
+      off_t StoredSize;
+      time_t StoredModTime;
+      ASTFileSignature StoredSignature;
+      std::string FileName;
+    };
+
+    /// \brief The module file's contents, which \c Identifiers refer into.
+    std::unique_ptr<llvm::MemoryBuffer> Buffer;
+
+    /// \brief Whether the module file could not be read.
+    bool Failed;
+
+    SmallVector<Import, 4> Imports;
+
+    /// \brief The identifiers in the module file, and whether each one is
+    /// interesting.
+    std::vector<std::pair<StringRef, bool>> Identifiers;
+
+    ASTFileSignature Signature;
+
+    ModuleFileContents() : Failed(true) {}
+  };
+
   /// \brief Builder that generates the global module index file.
   class GlobalModuleIndexBuilder {
     FileManager &FileMgr;
@@ -435,10 +493,32 @@ namespace {
         FileManager &FileMgr, const PCHContainerReader &PCHContainerRdr)
         : FileMgr(FileMgr), PCHContainerRdr(PCHContainerRdr) {}
 
-    /// \brief Load the contents of the given module file into the builder.
+    /// \brief Read the parts of the given module file that the index needs.
+    static void readModuleFile(vfs::FileSystem &FS,
+                               const PCHContainerReader &PCHContainerRdr,
+                               StringRef FileName, ModuleFileContents &Result);
+
+    /// \brief Add the contents of the given module file to the builder.
     ///
     /// \returns true if an error occurred, false otherwise.
-    bool loadModuleFile(const FileEntry *File);
+    bool addModuleFile(const FileEntry *File, ModuleFileContents &Contents);
+
+    /// \brief Add a module file that is unchanged since the existing index
+    /// was written, along with the module files it depends on.
+    ///
+    /// Its identifiers are added with \c addIndexedIdentifier().
+    ///
+    /// \returns the ID of the module file.
+    unsigned addIndexedModuleFile(const FileEntry *File,
+                                  ASTFileSignature Signature,
+                                  ArrayRef<const FileEntry *> Dependencies);
+
+    /// \brief Add an identifier from the existing index, given the IDs of the
+    /// unchanged module files that consider it interesting.
+    void addIndexedIdentifier(StringRef Name, ArrayRef<unsigned> ModuleIDs) {
+      auto &IDs = InterestingIdentifiers[Name];
+      IDs.append(ModuleIDs.begin(), ModuleIDs.end());
+    }
 
     /// \brief Write the index to the given bitstream.
     /// \returns true if an error occurred, false otherwise.
@@ -509,29 +589,28 @@ namespace {
   };
 }
 
-bool GlobalModuleIndexBuilder::loadModuleFile(const FileEntry *File) {
+void GlobalModuleIndexBuilder::readModuleFile(
+    vfs::FileSystem &FS, const PCHContainerReader &PCHContainerRdr,
+    StringRef FileName, ModuleFileContents &Result) {
   // Open the module file.
-
-  auto Buffer = FileMgr.getBufferForFile(File, /*isVolatile=*/true);
-  if (!Buffer) {
-    return true;
-  }
+  auto Buffer = FS.getBufferForFile(FileName, /*FileSize=*/-1,
+                                    /*RequiresNullTerminator=*/false,
+                                    /*IsVolatile=*/true);
+  if (!Buffer)
+    return;
+  Result.Buffer = std::move(*Buffer);
 
   // Initialize the input stream
-  llvm::BitstreamCursor InStream(PCHContainerRdr.ExtractPCH(**Buffer));
+  llvm::BitstreamCursor InStream(PCHContainerRdr.ExtractPCH(*Result.Buffer));
 
   // Sniff for the signature.
   if (InStream.Read(8) != 'C' ||
       InStream.Read(8) != 'P' ||
       InStream.Read(8) != 'C' ||
       InStream.Read(8) != 'H') {
-    return true;
+    return;
   }
 
-  // Record this module file and assign it a unique ID (if it doesn't have
-  // one already).
-  unsigned ID = getModuleFileInfo(File).ID;
-
   // Search for the blocks and records we care about.
   enum { Other, ControlBlock, ASTBlock, DiagnosticOptionsBlock } State = Other;
   bool Done = false;
@@ -555,7 +634,7 @@ bool GlobalModuleIndexBuilder::loadModuleFile(const FileEntry *File) {
     case llvm::BitstreamEntry::SubBlock:
       if (Entry.ID == CONTROL_BLOCK_ID) {
         if (InStream.EnterSubBlock(CONTROL_BLOCK_ID))
-          return true;
+          return;
 
         // Found the control block.
         State = ControlBlock;
@@ -564,7 +643,7 @@ bool GlobalModuleIndexBuilder::loadModuleFile(const FileEntry *File) {
 
       if (Entry.ID == AST_BLOCK_ID) {
         if (InStream.EnterSubBlock(AST_BLOCK_ID))
-          return true;
+          return;
 
         // Found the AST block.
         State = ASTBlock;
@@ -573,7 +652,7 @@ bool GlobalModuleIndexBuilder::loadModuleFile(const FileEntry *File) {
 
       if (Entry.ID == UNHASHED_CONTROL_BLOCK_ID) {
         if (InStream.EnterSubBlock(UNHASHED_CONTROL_BLOCK_ID))
-          return true;
+          return;
 
         // Found the Diagnostic Options block.
         State = DiagnosticOptionsBlock;
@@ -581,7 +660,7 @@ bool GlobalModuleIndexBuilder::loadModuleFile(const FileEntry *File) {
       }
 
       if (InStream.SkipBlock())
-        return true;
+        return;
 
       continue;
 
@@ -601,6 +680,7 @@ bool GlobalModuleIndexBuilder::loadModuleFile(const FileEntry *File) {
       unsigned Idx = 0, N = Record.size();
       while (Idx < N) {
         // Read information about the AST file.
+        ModuleFileContents::Import Import;
 
         // Skip the imported kind
         ++Idx;
@@ -609,39 +689,23 @@ bool GlobalModuleIndexBuilder::loadModuleFile(const FileEntry *File) {
         ++Idx;
 
         // Load stored size/modification time. 
-        off_t StoredSize = (off_t)Record[Idx++];
-        time_t StoredModTime = (time_t)Record[Idx++];
+        Import.StoredSize = (off_t)Record[Idx++];
+        Import.StoredModTime = (time_t)Record[Idx++];
 
-        // Skip the stored signature.
-        // FIXME: we could read the signature out of the import and validate it.
-        ASTFileSignature StoredSignature = {
+        // Load the stored signature, which is validated once all module files
+        // have been loaded.
+        Import.StoredSignature = {
             {{(uint32_t)Record[Idx++], (uint32_t)Record[Idx++],
               (uint32_t)Record[Idx++], (uint32_t)Record[Idx++],
               (uint32_t)Record[Idx++]}}};
 
         // Retrieve the imported file name.
         unsigned Length = Record[Idx++];
-        SmallString<128> ImportedFile(Record.begin() + Idx,
-                                      Record.begin() + Idx + Length);
+        Import.FileName.assign(Record.begin() + Idx,
+                               Record.begin() + Idx + Length);
         Idx += Length;
 
-        // Find the imported module file.
-        const FileEntry *DependsOnFile
-          = FileMgr.getFile(ImportedFile, /*openFile=*/false,
-                            /*cacheFailure=*/false);
-
-        if (!DependsOnFile)
-          return true;
-
-        // Save the information in ImportedModuleFileInfo so we can verify after
-        // loading all pcms.
-        ImportedModuleFiles.insert(std::make_pair(
-            DependsOnFile, ImportedModuleFileInfo(StoredSize, StoredModTime,
-                                                  StoredSignature)));
-
-        // Record the dependency.
-        unsigned DependsOnID = getModuleFileInfo(DependsOnFile).ID;
-        getModuleFileInfo(File).Dependencies.push_back(DependsOnID);
+        Result.Imports.push_back(std::move(Import));
       }
 
       continue;
@@ -658,27 +722,75 @@ bool GlobalModuleIndexBuilder::loadModuleFile(const FileEntry *File) {
               (const unsigned char *)Blob.data()));
       for (InterestingIdentifierTable::data_iterator D = Table->data_begin(),
                                                      DEnd = Table->data_end();
-           D != DEnd; ++D) {
-        std::pair<StringRef, bool> Ident = *D;
-        if (Ident.second)
-          InterestingIdentifiers[Ident.first].push_back(ID);
-        else
-          (void)InterestingIdentifiers[Ident.first];
-      }
+           D != DEnd; ++D)
+        Result.Identifiers.push_back(*D);
     }
 
     // Get Signature.
     if (State == DiagnosticOptionsBlock && Code == SIGNATURE)
-      getModuleFileInfo(File).Signature = {
+      Result.Signature = {
           {{(uint32_t)Record[0], (uint32_t)Record[1], (uint32_t)Record[2],
             (uint32_t)Record[3], (uint32_t)Record[4]}}};
 
     // We don't care about this record.
   }
 
+  Result.Failed = false;
+}
+
+bool GlobalModuleIndexBuilder::addModuleFile(const FileEntry *File,
+                                             ModuleFileContents &Contents) {
+  if (Contents.Failed)
+    return true;
+
+  // Record this module file and assign it a unique ID (if it doesn't have
+  // one already).
+  unsigned ID = getModuleFileInfo(File).ID;
+
+  for (const ModuleFileContents::Import &Import : Contents.Imports) {
+    // Find the imported module file.
+    const FileEntry *DependsOnFile
+      = FileMgr.getFile(Import.FileName, /*openFile=*/false,
+                        /*cacheFailure=*/false);
+
+    if (!DependsOnFile)
+      return true;
+
+    // Save the information in ImportedModuleFileInfo so we can verify after
+    // loading all pcms.
+    ImportedModuleFiles.insert(std::make_pair(
+        DependsOnFile,
+        ImportedModuleFileInfo(Import.StoredSize, Import.StoredModTime,
+                               Import.StoredSignature)));
+
+    // Record the dependency.
+    unsigned DependsOnID = getModuleFileInfo(DependsOnFile).ID;
+    getModuleFileInfo(File).Dependencies.push_back(DependsOnID);
+  }
+
+  for (const std::pair<StringRef, bool> &Ident : Contents.Identifiers) {
+    if (Ident.second)
+      InterestingIdentifiers[Ident.first].push_back(ID);
+    else
+      (void)InterestingIdentifiers[Ident.first];
+  }
+
+  getModuleFileInfo(File).Signature = Contents.Signature;
   return false;
 }
 
+unsigned GlobalModuleIndexBuilder::addIndexedModuleFile(
+    const FileEntry *File, ASTFileSignature Signature,
+    ArrayRef<const FileEntry *> Dependencies) {
+  unsigned ID = getModuleFileInfo(File).ID;
+  for (const FileEntry *DependsOnFile : Dependencies) {
+    unsigned DependsOnID = getModuleFileInfo(DependsOnFile).ID;
+    getModuleFileInfo(File).Dependencies.push_back(DependsOnID);
+  }
+  getModuleFileInfo(File).Signature = Signature;
+  return ID;
+}
+
 namespace {
 
 /// \brief Trait used to generate the identifier index as an on-disk hash
@@ -771,6 +883,9 @@ bool GlobalModuleIndexBuilder::writeIndex(llvm::BitstreamWriter &Stream) {
     // Dependencies
     Record.push_back(M->second.Dependencies.size());
     Record.append(M->second.Dependencies.begin(), M->second.Dependencies.end());
+
+    // Signature
+    Record.append(M->second.Signature.begin(), M->second.Signature.end());
     Stream.EmitRecord(MODULE, Record);
   }
 
@@ -779,10 +894,15 @@ bool GlobalModuleIndexBuilder::writeIndex(llvm::BitstreamWriter &Stream) {
     llvm::OnDiskChainedHashTableGenerator<IdentifierIndexWriterTrait> Generator;
     IdentifierIndexWriterTrait Trait;
 
-    // Populate the hash table.
+    // Populate the hash table. An identifier that no module file considers
+    // interesting finds nothing either way, so leave it out; otherwise an
+    // identifier that an updated module file no longer declares would stay
+    // in the index forever.
     for (InterestingIdentifierMap::iterator I = InterestingIdentifiers.begin(),
                                             IEnd = InterestingIdentifiers.end();
          I != IEnd; ++I) {
+      if (I->second.empty())
+        continue;
       Generator.insert(I->first(), I->second, Trait);
     }
     
@@ -841,7 +961,8 @@ GlobalModuleIndex::writeIndex(FileManager &FileMgr,
   // The module index builder.
   GlobalModuleIndexBuilder Builder(FileMgr, PCHContainerRdr);
 
-  // Load each of the module files.
+  // Find each of the module files.
+  SmallVector<const FileEntry *, 16> ModuleFiles;
   std::error_code EC;
   for (llvm::sys::fs::directory_iterator D(Path, EC), DEnd;
        D != DEnd && !EC;
@@ -858,13 +979,132 @@ GlobalModuleIndex::writeIndex(FileManager &FileMgr,
     }
 
     // If we can't find the module file, skip it.
-    const FileEntry *ModuleFile = FileMgr.getFile(D->path());
-    if (!ModuleFile)
-      continue;
+    if (const FileEntry *ModuleFile = FileMgr.getFile(D->path()))
+      ModuleFiles.push_back(ModuleFile);
+  }
 
-    // Load this module file.
-    if (Builder.loadModuleFile(ModuleFile))
-      return EC_IOError;
+  // Carry over what the existing index knows about module files that haven't
+  // changed since it was written, so that only new and updated module files
+  // need to be read.
+  std::unique_ptr<GlobalModuleIndex> OldIndex(readIndex(Path).first);
+  llvm::SmallPtrSet<const FileEntry *, 16> IndexedModuleFiles;
+  if (OldIndex && OldIndex->IdentifierIndex) {
+    ArrayRef<ModuleInfo> OldModules = OldIndex->Modules;
+    llvm::SmallPtrSet<const FileEntry *, 16> Present(ModuleFiles.begin(),
+                                                     ModuleFiles.end());
+
+    // Find the module files whose size and modification time still match.
+    SmallVector<const FileEntry *, 16> OldFiles(OldModules.size());
+    llvm::BitVector Unchanged(OldModules.size());
+    for (unsigned ID = 0, N = OldModules.size(); ID != N; ++ID) {
+      const ModuleInfo &Info = OldModules[ID];
+      if (Info.FileName.empty())
+        continue;
+      const FileEntry *File = FileMgr.getFile(Info.FileName,
+                                              /*openFile=*/false,
+                                              /*cacheFailure=*/false);
+      if (File && Present.count(File) && File->getSize() == Info.Size &&
+          File->getModificationTime() == Info.ModTime) {
+        OldFiles[ID] = File;
+        Unchanged.set(ID);
+      }
+    }
+
+    // A module file whose dependencies changed has to be read again, so that
+    // its imports are validated.
+    bool Propagated;
+    do {
+      Propagated = false;
+      for (int ID = Unchanged.find_first(); ID != -1;
+           ID = Unchanged.find_next(ID)) {
+        for (unsigned Dep : OldModules[ID].Dependencies) {
+          if (Dep >= OldModules.size() || !Unchanged.test(Dep)) {
+            Unchanged.reset(ID);
+            Propagated = true;
+            break;
+          }
+        }
+      }
+    } while (Propagated);
+
+    // Add the unchanged module files to the new index.
+    SmallVector<int, 16> NewIDs(OldModules.size(), -1);
+    for (int ID = Unchanged.find_first(); ID != -1;
+         ID = Unchanged.find_next(ID)) {
+      SmallVector<const FileEntry *, 4> Dependencies;
+      for (unsigned Dep : OldModules[ID].Dependencies)
+        Dependencies.push_back(OldFiles[Dep]);
+      NewIDs[ID] = Builder.addIndexedModuleFile(
+          OldFiles[ID], OldModules[ID].Signature, Dependencies);
+      IndexedModuleFiles.insert(OldFiles[ID]);
+    }
+
+    // ... along with their identifiers.
+    IdentifierIndexTable &OldTable =
+        *static_cast<IdentifierIndexTable *>(OldIndex->IdentifierIndex);
+    std::unique_ptr<IdentifierIndexEntryTable> Entries(
+        IdentifierIndexEntryTable::Create(
+            OldTable.getBuckets(), OldTable.getBase() + sizeof(uint32_t),
+            OldTable.getBase()));
+    SmallVector<unsigned, 2> ModuleIDs;
+    for (IdentifierIndexEntryTable::data_iterator D = Entries->data_begin(),
+                                                  DEnd = Entries->data_end();
+         D != DEnd; ++D) {
+      IdentifierIndexEntryTrait::data_type Entry = *D;
+      ModuleIDs.clear();
+      for (unsigned ID : Entry.second)
+        if (ID < NewIDs.size() && NewIDs[ID] >= 0)
+          ModuleIDs.push_back(NewIDs[ID]);
+      Builder.addIndexedIdentifier(Entry.first, ModuleIDs);
+    }
+  }
+  OldIndex.reset();
+
+  SmallVector<const FileEntry *, 16> ModuleFilesToLoad;
+  for (const FileEntry *ModuleFile : ModuleFiles)
+    if (!IndexedModuleFiles.count(ModuleFile))
+      ModuleFilesToLoad.push_back(ModuleFile);
+
+  // Load the remaining module files. Reading them is independent, so we read
+  // a batch at a time in parallel, then add them to the index in order. We
+  // don't read them all at once, since module files are read into memory.
+  IntrusiveRefCntPtr<vfs::FileSystem> FS = FileMgr.getVirtualFileSystem();
+  unsigned BatchSize = 1;
+#if LLVM_ENABLE_THREADS
+  std::unique_ptr<llvm::ThreadPool> Pool;
+  if (ModuleFilesToLoad.size() > 1) {
+    Pool.reset(new llvm::ThreadPool());
+    BatchSize = 2 * std::max(1u, std::thread::hardware_concurrency());
+  }
+#endif
+  for (unsigned Begin = 0, N = ModuleFilesToLoad.size(); Begin < N;
+       Begin += BatchSize) {
+    unsigned End = std::min(N, Begin + BatchSize);
+    std::vector<ModuleFileContents> Contents(End - Begin);
+    for (unsigned I = Begin; I != End; ++I) {
+      StringRef FileName = ModuleFilesToLoad[I]->getName();
+      ModuleFileContents *Result = &Contents[I - Begin];
+#if LLVM_ENABLE_THREADS
+      if (Pool) {
+        Pool->async([&FS, &PCHContainerRdr, FileName, Result] {
+          GlobalModuleIndexBuilder::readModuleFile(*FS, PCHContainerRdr,
+                                                   FileName, *Result);
+        });
+        continue;
+      }
+#endif
+      GlobalModuleIndexBuilder::readModuleFile(*FS, PCHContainerRdr, FileName,
+                                               *Result);
+    }
+#if LLVM_ENABLE_THREADS
+    if (Pool)
+      Pool->wait();
+#endif
+
+    // Load these module files.
+    for (unsigned I = Begin; I != End; ++I)
+      if (Builder.addModuleFile(ModuleFilesToLoad[I], Contents[I - Begin]))
+        return EC_IOError;
   }
 
   // The output buffer, into which the global index will be written.
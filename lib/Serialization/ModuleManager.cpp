@@ -151,9 +151,14 @@ ModuleManager::addModule(StringRef FileName, ModuleKind Type,
       // ModuleManager it must be the same underlying file.
       // FIXME: Because FileManager::getFile() doesn't guarantee that it will
       // give us an open file, this may not be 100% reliable.
+      //
+      // The bitstream reader never looks for a null terminator, so don't ask
+      // for one; that keeps the file mapped (rather than copied into the
+      // heap) whatever its size, and blobs are read straight from the mapping.
       Buf = FileMgr.getBufferForFile(NewModule->File,
                                      /*IsVolatile=*/false,
-                                     /*ShouldClose=*/false);
+                                     /*ShouldClose=*/false,
+                                     /*RequiresNullTerminator=*/false);
     }
 
     if (!Buf) {
@@ -13,6 +13,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang/Tooling/Tooling.h"
+#include "clang/Basic/VirtualFileSystem.h"
 #include "clang/Driver/Compilation.h"
 #include "clang/Driver/Driver.h"
 #include "clang/Driver/Options.h"
@@ -33,7 +34,10 @@
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Host.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
+#include <atomic>
+#include <mutex>
 #include <utility>
 
 #define DEBUG_TYPE "clang-tooling"
@@ -466,6 +470,91 @@ int ClangTool::run(ToolAction *Action) {
   return ProcessingFailed ? 1 : 0;
 }
 
+int ClangTool::run(ToolAction *Action, unsigned ThreadCount) {
+  if (ThreadCount <= 1)
+    return run(Action);
+
+  // Exists solely for the purpose of lookup of the resource path.
+  // This just needs to be some symbol in the binary.
+  static int StaticSymbol;
+
+  struct Job {
+    std::string File;
+    std::string Directory;
+    std::vector<std::string> CommandLine;
+  };
+
+  // Compilation databases may change the state of the file system when asked
+  // for commands (see run(Action)), so ask for all of them up front, on this
+  // thread, before anything is parsed.
+  std::vector<Job> Jobs;
+  for (const auto &SourcePath : SourcePaths) {
+    std::string File(getAbsolutePath(SourcePath));
+
+    std::vector<CompileCommand> CompileCommandsForFile =
+        Compilations.getCompileCommands(File);
+    if (CompileCommandsForFile.empty()) {
+      llvm::errs() << "Skipping " << File << ". Compile command not found.\n";
+      continue;
+    }
+    for (CompileCommand &CompileCommand : CompileCommandsForFile) {
+      std::vector<std::string> CommandLine = CompileCommand.CommandLine;
+      if (ArgsAdjuster)
+        CommandLine = ArgsAdjuster(CommandLine, CompileCommand.Filename);
+      assert(!CommandLine.empty());
+      injectResourceDir(CommandLine, "clang_tool", &StaticSymbol);
+      Jobs.push_back({File, CompileCommand.Directory, std::move(CommandLine)});
+    }
+  }
+
+  IntrusiveRefCntPtr<vfs::SharedFileSystemCache> Cache(
+      new vfs::SharedFileSystemCache(vfs::getRealFileSystem()));
+  std::atomic<bool> ProcessingFailed(false);
+  std::mutex OutputMutex;
+
+  llvm::ThreadPool Pool(ThreadCount);
+  for (const Job &J : Jobs) {
+    Pool.async([&, &J] {
+      // Each job resolves relative paths against its own working directory
+      // rather than changing the process's, and gets its own copy of the
+      // mapped files, which may be relative to that directory.
+      llvm::IntrusiveRefCntPtr<vfs::OverlayFileSystem> JobFileSystem(
+          new vfs::OverlayFileSystem(
+              vfs::createCachingFileSystem(Cache, J.Directory)));
+      llvm::IntrusiveRefCntPtr<vfs::InMemoryFileSystem> JobInMemoryFileSystem(
+          new vfs::InMemoryFileSystem);
+      JobFileSystem->pushOverlay(JobInMemoryFileSystem);
+      if (JobFileSystem->setCurrentWorkingDirectory(J.Directory))
+        llvm::report_fatal_error("Cannot chdir into \"" + Twine(J.Directory) +
+                                 "\n!");
+      for (const auto &MappedFile : MappedFileContents)
+        JobInMemoryFileSystem->addFile(
+            MappedFile.first, 0,
+            llvm::MemoryBuffer::getMemBuffer(MappedFile.second));
+
+      llvm::IntrusiveRefCntPtr<FileManager> JobFiles(
+          new FileManager(FileSystemOptions(), JobFileSystem));
+
+      DEBUG({
+        std::lock_guard<std::mutex> Lock(OutputMutex);
+        llvm::dbgs() << "Processing: " << J.File << ".\n";
+      });
+      ToolInvocation Invocation(J.CommandLine, Action, JobFiles.get(),
+                                PCHContainerOps);
+      Invocation.setDiagnosticConsumer(DiagConsumer);
+
+      if (!Invocation.run()) {
+        std::lock_guard<std::mutex> Lock(OutputMutex);
+        llvm::errs() << "Error while processing " << J.File << ".\n";
+        ProcessingFailed = true;
+      }
+    });
+  }
+  Pool.wait();
+
+  return ProcessingFailed ? 1 : 0;
+}
+
 namespace {
 
 class ASTBuilderAction : public ToolAction {
@@ -0,0 +1,2 @@
+extern TYPE shared_var;
+struct Shared { int x; };
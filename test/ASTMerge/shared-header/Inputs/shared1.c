@@ -0,0 +1,3 @@
+#define TYPE int
+#include "shared.h"
+struct Shared s1;
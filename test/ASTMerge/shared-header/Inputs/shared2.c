@@ -0,0 +1,3 @@
+#define TYPE double
+#include "shared.h"
+struct Shared s2;
@@ -0,0 +1,9 @@
+// RUN: %clang_cc1 -emit-pch -o %t.1.ast %S/Inputs/shared1.c
+// RUN: %clang_cc1 -emit-pch -o %t.2.ast %S/Inputs/shared2.c
+// RUN: not %clang_cc1 -ast-merge %t.1.ast -ast-merge %t.2.ast -fsyntax-only %s 2>&1 | FileCheck %s
+
+// Locations in a header included by both AST files are still correct when the
+// header is only imported once.
+// CHECK: shared.h:1:13: error: external variable 'shared_var' declared with incompatible types in different translation units ('double' vs. 'int')
+// CHECK: shared.h:1:13: note: declared here with type 'int'
+// CHECK: 1 error
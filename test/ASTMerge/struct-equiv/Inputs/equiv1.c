@@ -0,0 +1,14 @@
+struct Payload { int value; struct Node *owner; };
+struct Node { struct Node *next; struct Payload *payload; };
+
+extern struct Node *head;
+extern struct Node *tail;
+extern struct Payload payloads[4];
+
+struct Good { struct Node *node; struct Payload payload; };
+extern struct Good good;
+
+struct Bad { struct Node *node; int count; };
+extern struct Bad bad;
+
+extern struct Node *last;
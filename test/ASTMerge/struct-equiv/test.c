@@ -0,0 +1,17 @@
+// RUN: %clang_cc1 -emit-pch -o %t.1.ast %S/Inputs/equiv1.c
+// RUN: %clang_cc1 -emit-pch -o %t.2.ast %S/Inputs/equiv2.c
+// RUN: not %clang_cc1 -ast-merge %t.1.ast -ast-merge %t.2.ast -fsyntax-only %s 2>&1 | FileCheck %s
+
+// Equivalences between the recursive structs are remembered once proven, but
+// a mismatch in a struct that refers to them is still diagnosed, and doesn't
+// affect the declarations checked after it.
+// CHECK-NOT: 'struct Payload'
+// CHECK-NOT: 'struct Node'
+// CHECK-NOT: 'struct Good'
+// CHECK: equiv1.c:11:8: warning: type 'struct Bad' has incompatible definitions in different translation units
+// CHECK: equiv1.c:11:37: note: field 'count' has type 'int' here
+// CHECK: equiv2.c:11:39: note: field 'count' has type 'float' here
+// CHECK: equiv2.c:12:19: error: external variable 'bad' declared with incompatible types in different translation units ('struct Bad' vs. 'struct Bad')
+// CHECK: equiv1.c:12:19: note: declared here with type 'struct Bad'
+// CHECK-NOT: 'struct Node'
+// CHECK: 1 error
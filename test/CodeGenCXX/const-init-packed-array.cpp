@@ -0,0 +1,82 @@
+// RUN: %clang_cc1 -verify -triple x86_64-linux-gnu -emit-llvm -o - %s -std=c++1y | FileCheck %s
+// expected-no-diagnostics
+
+// The constant evaluator holds arrays of integers or floating-point numbers
+// packed. Check that their elements can be read, modified and emitted.
+
+template<typename T, unsigned N> struct Array {
+  T elems[N];
+  constexpr T &operator[](unsigned i) { return elems[i]; }
+  constexpr const T &operator[](unsigned i) const { return elems[i]; }
+};
+
+constexpr Array<int, 1 << 16> makeTable() {
+  Array<int, 1 << 16> a = {};
+  for (unsigned i = 0; i != 1 << 16; i += 2)
+    a[i] = i / 2;
+  return a;
+}
+constexpr auto table = makeTable();
+static_assert(table[0] == 0 && table[1] == 0 && table[2] == 1, "");
+static_assert(table[65534] == 32767 && table[65535] == 0, "");
+
+constexpr int copyAndModify() {
+  Array<int, 1 << 16> a = table;
+  a[3] = 42;
+  ++a[4];
+  a[5] += 2;
+  return a[3] + a[4] + a[5] + table[3] + table[4];
+}
+static_assert(copyAndModify() == 49, "");
+
+constexpr int modifyString() {
+  char s[] = "abc";
+  s[1] = 'B';
+  return s[1] - s[0];
+}
+static_assert(modifyString() == 'B' - 'a', "");
+
+constexpr Array<int, 6> makeSmall() {
+  Array<int, 6> a = {};
+  a[1] = 1;
+  a[4] = -4;
+  return a;
+}
+Array<int, 6> small = makeSmall();
+// CHECK: @small = global {{.*}} { [6 x i32] [i32 0, i32 1, i32 0, i32 0, i32 -4, i32 0] }
+
+constexpr Array<double, 3> makeDoubles() {
+  Array<double, 3> a = {{1.0, 2.0}};
+  a[0] = 0.5;
+  a[1] = -0.0;
+  return a;
+}
+Array<double, 3> doubles = makeDoubles();
+// CHECK: @doubles = global {{.*}} { [3 x double] [double 5.000000e-01, double -0.000000e+00, double 0.000000e+00] }
+
+constexpr Array<float, 1 << 12> makeFloats() {
+  Array<float, 1 << 12> a = {};
+  for (unsigned i = 0; i != 1 << 12; i += 2)
+    a[i] = i * 0.5f;
+  return a;
+}
+constexpr auto floats = makeFloats();
+static_assert(floats[0] == 0.0f && floats[2] == 1.0f && floats[3] == 0.0f, "");
+static_assert(floats[4094] == 2047.0f && floats[4095] == 0.0f, "");
+
+constexpr float copyAndModifyFloats() {
+  Array<float, 1 << 12> a = floats;
+  a[1] = -1.5f;
+  a[2] *= 4;
+  return a[1] + a[2] + floats[2];
+}
+static_assert(copyAndModifyFloats() == 3.5f, "");
+
+constexpr Array<float, 4> makeSmallFloats() {
+  Array<float, 4> a = {};
+  a[1] = 0.25f;
+  a[3] = -2.0f;
+  return a;
+}
+Array<float, 4> smallFloats = makeSmallFloats();
+// CHECK: @smallFloats = global {{.*}} { [4 x float] [float 0.000000e+00, float 2.500000e-01, float 0.000000e+00, float -2.000000e+00] }
@@ -0,0 +1,31 @@
+// RUN: %clang_cc1 -fsyntax-only -fast-memory-report %s 2>&1 | FileCheck %s
+// RUN: %clang_cc1 -fsyntax-only -fast-memory-report %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=EARLY %s
+// RUN: %clang -### -fsyntax-only -fast-memory-report %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=DRIVER %s
+
+// DRIVER: "-cc1"
+// DRIVER-SAME: "-fast-memory-report"
+
+// CHECK: {
+// CHECK-NEXT: "allocator": {"allocated": {{[0-9]+}}, "total": {{[0-9]+}}, "sideTables": {{[0-9]+}}},
+// CHECK-NEXT: "decls": {"kinds": {{.*}}"CXXRecord": {"count": {{[1-9][0-9]*}}, "bytes": {{[0-9]+}}}{{.*}}}, "count": {{[0-9]+}}, "bytes": {{[0-9]+}}},
+// CHECK-NEXT: "stmts": {"kinds": {{.*}}"ReturnStmt": {"count": 2, "bytes": {{[0-9]+}}}{{.*}}}, "count": {{[0-9]+}}, "bytes": {{[0-9]+}}},
+// CHECK-NEXT: "types": {"kinds": {{.*}}"Pointer": {"count": {{[1-9][0-9]*}}, "bytes": {{[0-9]+}}}{{.*}}}, "count": {{[0-9]+}}, "bytes": {{[0-9]+}}},
+// CHECK-NEXT: "typeSourceInfo": {"count": {{[0-9]+}}, "bytes": {{[0-9]+}}, "sharedUses": {{[0-9]+}}},
+// CHECK-NEXT: "lookupTables": {"count": {{[1-9][0-9]*}}, "entries": {{[0-9]+}}, "bytes": {{[0-9]+}}},
+// CHECK-NEXT: "comments": {"count": {{[0-9]+}}, "bytes": {{[0-9]+}}},
+// CHECK-NEXT: "sourceManager": {"contentCaches": {{[0-9]+}}, "dataStructures": {{[0-9]+}}, "mallocBuffers": {{[0-9]+}}, "mmapBuffers": {{[0-9]+}}}
+// CHECK-NEXT: }
+
+// Declarations created before parsing begins are counted too.
+// EARLY: "decls": {"kinds": {{.*}}"TranslationUnit": {"count": 1,
+
+struct S {
+  int *p;
+  int get() const { return *p; }
+};
+
+namespace N {
+  int f(S s) { return s.get(); }
+}
@@ -0,0 +1,25 @@
+// RUN: rm -f %t.json %t.json.report
+// RUN: %clang_cc1 -std=c++11 -fsyntax-only -ftemplate-profile=%t.json %s
+// RUN: FileCheck -check-prefix=TRACE %s < %t.json
+// RUN: FileCheck -check-prefix=REPORT %s < %t.json.report
+
+template <typename T> struct Box { T value; };
+
+template <typename T> T get(Box<T> B) { return B.value; }
+
+int use() {
+  Box<int> B = {1};
+  return get(B);
+}
+
+// TRACE: {"traceEvents": [
+// TRACE-DAG: {"name": "Box<int>", "cat": "instantiate", "ph": "X", {{.*}}"args": {"template": "Box", "location": "{{.*}}template-profile.cpp:{{[0-9]+}}:{{[0-9]+}}", "bytes": {{[0-9]+}}
+// TRACE-DAG: {"name": "get", "cat": "deduce", {{.*}}"location": "{{.*}}template-profile.cpp:12:{{[0-9]+}}"
+// TRACE-DAG: {"name": "get<int>", "cat": "instantiate", {{.*}}"args": {"template": "get",
+// TRACE: ]}
+
+// REPORT: *** Template Profile:
+// REPORT: {{[0-9]+}} instantiations and substitutions of {{[0-9]+}} templates
+// REPORT: Top {{[0-9]+}} templates by time:
+// REPORT-DAG: {{[0-9]+}}  Box
+// REPORT-DAG: {{[0-9]+}}  get
@@ -0,0 +1,10 @@
+// Check that reparsing gives the same results while the preamble is being
+// rebuilt on a background thread.
+// RUN: env CINDEXTEST_EDITING=1 CINDEXTEST_BACKGROUND_PREAMBLE=1 c-index-test -test-load-source-reparse 5 local -I %S/Inputs %s | FileCheck %s
+#include "preamble.h"
+
+int wibble(int);
+
+// CHECK: preamble.h:1:12: FunctionDecl=bar:1:12 (Definition) Extent=[1:1 - 6:2]
+// CHECK: preamble.h:4:3: BinaryOperator= Extent=[4:3 - 4:13]
+// CHECK: preamble-reparse-background.c:6:5: FunctionDecl=wibble:6:5 Extent=[6:1 - 6:16]
@@ -0,0 +1,11 @@
+// Check that reparsing gives the same results when the preamble is
+// precompiled as a chain of PCH files split at its inclusions.
+// RUN: env CINDEXTEST_EDITING=1 CINDEXTEST_CHAINED_PREAMBLE=1 c-index-test -test-load-source-reparse 5 local -I %S/Inputs %s | FileCheck %s
+#include "a.h"
+#include "b.h"
+
+A a;
+B b;
+
+// CHECK: preamble-reparse-chained-includes.c:7:3: VarDecl=a:7:3 Extent=[7:1 - 7:4]
+// CHECK: preamble-reparse-chained-includes.c:8:3: VarDecl=b:8:3 Extent=[8:1 - 8:4]
@@ -0,0 +1,25 @@
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -std=c++11 -emit-llvm -o %t.ll %s
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -std=c++11 -emit-llvm \
+// RUN:   -fthread-safe-ast-context -o %t.thread-safe.ll %s
+// RUN: diff %t.ll %t.thread-safe.ll
+
+// Making allocation and type uniquing thread-safe doesn't change the AST, so
+// the generated code is the same.
+
+template <typename T, int N> struct Array {
+  T elems[N];
+  const T &operator[](int i) const { return elems[i]; }
+};
+
+template <typename T, int N> T sum(const Array<T, N> &a) {
+  T result = T();
+  for (int i = 0; i != N; ++i)
+    result += a[i];
+  return result;
+}
+
+template <typename F> auto apply(F f) -> decltype(f(0)) { return f(0); }
+
+double use(const Array<int, 4> &a, const Array<double, 2> &b) {
+  return sum(a) + sum(b) + apply([](int x) { return x + 1.5; });
+}
@@ -0,0 +1,5 @@
+int a1(int);
+int a2(int);
+struct A { int x; };
+enum { A_Value = 1 };
+typedef struct A A_t;
@@ -0,0 +1,4 @@
+int b1(int);
+int a1(int);
+struct B { struct A *a; };
+enum { B_Value = 2 };
@@ -0,0 +1,24 @@
+// RUN: rm -rf %t
+// RUN: mkdir -p %t/X %t/Y
+// RUN: echo '#include "W.h"' > %t/X/X.h
+// RUN: echo '#if 0' >> %t/X/X.h
+// RUN: echo '#include "Y.h"' >> %t/X/X.h
+// RUN: echo '#endif' >> %t/X/X.h
+// RUN: echo 'int w = ;' > %t/X/W.h
+// RUN: echo 'module X { header "X.h" }' > %t/X/module.modulemap
+// RUN: echo 'module W { header "W.h" }' >> %t/X/module.modulemap
+// RUN: echo 'extern int y;' > %t/Y/Y.h
+// RUN: echo 'module Y { header "Y.h" } junk' > %t/Y/module.modulemap
+
+// Looking for the modules X is likely to import neither loads Y's module map,
+// whose errors would then never be reported, nor counts W as built when its
+// build fails; W is built again when it is imported, and its errors reported.
+// RUN: not %clang_cc1 -fmodules -fimplicit-module-maps \
+// RUN:                -fmodules-cache-path=%t/cache -fmodules-build-jobs=4 \
+// RUN:                -fsyntax-only %s -I %t/X -I %t/Y 2>&1 | FileCheck %s
+
+@import X;
+#include "Y.h"
+
+// CHECK-DAG: W.h:1:9: error: expected expression
+// CHECK-DAG: module.modulemap:1:27: error: expected module declaration
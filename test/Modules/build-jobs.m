@@ -0,0 +1,36 @@
+// RUN: rm -rf %t
+// RUN: mkdir %t
+// RUN: echo '#include "B.h"' > %t/A.h
+// RUN: echo '#include "C.h"' >> %t/A.h
+// RUN: echo '#include "D.h"' > %t/B.h
+// RUN: echo '#include "D.h"' > %t/C.h
+// RUN: echo 'extern int d;' > %t/D.h
+// RUN: echo 'module A { header "A.h" }' > %t/module.modulemap
+// RUN: echo 'module B { header "B.h" }' >> %t/module.modulemap
+// RUN: echo 'module C { header "C.h" }' >> %t/module.modulemap
+// RUN: echo 'module D { header "D.h" }' >> %t/module.modulemap
+
+// The modules A imports are built before A, each after the modules it
+// imports, and A's own build finds them already built.
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t/cache \
+// RUN:            -fmodules-build-jobs=4 -fsyntax-only %s -I %t -Rmodule-build \
+// RUN:            2>&1 | FileCheck %s
+
+// A warm cache builds nothing.
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t/cache \
+// RUN:            -fmodules-build-jobs=4 -fsyntax-only %s -I %t -Rmodule-build \
+// RUN:            2>&1 | FileCheck -allow-empty -check-prefix=NO-REMARKS %s
+
+@import A;
+
+int use() { return d; }
+
+// CHECK: building module 'D' as
+// CHECK: finished building module 'D'
+// CHECK-DAG: finished building module 'B'
+// CHECK-DAG: finished building module 'C'
+// CHECK: building module 'A' as
+// CHECK-NOT: building module 'D'
+// CHECK: finished building module 'A'
+
+// NO-REMARKS-NOT: building module
@@ -0,0 +1,50 @@
+// Check that updating the global module index keeps the module files that
+// were already indexed, and forgets what an updated module file no longer
+// declares.
+// RUN: rm -rf %t
+// RUN: mkdir -p %t/src
+// RUN: echo 'extern int x_value, x_old_value;' > %t/src/X.h
+// RUN: echo 'extern int y_value;' > %t/src/Y.h
+// RUN: echo 'module X { header "X.h" }' > %t/src/module.modulemap
+// RUN: echo 'module Y { header "Y.h" }' >> %t/src/module.modulemap
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fdisable-module-hash \
+// RUN:            -fmodules-cache-path=%t/cache -I %t/src -fsyntax-only \
+// RUN:            -DIMPORT_X %s
+// RUN: llvm-bcanalyzer -dump %t/cache/modules.idx | FileCheck -check-prefix=ONE %s
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fdisable-module-hash \
+// RUN:            -fmodules-cache-path=%t/cache -I %t/src -fsyntax-only \
+// RUN:            -DIMPORT_Y %s
+// RUN: llvm-bcanalyzer -dump %t/cache/modules.idx | FileCheck -check-prefix=TWO %s
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fdisable-module-hash \
+// RUN:            -fmodules-cache-path=%t/cache -I %t/src -fsyntax-only \
+// RUN:            -DIMPORT_X -DIMPORT_Y %s -verify
+// RUN: grep x_old_value %t/cache/modules.idx
+// RUN: echo 'extern int x_value, x_renamed_value;' > %t/src/X.h
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fdisable-module-hash \
+// RUN:            -fmodules-cache-path=%t/cache -I %t/src -fsyntax-only \
+// RUN:            -DIMPORT_X %s -verify
+// RUN: llvm-bcanalyzer -dump %t/cache/modules.idx | FileCheck -check-prefix=TWO %s
+// RUN: not grep x_old_value %t/cache/modules.idx
+// RUN: grep x_renamed_value %t/cache/modules.idx
+// RUN: grep y_value %t/cache/modules.idx
+
+// ONE: <MODULE
+// ONE-NOT: <MODULE
+// ONE: <IDENTIFIER_INDEX
+
+// TWO: <MODULE
+// TWO: <MODULE
+// TWO-NOT: <MODULE
+// TWO: <IDENTIFIER_INDEX
+
+// expected-no-diagnostics
+
+#ifdef IMPORT_X
+@import X;
+int *use_x = &x_value;
+#endif
+
+#ifdef IMPORT_Y
+@import Y;
+int *use_y = &y_value;
+#endif
@@ -0,0 +1,25 @@
+// RUN: rm -rf %t
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t \
+// RUN:   -I %S/Inputs/lookup-incremental -verify %s
+// RUN: %clang_cc1 -x c++ -fmodules -fimplicit-module-maps \
+// RUN:   -fmodules-cache-path=%t -I %S/Inputs/lookup-incremental -verify %s
+// expected-no-diagnostics
+
+// Names from modules imported before and after the translation unit's lookup
+// table is built are all found, along with the local ones.
+
+#include "a.h"
+
+int local1(int);
+int a2(int);
+struct Local { A_t a; };
+
+#include "b.h"
+
+int local2(int);
+int b1(int);
+
+int use(struct B *b, struct Local *l) {
+  return a1(A_Value) + a2(B_Value) + b1(b->a->x) + local1(l->a.x) +
+         local2(0);
+}
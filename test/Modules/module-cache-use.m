@@ -0,0 +1,33 @@
+// REQUIRES: shell
+// RUN: rm -rf %t
+// RUN: mkdir %t
+// RUN: echo 'extern int x;' > %t/X.h
+// RUN: echo 'int y = ;' > %t/Y.h
+// RUN: echo 'module X { header "X.h" }' > %t/module.modulemap
+// RUN: echo 'module Y { header "Y.h" }' >> %t/module.modulemap
+
+// A module that fails to build isn't counted as built.
+// RUN: not %clang_cc1 -fmodules -fimplicit-module-maps \
+// RUN:                -fmodules-cache-path=%t/cache -module-cache-stats \
+// RUN:                -fsyntax-only %s -I %t -DIMPORT_Y 2>&1 \
+// RUN:   | FileCheck -check-prefix=FAILED %s
+
+// FAILED: *** Module Cache Stats:
+// FAILED: 1 modules built, 0 identical to a stored module
+
+// With a cache size limit, the module files a compilation loaded are marked
+// as used, and marks older than a minute are refreshed.
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t/cache \
+// RUN:            -fmodules-cache-size-limit=1000 -fsyntax-only %s -I %t
+// RUN: ls %t/cache/*/X-*.pcm.used
+// RUN: touch -t 200001010000 %t/cache/*/X-*.pcm.used
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t/cache \
+// RUN:            -fmodules-cache-size-limit=1000 -fsyntax-only %s -I %t
+// RUN: find %t/cache -name 'X-*.pcm.used' -mtime -1 | grep used
+
+@import X;
+#ifdef IMPORT_Y
+@import Y;
+#endif
+
+int use() { return x; }
@@ -0,0 +1,41 @@
+// REQUIRES: shell
+// RUN: rm -rf %t
+// RUN: mkdir %t
+// RUN: echo 'extern int x;' > %t/X.h
+// RUN: echo 'module X { header "X.h" }' > %t/module.modulemap
+
+// The first build adds the module file to the content store.
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t/cache \
+// RUN:            -fmodules-share-identical -module-cache-stats -fsyntax-only \
+// RUN:            %s -I %t 2>&1 | FileCheck -check-prefix=FIRST %s
+
+// FIRST: *** Module Cache Stats:
+// FIRST-NEXT: 1 module files (
+// FIRST-NEXT: 1 module files in the content store
+// FIRST-NEXT: 1 distinct files on disk (
+// FIRST-NEXT: 1 modules built, 0 identical to a stored module
+// FIRST-NEXT: 0 module files evicted
+
+// Rebuilding it produces the same module file, which is shared with the
+// stored one.
+// RUN: find %t/cache -name 'X-*.pcm' -delete
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t/cache \
+// RUN:            -fmodules-share-identical -module-cache-stats -fsyntax-only \
+// RUN:            %s -I %t 2>&1 | FileCheck -check-prefix=SECOND %s
+
+// SECOND: *** Module Cache Stats:
+// SECOND-NEXT: 1 module files (
+// SECOND-NEXT: 1 module files in the content store
+// SECOND-NEXT: 1 distinct files on disk (
+// SECOND-NEXT: 1 modules built, 1 identical to a stored module
+
+// A warm cache builds nothing.
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t/cache \
+// RUN:            -fmodules-share-identical -module-cache-stats -fsyntax-only \
+// RUN:            %s -I %t 2>&1 | FileCheck -check-prefix=WARM %s
+
+// WARM: 0 modules built, 0 identical to a stored module
+
+@import X;
+
+int use() { return x; }
@@ -0,0 +1,28 @@
+// Builtins that the PCH never mentions must still be recognized once the PCH
+// is loaded, while builtins the PCH redeclared stay forgotten.
+
+// Test this without pch.
+// RUN: %clang_cc1 -include %s -fsyntax-only -verify %s
+
+// Test with pch.
+// RUN: %clang_cc1 -x c-header -emit-pch -o %t %s
+// RUN: %clang_cc1 -include-pch %t -fsyntax-only -verify %s
+
+#ifndef HEADER
+#define HEADER
+
+int used_in_header(int x) { return __builtin_expect(x, 0); }
+
+// Redeclaring a library builtin with a conflicting type forgets it.
+int strlen(int); // expected-warning {{incompatible redeclaration of library function 'strlen'}} expected-note {{'strlen' is a builtin}}
+
+#else
+
+int f(int x) {
+  return __builtin_popcount(x) + __builtin_abs(x) + strlen(x) +
+         __has_builtin(__builtin_clz) + __has_builtin(__builtin_expect);
+}
+
+_Static_assert(__has_builtin(__builtin_ctz), "");
+
+#endif
@@ -0,0 +1,39 @@
+// Check that declaration updates from a chained PCH are applied when the
+// updated declaration is deserialized, and that -print-stats reports how much
+// of each AST file was read.
+
+// RUN: %clang_cc1 -x c++-header -emit-pch -o %t.1.pch %s
+// RUN: %clang_cc1 -x c++-header -include-pch %t.1.pch -emit-pch -o %t.2.pch %s
+// RUN: %clang_cc1 -include-pch %t.2.pch -fsyntax-only -verify %s
+// RUN: %clang_cc1 -include-pch %t.2.pch -fsyntax-only %s -print-stats 2>&1 \
+// RUN:   | FileCheck %s
+
+// expected-no-diagnostics
+
+// CHECK: *** AST File Statistics:
+// CHECK: AST file '{{.*}}.2.pch':
+// CHECK: declaration updates read
+// CHECK: AST file '{{.*}}.1.pch':
+// CHECK: declarations read
+
+#ifndef HEADER1
+#define HEADER1
+
+template <typename T> struct Used { T x; };
+template <typename T> struct Unused { T y; };
+
+#elif !defined(HEADER2)
+#define HEADER2
+
+// Both of these add a specialization to a template from the first PCH.
+inline int useUsed() { Used<int> U; U.x = 1; return U.x; }
+inline int useUnused() { Unused<int> U; U.y = 2; return U.y; }
+
+#else
+
+int test() {
+  Used<int> U;
+  return useUsed() + U.x;
+}
+
+#endif
@@ -0,0 +1,28 @@
+// Check that lookups of identifiers that aren't in a PCH are answered by its
+// identifier filter.
+
+// RUN: %clang_cc1 -x c-header -emit-pch -o %t.pch %s
+// RUN: %clang_cc1 -include-pch %t.pch -fsyntax-only -verify %s
+// RUN: %clang_cc1 -include-pch %t.pch -fsyntax-only %s -print-stats 2>&1 \
+// RUN:   | FileCheck %s
+
+// expected-no-diagnostics
+
+// CHECK: identifier table lookups succeeded
+// CHECK: identifier table lookups rejected by filters
+
+#ifndef HEADER
+#define HEADER
+
+int in_pch;
+
+#else
+
+int use_in_pch(void) { return in_pch; }
+
+int only_in_main_file_a, only_in_main_file_b, only_in_main_file_c,
+    only_in_main_file_d, only_in_main_file_e, only_in_main_file_f,
+    only_in_main_file_g, only_in_main_file_h, only_in_main_file_i,
+    only_in_main_file_j, only_in_main_file_k, only_in_main_file_l;
+
+#endif
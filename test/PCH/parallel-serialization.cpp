@@ -0,0 +1,59 @@
+// Check that encoding declarations and types on several threads produces
+// the same AST file as encoding them serially, and that it can be used.
+
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -x c++-header -std=c++11 \
+// RUN:   -emit-pch -fno-pch-timestamp -o %t.pch %s
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -x c++-header -std=c++11 \
+// RUN:   -emit-pch -fno-pch-timestamp -fparallel-ast-serialization \
+// RUN:   -o %t.parallel.pch %s
+// RUN: diff %t.pch %t.parallel.pch
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -x c++ -std=c++11 \
+// RUN:   -include-pch %t.parallel.pch -fsyntax-only -verify %s
+
+#ifndef HEADER
+#define HEADER
+
+struct Base {
+  int B;
+  Base(int B) : B(B) {}
+  virtual ~Base() {}
+};
+
+// Enough declarations, types and statements for the records to be split
+// across several threads, including records that refer to other records
+// (base specifiers, constructor initializers, lexical and visible blocks,
+// and the repeated opaque value of a '?:').
+#define DEFINE(N)                                                              \
+  namespace ns##N {                                                            \
+  struct S##N : Base {                                                         \
+    int X, Y;                                                                  \
+    S##N(int V) : Base(V), X(V ?: N), Y(X * N) {}                              \
+    int get(int K) const {                                                     \
+      switch (K) {                                                             \
+      case 0:                                                                  \
+        return X;                                                              \
+      case 1:                                                                  \
+        return Y;                                                              \
+      default:                                                                 \
+        return (K ?: X) + B;                                                   \
+      }                                                                        \
+    }                                                                          \
+  };                                                                           \
+  template <typename T> T twice##N(T t) { return t + t + N; }                  \
+  inline int use##N() { return S##N(N).get(N % 3) + twice##N(N); }             \
+  }
+#define DEFINE4(N) DEFINE(N##0) DEFINE(N##1) DEFINE(N##2) DEFINE(N##3)
+#define DEFINE16(N) DEFINE4(N##0) DEFINE4(N##1) DEFINE4(N##2) DEFINE4(N##3)
+
+DEFINE16(1)
+DEFINE16(2)
+DEFINE16(3)
+
+#else
+
+// expected-no-diagnostics
+int f() {
+  return ns100::use100() + ns333::S333(1).get(2) + ns213::twice213(1);
+}
+
+#endif
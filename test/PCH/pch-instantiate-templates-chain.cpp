@@ -0,0 +1,20 @@
+// Check that -fpch-instantiate-templates also performs the instantiations left
+// pending by an earlier PCH in the chain.
+
+// RUN: %clang_cc1 -x c++-header -emit-pch -DFIRST -o %t.1.pch %s
+// RUN: not %clang_cc1 -x c++-header -include-pch %t.1.pch -emit-pch \
+// RUN:   -fpch-instantiate-templates -o %t.2.pch %s 2>&1 | FileCheck %s
+
+#ifdef FIRST
+
+template <typename T> int get() { return T::value; }
+inline int use() { return get<int>(); }
+
+#else
+
+int other();
+
+#endif
+
+// CHECK: error: type 'int' cannot be used prior to '::' because it has no members
+// CHECK: in instantiation of function template specialization 'get<int>' requested here
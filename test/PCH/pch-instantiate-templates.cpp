@@ -0,0 +1,43 @@
+// Check that -fpch-instantiate-templates performs the pending instantiations
+// of a PCH while building it, deterministically, and that translation units
+// using the PCH generate the same code as with a PCH that doesn't.
+
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -x c++-header -emit-pch \
+// RUN:   -fno-pch-timestamp -o %t.pch %s
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -x c++-header -emit-pch \
+// RUN:   -fno-pch-timestamp -fpch-instantiate-templates -o %t.inst.pch %s
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -x c++-header -emit-pch \
+// RUN:   -fno-pch-timestamp -fpch-instantiate-templates -o %t.inst2.pch %s
+// RUN: diff %t.inst.pch %t.inst2.pch
+// RUN: not diff %t.pch %t.inst.pch > /dev/null
+
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -include-pch %t.pch \
+// RUN:   -emit-llvm -o - %s | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-linux-gnu -include-pch %t.inst.pch \
+// RUN:   -emit-llvm -o - %s | FileCheck %s
+
+#ifndef HEADER
+#define HEADER
+
+template <typename T> T twice(T t) { return t + t; }
+
+template <typename T> struct Box {
+  T value;
+  T get() const { return twice(value); }
+};
+
+inline int useInHeader() {
+  Box<int> B = {21};
+  return B.get();
+}
+
+#else
+
+// CHECK-DAG: define i32 @_Z3usev()
+// CHECK-DAG: define linkonce_odr i32 @_Z11useInHeaderv()
+// CHECK-DAG: define linkonce_odr i32 @_ZNK3BoxIiE3getEv(
+// CHECK-DAG: define linkonce_odr i32 @_Z5twiceIiET_S0_(
+// CHECK-DAG: define linkonce_odr double @_Z5twiceIdET_S0_(
+int use() { return useInHeader() + int(twice(1.5)); }
+
+#endif
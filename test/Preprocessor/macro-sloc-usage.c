@@ -0,0 +1,29 @@
+// RUN: %clang_cc1 -E -print-stats -record-macro-sloc-usage %s -o /dev/null 2>&1 | FileCheck %s
+// RUN: %clang_cc1 -E %s | FileCheck --check-prefix=OUTPUT %s
+
+#define ONE 1
+#define PAIR(x) x, x
+#define QUAD(x) PAIR(x), PAIR(x)
+
+int a[] = { QUAD(ONE) };
+int b = ONE;
+
+// Pasted single-token arguments don't get macro argument expansions of their
+// own, only an argument that is left unpasted does.
+#define GLUE(a, b) a ## b
+#define CAT(a, b) a ## b
+
+int GLUE(c, 0);
+int CAT(c, 1), CAT(c, 2);
+int CAT(d, );
+
+// CHECK: Sloc address space used by macro expansions
+// CHECK-DAG: QUAD: 1 expansions, {{[0-9]+}} SLocEntries, {{[0-9]+}}B
+// CHECK-DAG: PAIR: 2 expansions, {{[0-9]+}} SLocEntries, {{[0-9]+}}B
+// CHECK-DAG: ONE: 2 expansions, 2 SLocEntries, {{[0-9]+}}B
+// CHECK-DAG: CAT: 3 expansions, 6 SLocEntries, {{[0-9]+}}B
+// CHECK: macro expansion SLocEntries ({{[0-9]+}}B of Sloc address space), {{[0-9]+}} macro argument expansion SLocEntries
+
+// OUTPUT: int c0;
+// OUTPUT: int c1, c2;
+// OUTPUT: int d{{ ?}};
@@ -0,0 +1,25 @@
+// RUN: %clang_cc1 -fsyntax-only -verify -fspell-checking-limit 0 -ftypo-correction-budget-ms 1 %s
+
+// Once typo correction has spent its time budget, typos are reported without
+// a correction. Correcting two thousand typos takes far longer than a
+// millisecond, so the budget is spent by the last one.
+
+#define DECL(n) int value##n; void use##n(void) { valu##n = 1; }
+#define X10(n) \
+  DECL(n##0) DECL(n##1) DECL(n##2) DECL(n##3) DECL(n##4) \
+  DECL(n##5) DECL(n##6) DECL(n##7) DECL(n##8) DECL(n##9)
+#define X100(n) \
+  X10(n##0) X10(n##1) X10(n##2) X10(n##3) X10(n##4) \
+  X10(n##5) X10(n##6) X10(n##7) X10(n##8) X10(n##9)
+#define X1000(n) \
+  X100(n##0) X100(n##1) X100(n##2) X100(n##3) X100(n##4) \
+  X100(n##5) X100(n##6) X100(n##7) X100(n##8) X100(n##9)
+
+X1000(1) // expected-error-re 1000 {{use of undeclared identifier 'valu1{{[0-9]+}}'}} expected-note-re 0+ {{'value1{{[0-9]+}}' declared here}}
+X1000(2) // expected-error-re 1000 {{use of undeclared identifier 'valu2{{[0-9]+}}'}} expected-note-re 0+ {{'value2{{[0-9]+}}' declared here}}
+
+int lastValue;
+
+void last(void) {
+  lastValu = 1; // expected-error-re {{use of undeclared identifier 'lastValu'{{$}}}}
+}
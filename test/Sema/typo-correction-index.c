@@ -0,0 +1,28 @@
+// RUN: %clang_cc1 -fsyntax-only -verify %s
+// RUN: %clang_cc1 -fsyntax-only -verify -ftypo-correction-budget-ms 0 %s
+// RUN: %clang_cc1 -fsyntax-only -verify -ftypo-correction-budget-ms 600000 %s
+
+// Unqualified typo correction finds its candidates through an index of the
+// known identifiers. Check that identifiers first seen after the index was
+// built are still found.
+
+int counter; // expected-note 2 {{'counter' declared here}}
+
+void first(void) {
+  countr = 1; // expected-error {{use of undeclared identifier 'countr'; did you mean 'counter'?}}
+}
+
+int totalValue; // expected-note {{'totalValue' declared here}}
+
+void second(void) {
+  totalVaue = 1; // expected-error {{use of undeclared identifier 'totalVaue'; did you mean 'totalValue'?}}
+}
+
+struct Point { int x, y; };
+typedef struct Point PointType; // expected-note {{'PointType' declared here}}
+
+void third(void) {
+  PointTyp p; // expected-error {{unknown type name 'PointTyp'; did you mean 'PointType'?}}
+  counterr = 2; // expected-error {{use of undeclared identifier 'counterr'; did you mean 'counter'?}}
+  unrelatedName = 3; // expected-error-re {{use of undeclared identifier 'unrelatedName'{{$}}}}
+}
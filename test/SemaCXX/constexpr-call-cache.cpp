@@ -0,0 +1,73 @@
+// RUN: %clang_cc1 -std=c++1y -fsyntax-only -verify %s
+// RUN: %clang_cc1 -std=c++1y -fsyntax-only -verify %s -fconstexpr-cache-limit 0 -DNO_CACHE
+// RUN: %clang -std=c++1y -fsyntax-only -Xclang -verify %s -fconstexpr-cache-limit=16
+// RUN: %clang_cc1 -std=c++1y -fsyntax-only -verify %s -DLIMITS -fconstexpr-steps 250 -fconstexpr-depth 12
+// RUN: %clang_cc1 -std=c++1y -fsyntax-only -verify %s -DLIMITS -fconstexpr-steps 250 -fconstexpr-depth 12 -fconstexpr-cache-limit 0
+
+// Calls to constexpr functions whose arguments are all integers or
+// floating-point numbers remember their results for the rest of the
+// translation unit.
+
+constexpr unsigned long long fib(unsigned n) {
+  return n < 2 ? n : fib(n - 1) + fib(n - 2);
+}
+
+#ifndef LIMITS
+static_assert(fib(20) == 6765, "");
+#endif
+
+// The callee may modify its parameters and locals; the result is still keyed
+// by the values it was called with.
+constexpr int sumTo(int n) {
+  int sum = 0;
+  while (n)
+    sum += n--;
+  return sum;
+}
+static_assert(sumTo(10) == 55, "");
+static_assert(sumTo(10) + sumTo(10) == 110, "");
+static_assert(sumTo(4) == 10, "");
+
+constexpr double half(double d) { return d / 2; }
+static_assert(half(3.0) == 1.5, "");
+static_assert(half(-0.0) == 0.0, "");
+
+// Calls with pointer arguments depend on the state of the evaluation, and are
+// never memoized.
+constexpr int first(const int *p) { return *p; }
+constexpr int modify() {
+  int a[2] = {1, 2};
+  int before = first(a);
+  a[0] = 10;
+  return before + first(a) + first(a + 1) - 1;
+}
+static_assert(modify() == 12, "");
+
+// A call that fails isn't remembered.
+constexpr int check(int n) {
+  return n > 0 ? n : throw 0; // expected-note 2{{subexpression not valid}}
+}
+static_assert(check(0), ""); // expected-error {{constant expression}} expected-note {{in call to 'check(0)'}}
+static_assert(check(0), ""); // expected-error {{constant expression}} expected-note {{in call to 'check(0)'}}
+static_assert(check(1), "");
+
+#ifdef LIMITS
+// A remembered call is charged the steps and the call depth it took when it
+// was evaluated, so whether an expression is accepted doesn't depend on what
+// has been evaluated before it.
+constexpr int count(int n) {
+  int r = 0;
+  for (int i = 0; i != n; ++i)
+    ++r;
+  return r;
+}
+static_assert(count(100) == 100, "");
+static_assert(count(100) + count(100) == 200, "");
+static_assert(count(100) + count(100) + count(100) == 300, ""); // expected-error {{constant expression}} expected-note {{step limit}} expected-note 0-1 {{in call to 'count(100)'}}
+
+constexpr int depth(int n) { return n ? depth(n - 1) + 1 : 0; }
+constexpr int nest(int n) { return n ? nest(n - 1) : depth(10); }
+static_assert(depth(10) == 10, "");
+static_assert(nest(0) == 10, "");
+static_assert(nest(5) == 10, ""); // expected-error {{constant expression}} expected-note {{exceeded maximum depth of 12 calls}} expected-note 0+ {{in call to}} expected-note 0-1 {{skipping}}
+#endif
@@ -0,0 +1,73 @@
+// RUN: %clang_cc1 -fsyntax-only -verify %s
+
+// Overload resolution over a large operator set, where most candidates are
+// not viable and several viable candidates must be ranked against each other.
+
+struct Stream {};
+
+#define TYPE(N) struct T##N {}; Stream &operator<<(Stream &, const T##N &);
+#define TYPES10(N) TYPE(N##0) TYPE(N##1) TYPE(N##2) TYPE(N##3) TYPE(N##4) \
+                   TYPE(N##5) TYPE(N##6) TYPE(N##7) TYPE(N##8) TYPE(N##9)
+TYPES10(1) TYPES10(2) TYPES10(3) TYPES10(4) TYPES10(5)
+TYPES10(6) TYPES10(7) TYPES10(8) TYPES10(9)
+#undef TYPES10
+#undef TYPE
+
+struct Convertible { operator int() const; };
+
+// Several viable candidates, one of which is better than all the others for
+// every argument.
+int &operator<<(Stream &, int);
+float &operator<<(Stream &, long);
+double &operator<<(Stream &, long long);
+char &operator<<(Stream &, double);
+
+void test_best(Stream &S, T55 t, Convertible c) {
+  S << t << t;
+  int &i1 = S << 0;
+  float &f1 = S << 0L;
+  double &d1 = S << 0LL;
+  char &c1 = S << 0.0;
+  int &i2 = S << 'a';
+  int &i3 = S << c;
+}
+
+// A better candidate found late in the set is still checked against the
+// earlier candidates.
+struct Base {};
+struct Derived : Base {};
+struct MoreDerived : Derived {};
+int &operator<<(Stream &, const Base &);
+float &operator<<(Stream &, const Derived &);
+double &operator<<(Stream &, const MoreDerived &);
+
+void test_derived(Stream &S, Base b, Derived d, MoreDerived md) {
+  int &i = S << b;
+  float &f = S << d;
+  double &r = S << md;
+}
+
+// The candidates are compared argument by argument in both directions.
+struct A {};
+struct B {};
+void pair(A, int, long); // expected-note {{candidate function}}
+void pair(A, long, int); // expected-note {{candidate function}}
+void pair(B, int, int);
+void pair(A, double, double); // expected-note {{candidate function}}
+
+void test_ambiguous() {
+  pair(A(), 0, 0); // expected-error {{call to 'pair' is ambiguous}}
+  pair(A(), 0, 0L);
+  pair(A(), 0.0, 0.0);
+  pair(B(), 0, 0);
+}
+
+// An ambiguity between two candidates that are both worse than another one
+// doesn't make the call ambiguous.
+void triple(int, long, long);
+void triple(long, int, long);
+void triple(int, int, int);
+
+void test_dominated() {
+  triple(0, 0, 0);
+}
@@ -0,0 +1,53 @@
+// RUN: %clang_cc1 -std=c++11 -fsyntax-only -verify %s
+
+// Deductions from calls with the same argument types are remembered; make
+// sure that doesn't change which calls are accepted.
+
+namespace adl {
+  namespace N { struct X {}; }
+  template <typename T> auto f(T t) -> decltype(g(t)); // expected-note 2{{substitution failure}}
+
+  void test1() {
+    f(N::X()); // expected-error {{no matching function}}
+    f(N::X()); // expected-error {{no matching function}}
+  }
+
+  // A later declaration can make substitution succeed.
+  namespace N { int g(X); }
+  void test2() { f(N::X()); }
+}
+
+namespace incomplete {
+  struct Inc;
+  template <typename T> char (*size(T *))[sizeof(T)]; // expected-note {{substitution failure}}
+
+  void test1(Inc *p) { size(p); } // expected-error {{no matching function}}
+
+  // So can completing a type.
+  struct Inc {};
+  void test2(Inc *p) { size(p); }
+}
+
+namespace value_kind {
+  template <typename T> struct is_lref { static const bool value = false; };
+  template <typename T> struct is_lref<T &> { static const bool value = true; };
+  template <typename T> constexpr bool fwd(T &&) { return is_lref<T>::value; }
+
+  int i;
+  static_assert(fwd(i), "");
+  static_assert(!fwd(0), "");
+  static_assert(fwd(i), "");
+}
+
+namespace non_dependent_conversion {
+  // The conversion for the second parameter depends on the argument
+  // expression, not only its type.
+  template <typename T> int conv(T, int *); // expected-note {{no known conversion from 'int' to 'int *' for 2nd argument}}
+
+  int *p;
+  void test() {
+    conv(1, p);
+    conv(1, 0);
+    conv(1, 1); // expected-error {{no matching function}}
+  }
+}
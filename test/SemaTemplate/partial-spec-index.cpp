@@ -0,0 +1,90 @@
+// RUN: %clang_cc1 -std=c++11 -fsyntax-only -verify %s
+
+// Partial specializations are only tried when the outermost forms of their
+// template arguments could match; check that selecting among many of them
+// still finds the same ones.
+
+template<int N> struct Int { static const int value = N; };
+template<typename...> struct List {};
+template<typename T, typename U> struct Pair {};
+struct Class {};
+enum Enum { E };
+
+template<typename T, typename U = void> struct Classify : Int<0> {};
+template<typename T> struct Classify<T *> : Int<1> {};
+template<typename T> struct Classify<T &> : Int<2> {};
+template<typename T> struct Classify<T &&> : Int<3> {};
+template<typename T, typename C> struct Classify<T C::*> : Int<4> {};
+template<typename T> struct Classify<T[]> : Int<5> {};
+template<typename T, int N> struct Classify<T[N]> : Int<6> {};
+template<typename R, typename ...A> struct Classify<R(A...)> : Int<7> {};
+template<typename ...T> struct Classify<List<T...> > : Int<8> {};
+template<typename T, typename U> struct Classify<Pair<T, U> > : Int<9> {};
+template<template<typename...> class TT, typename T>
+struct Classify<TT<T>, int> : Int<10> {};
+template<> struct Classify<int> : Int<11> {};
+template<typename T> struct Classify<const T> : Int<12> {};
+template<typename T> struct Classify<T, T> : Int<13> {};
+template<typename T> struct Classify<T *, int> : Int<14> {};
+template<typename T> struct Classify<Class, T *> : Int<15> {};
+template<typename T> struct Classify<T *, const T *> : Int<16> {};
+template<typename T> struct Classify<T *, T *> : Int<17> {};
+
+static_assert(Classify<char>::value == 0, "");
+static_assert(Classify<int>::value == 11, "");
+static_assert(Classify<int *>::value == 1, "");
+static_assert(Classify<int &>::value == 2, "");
+static_assert(Classify<int &&>::value == 3, "");
+static_assert(Classify<int Class::*>::value == 4, "");
+static_assert(Classify<int[]>::value == 5, "");
+static_assert(Classify<int[3]>::value == 6, "");
+static_assert(Classify<int(char, long)>::value == 7, "");
+static_assert(Classify<List<int, char> >::value == 8, "");
+static_assert(Classify<Pair<int, char> >::value == 9, "");
+static_assert(Classify<List<int>, int>::value == 10, "");
+static_assert(Classify<Pair<int, int>, int>::value == 0, "");
+static_assert(Classify<const int>::value == 12, "");
+static_assert(Classify<const int *>::value == 1, "");
+static_assert(Classify<Enum, Enum>::value == 13, "");
+static_assert(Classify<Class, Class>::value == 13, "");
+static_assert(Classify<long *, int>::value == 14, "");
+static_assert(Classify<Class, int *>::value == 15, "");
+static_assert(Classify<Class, int>::value == 0, "");
+static_assert(Classify<int *, const int *>::value == 16, "");
+static_assert(Classify<int *, int *>::value == 17, "");
+static_assert(Classify<int *, long *>::value == 0, "");
+
+// Partial specializations declared after the index was first used are still
+// found.
+template<typename T> struct Classify<T *, Class> : Int<18> {};
+static_assert(Classify<int *, Class>::value == 18, "");
+template<typename T> struct Classify<T *, Enum> : Int<19> {};
+static_assert(Classify<int *, Enum>::value == 19, "");
+
+// Ambiguities between the plausible partial specializations are still
+// diagnosed.
+template<typename T, typename U> struct Ambiguous {};
+template<typename T> struct Ambiguous<T, int> {}; // expected-note {{partial specialization matches}}
+template<typename T> struct Ambiguous<int, T> {}; // expected-note {{partial specialization matches}}
+template<typename T> struct Ambiguous<T *, T> {};
+Ambiguous<int, int> ambiguous; // expected-error {{ambiguous partial specializations}}
+Ambiguous<char *, char> not_ambiguous_1;
+Ambiguous<int *, char> not_ambiguous_2;
+
+// A type-list metafunction with many partial specializations.
+template<unsigned N, typename L> struct At;
+template<typename T, typename ...Ts> struct At<0, List<T, Ts...> > {
+  typedef T type;
+};
+template<unsigned N, typename T, typename ...Ts>
+struct At<N, List<T, Ts...> > {
+  typedef typename At<N - 1, List<Ts...> >::type type;
+};
+
+template<typename T> struct Same { static const bool value = false; };
+template<typename T> struct Same<Pair<T, T> > { static const bool value = true; };
+
+typedef List<char, short, int, long, long long, float, double> Types;
+static_assert(Same<Pair<At<0, Types>::type, char> >::value, "");
+static_assert(Same<Pair<At<3, Types>::type, long> >::value, "");
+static_assert(Same<Pair<At<6, Types>::type, double> >::value, "");
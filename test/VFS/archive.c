@@ -0,0 +1,10 @@
+// RUN: rm -rf %t && mkdir -p %t/sdk/include/sys
+// RUN: echo 'int archived(void);' > %t/sdk/include/archived.h
+// RUN: echo '#include <archived.h>' > %t/sdk/include/sys/nested.h
+// RUN: clang-vfs-pack %t/sdk -root %t/sysroot -o %t/sdk.vfsarchive
+// RUN: %clang_cc1 -Werror -isystem %t/sysroot/include -ivfsoverlay %t/sdk.vfsarchive -fsyntax-only %s
+// REQUIRES: shell
+
+#include <sys/nested.h>
+
+int use(void) { return archived(); }
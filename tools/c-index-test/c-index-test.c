@@ -82,6 +82,10 @@ static unsigned getDefaultParsingOptions() {
     options |= CXTranslationUnit_CreatePreambleOnFirstParse;
   if (getenv("CINDEXTEST_KEEP_GOING"))
     options |= CXTranslationUnit_KeepGoing;
+  if (getenv("CINDEXTEST_BACKGROUND_PREAMBLE"))
+    options |= CXTranslationUnit_BackgroundPreamble;
+  if (getenv("CINDEXTEST_CHAINED_PREAMBLE"))
+    options |= CXTranslationUnit_ChainedPreamble;
 
   return options;
 }
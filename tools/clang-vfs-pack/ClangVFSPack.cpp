@@ -0,0 +1,112 @@
+//===-- clang-vfs-pack/ClangVFSPack.cpp -----------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief This file implements clang-vfs-pack, which packs a directory tree
+/// (typically a sysroot or SDK) into a single archive that clang can mount
+/// with -ivfsoverlay in place of the directory.
+///
+//===----------------------------------------------------------------------===//
+
+#include "clang/Basic/VirtualFileSystem.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/raw_ostream.h"
+#include <system_error>
+
+using namespace llvm;
+
+static cl::OptionCategory ClangVFSPackCategory("clang-vfs-pack options");
+
+static cl::opt<std::string> InputDirectory(cl::Positional, cl::Required,
+                                           cl::desc("<input directory>"),
+                                           cl::cat(ClangVFSPackCategory));
+
+static cl::opt<std::string> OutputFilename("o", cl::Required,
+                                           cl::desc("Output archive"),
+                                           cl::value_desc("filename"),
+                                           cl::cat(ClangVFSPackCategory));
+
+static cl::opt<std::string>
+    VirtualRoot("root",
+                cl::desc("Absolute path at which the input directory appears "
+                         "in the archive (defaults to its real path)"),
+                cl::value_desc("path"), cl::cat(ClangVFSPackCategory));
+
+int main(int argc, const char **argv) {
+  sys::PrintStackTraceOnErrorSignal(argv[0]);
+
+  cl::HideUnrelatedOptions(ClangVFSPackCategory);
+  cl::ParseCommandLineOptions(
+      argc, argv,
+      "A tool to pack a directory tree into a single archive that clang can\n"
+      "use as a read-only virtual file system via -ivfsoverlay.\n");
+
+  SmallString<256> Input(InputDirectory);
+  if (std::error_code EC = sys::fs::make_absolute(Input)) {
+    errs() << "error: " << InputDirectory << ": " << EC.message() << "\n";
+    return 1;
+  }
+  sys::path::remove_dots(Input, /*remove_dot_dot=*/true);
+
+  SmallString<256> Root(VirtualRoot.empty() ? Input.str()
+                                            : StringRef(VirtualRoot));
+  if (!sys::path::is_absolute(Root)) {
+    errs() << "error: -root must be an absolute path\n";
+    return 1;
+  }
+
+  clang::vfs::ArchiveVFSWriter Writer;
+  std::error_code EC;
+  for (sys::fs::recursive_directory_iterator I(Input, EC), E; I != E;
+       I.increment(EC)) {
+    if (EC)
+      break;
+    StringRef Path = I->path();
+    sys::fs::file_status Status;
+    if (sys::fs::status(Path, Status) || !sys::fs::is_regular_file(Status))
+      continue;
+
+    ErrorOr<std::unique_ptr<MemoryBuffer>> Buffer =
+        MemoryBuffer::getFile(Path, /*FileSize=*/-1,
+                              /*RequiresNullTerminator=*/false);
+    if (!Buffer) {
+      errs() << "error: " << Path << ": " << Buffer.getError().message()
+             << "\n";
+      return 1;
+    }
+
+    SmallString<256> VirtualPath(Root);
+    sys::path::append(VirtualPath, Path.substr(Input.size()));
+    Writer.addFile(VirtualPath, std::move(*Buffer),
+                   Status.getLastModificationTime());
+  }
+  if (EC) {
+    errs() << "error: " << InputDirectory << ": " << EC.message() << "\n";
+    return 1;
+  }
+
+  raw_fd_ostream OS(OutputFilename, EC, sys::fs::F_None);
+  if (EC) {
+    errs() << "error: " << OutputFilename << ": " << EC.message() << "\n";
+    return 1;
+  }
+  Writer.write(OS);
+  OS.close();
+  if (OS.has_error()) {
+    errs() << "error: failed to write " << OutputFilename << "\n";
+    OS.clear_error();
+    return 1;
+  }
+  return 0;
+}
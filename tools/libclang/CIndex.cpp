@@ -3420,6 +3420,11 @@ clang_parseTranslationUnit_Impl(CXIndex CIdx, const char *source_filename,
   if (isASTReadError(Unit ? Unit.get() : ErrUnit.get()))
     return CXError_ASTReadError;
 
+  if (Unit && (options & CXTranslationUnit_BackgroundPreamble))
+    Unit->setBuildPreambleInBackground(true);
+  if (Unit && (options & CXTranslationUnit_ChainedPreamble))
+    Unit->setChainPreambleAtIncludes(true);
+
   *out_TU = MakeCXTranslationUnit(CXXIdx, std::move(Unit));
   return *out_TU ? CXError_Success : CXError_Failure;
 }
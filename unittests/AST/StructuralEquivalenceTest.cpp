@@ -0,0 +1,89 @@
+//===- unittest/AST/StructuralEquivalenceTest.cpp -------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Tests for the structural equivalence checks used by the AST importer.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/ASTStructuralEquivalence.h"
+#include "clang/AST/Decl.h"
+#include "clang/AST/DeclCXX.h"
+#include "clang/Frontend/ASTUnit.h"
+#include "clang/Tooling/Tooling.h"
+#include "gtest/gtest.h"
+
+namespace clang {
+namespace {
+
+typedef llvm::DenseSet<std::pair<Decl *, Decl *>> DeclPairSet;
+
+class StructuralEquivalenceTest : public ::testing::Test {
+protected:
+  std::unique_ptr<ASTUnit> FromAST, ToAST;
+  DeclPairSet NonEquivalentDecls, EquivalentDecls;
+
+  void buildASTs(StringRef FromCode, StringRef ToCode) {
+    FromAST = tooling::buildASTFromCode(FromCode, "input.cc");
+    ToAST = tooling::buildASTFromCode(ToCode, "output.cc");
+    ASSERT_TRUE(FromAST && ToAST);
+  }
+
+  static RecordDecl *findRecord(ASTUnit &AST, StringRef Name) {
+    ASTContext &Ctx = AST.getASTContext();
+    for (NamedDecl *ND : Ctx.getTranslationUnitDecl()->lookup(
+             DeclarationName(&Ctx.Idents.get(Name))))
+      if (RecordDecl *RD = dyn_cast<RecordDecl>(ND))
+        return RD;
+    return nullptr;
+  }
+
+  /// \brief Check the records named \p Name for equivalence the way the
+  /// importer does, remembering equivalences across checks.
+  bool isEquivalent(StringRef Name) {
+    StructuralEquivalenceContext Ctx(
+        FromAST->getASTContext(), ToAST->getASTContext(), NonEquivalentDecls,
+        /*StrictTypeSpelling=*/false, /*Complain=*/false, &EquivalentDecls);
+    return Ctx.IsStructurallyEquivalent(findRecord(*FromAST, Name),
+                                        findRecord(*ToAST, Name));
+  }
+};
+
+TEST_F(StructuralEquivalenceTest, RemembersCompleteRecords) {
+  buildASTs("struct S { int x; }; struct T { S *s; };",
+            "struct S { int x; }; struct T { S *s; };");
+  EXPECT_TRUE(isEquivalent("T"));
+  EXPECT_FALSE(EquivalentDecls.empty());
+  EXPECT_TRUE(isEquivalent("T"));
+}
+
+TEST_F(StructuralEquivalenceTest, DoesNotRememberIncompleteRecords) {
+  buildASTs("struct S { int x; }; struct T { S *s; };",
+            "struct S; struct T { S *s; };");
+  EXPECT_TRUE(isEquivalent("T"));
+  EXPECT_TRUE(EquivalentDecls.empty());
+
+  // Give the forward-declared record a definition that doesn't match.
+  ASTContext &ToCtx = ToAST->getASTContext();
+  RecordDecl *S = findRecord(*ToAST, "S");
+  S->startDefinition();
+  FieldDecl *X = FieldDecl::Create(
+      ToCtx, S, SourceLocation(), SourceLocation(), &ToCtx.Idents.get("x"),
+      ToCtx.FloatTy, ToCtx.getTrivialTypeSourceInfo(ToCtx.FloatTy),
+      /*BW=*/nullptr, /*Mutable=*/false, ICIS_NoInit);
+  X->setAccess(AS_public);
+  S->addDecl(X);
+  S->completeDefinition();
+
+  EXPECT_FALSE(isEquivalent("S"));
+  EXPECT_FALSE(isEquivalent("T"));
+}
+
+} // end anonymous namespace
+} // end namespace clang
@@ -0,0 +1,72 @@
+//===- unittests/AST/ThreadSafeASTContextTest.cpp - Thread-safe ASTContext ===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Tests that types can be created from several threads at once when
+// -fthread-safe-ast-context is given.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/AST/ASTContext.h"
+#include "clang/Frontend/ASTUnit.h"
+#include "clang/Tooling/Tooling.h"
+#include "llvm/Config/llvm-config.h"
+#include "gtest/gtest.h"
+#include <thread>
+#include <vector>
+
+using namespace clang;
+
+namespace {
+
+/// \brief Create a handful of types, most of them new, that depend on \p N.
+QualType buildType(ASTContext &Ctx, unsigned N) {
+  QualType Array = Ctx.getConstantArrayType(
+      Ctx.IntTy, llvm::APInt(32, N + 1), ArrayType::Normal, 0);
+  QualType Ptr = Ctx.getPointerType(Array);
+  QualType Params[] = {Ctx.getLValueReferenceType(Ptr),
+                       Ctx.getPointerType(Ctx.getConstType(Ptr)),
+                       Ctx.getVectorType(Ctx.IntTy, 1U << (N % 6),
+                                         VectorType::GenericVector)};
+  return Ctx.getFunctionType(Ptr, Params, FunctionProtoType::ExtProtoInfo());
+}
+
+#if LLVM_ENABLE_THREADS
+TEST(ThreadSafeASTContextTest, TypesAreUniquedAcrossThreads) {
+  std::unique_ptr<ASTUnit> AST = tooling::buildASTFromCodeWithArgs(
+      "int x;", {"-Xclang", "-fthread-safe-ast-context"});
+  ASSERT_TRUE(AST);
+  ASTContext &Ctx = AST->getASTContext();
+  ASSERT_TRUE(Ctx.getLangOpts().ThreadSafeASTContext);
+
+  // Each thread creates the same types, starting at a different one, so that
+  // the threads race to create most of them.
+  const unsigned NumThreads = 8, NumTypes = 256;
+  std::vector<std::vector<QualType>> Results(
+      NumThreads, std::vector<QualType>(NumTypes));
+  std::vector<std::thread> Threads;
+  for (unsigned T = 0; T != NumThreads; ++T)
+    Threads.emplace_back([&, T] {
+      for (unsigned I = 0; I != NumTypes; ++I) {
+        unsigned N = (I + T * NumTypes / NumThreads) % NumTypes;
+        Results[T][N] = buildType(Ctx, N);
+      }
+    });
+  for (std::thread &Thread : Threads)
+    Thread.join();
+
+  // Whichever thread created a type, every thread got that one.
+  for (unsigned N = 0; N != NumTypes; ++N) {
+    QualType Expected = buildType(Ctx, N);
+    for (unsigned T = 0; T != NumThreads; ++T)
+      EXPECT_EQ(Expected, Results[T][N]);
+  }
+}
+#endif
+
+} // end anonymous namespace
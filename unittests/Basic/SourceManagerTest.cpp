@@ -173,6 +173,41 @@ TEST_F(SourceManagerTest, getColumnNumber) {
   EXPECT_EQ(1U, SourceMgr.getColumnNumber(MainFileID, 0, nullptr));
 }
 
+TEST_F(SourceManagerTest, getFileIDManyEntries) {
+  // Interleave files and macro expansions so that lookups exercise the
+  // lookup cache, the interval index and the search past the indexed prefix.
+  std::vector<std::pair<SourceLocation, FileID>> Expected;
+  for (unsigned I = 0; I != 1000; ++I) {
+    std::unique_ptr<llvm::MemoryBuffer> Buf =
+        llvm::MemoryBuffer::getMemBuffer("int x;\n");
+    FileID FID = SourceMgr.createFileID(std::move(Buf));
+    SourceLocation Start = SourceMgr.getLocForStartOfFile(FID);
+    Expected.push_back(std::make_pair(Start.getLocWithOffset(4), FID));
+
+    if (I % 3 == 0) {
+      SourceLocation Expansion =
+          SourceMgr.createExpansionLoc(Start, Start, Start, 3);
+      Expected.push_back(std::make_pair(Expansion.getLocWithOffset(1),
+                                        SourceMgr.getFileID(Expansion)));
+    }
+  }
+
+  // Visit the locations in a scattered order, twice, so that both the
+  // first lookup and the cached lookup are checked.
+  for (unsigned Round = 0; Round != 2; ++Round) {
+    for (unsigned I = 0, N = Expected.size(); I != N; ++I) {
+      const auto &Entry = Expected[(I * 7919) % N];
+      EXPECT_EQ(Entry.second, SourceMgr.getFileID(Entry.first));
+    }
+  }
+
+  for (unsigned I = 0, N = Expected.size(); I != N; ++I) {
+    const auto &Entry = Expected[(I * 7919) % N];
+    if (Entry.first.isFileID())
+      EXPECT_EQ(4U, SourceMgr.getDecomposedLoc(Entry.first).second);
+  }
+}
+
 #if defined(LLVM_ON_UNIX)
 
 TEST_F(SourceManagerTest, getMacroArgExpandedLocation) {
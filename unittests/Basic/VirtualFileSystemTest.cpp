@@ -12,6 +12,7 @@
 #include "llvm/Support/Errc.h"
 #include "llvm/Support/Host.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
 #include "llvm/Support/SourceMgr.h"
 #include "gtest/gtest.h"
 #include <map>
@@ -758,6 +759,172 @@ TEST_F(InMemoryFileSystemTest, WorkingDirectory) {
                       NormalizedFS.getCurrentWorkingDirectory().get()));
 }
 
+static IntrusiveRefCntPtr<vfs::FileSystem>
+writeAndReadArchive(vfs::ArchiveVFSWriter &Writer, std::string &Archive) {
+  {
+    raw_string_ostream OS(Archive);
+    Writer.write(OS);
+  }
+  return vfs::getVFSFromArchive(MemoryBuffer::getMemBuffer(
+      Archive, "archive", /*RequiresNullTerminator=*/false));
+}
+
+// Like the tests below, these use '//root/' as the root directory, since it is
+// a legal *absolute* path on Windows as well as *nix.
+TEST(ArchiveFileSystemTest, StatusAndContents) {
+  vfs::ArchiveVFSWriter Writer;
+  Writer.addFile("//root/sysroot/usr/include/a.h",
+                 MemoryBuffer::getMemBufferCopy("int a;\n"));
+  Writer.addFile("//root/sysroot/usr/include/sys/b.h",
+                 MemoryBuffer::getMemBufferCopy("int b;\n"));
+  Writer.addFile("//root/sysroot/empty.h", MemoryBuffer::getMemBufferCopy(""));
+
+  std::string Archive;
+  IntrusiveRefCntPtr<vfs::FileSystem> FS = writeAndReadArchive(Writer, Archive);
+  ASSERT_TRUE(FS.get() != nullptr);
+  EXPECT_EQ(0U, Archive.size() % 4096);
+
+  auto Stat = FS->status("//root/sysroot/usr/include");
+  ASSERT_FALSE(Stat.getError());
+  EXPECT_TRUE(Stat->isDirectory());
+  Stat = FS->status("//root/sysroot/usr/include/a.h");
+  ASSERT_FALSE(Stat.getError());
+  EXPECT_TRUE(Stat->isRegularFile());
+  EXPECT_EQ(7U, Stat->getSize());
+  EXPECT_TRUE(
+      Stat->equivalent(*FS->status("//root/sysroot/usr/../usr/include/a.h")));
+  EXPECT_EQ(errc::no_such_file_or_directory,
+            FS->status("//root/sysroot/usr/include/c.h").getError());
+
+  auto File = FS->openFileForRead("//root/sysroot/usr/include/sys/b.h");
+  ASSERT_FALSE(File.getError());
+  auto Buf = (*File)->getBuffer("b.h");
+  ASSERT_FALSE(Buf.getError());
+  EXPECT_EQ("int b;\n", (*Buf)->getBuffer());
+  EXPECT_EQ('\0', *(*Buf)->getBufferEnd());
+  // The buffer points into the archive rather than holding a copy.
+  EXPECT_TRUE((*Buf)->getBufferStart() >= Archive.data() &&
+              (*Buf)->getBufferEnd() < Archive.data() + Archive.size());
+
+  File = FS->openFileForRead("//root/sysroot/empty.h");
+  ASSERT_FALSE(File.getError());
+  EXPECT_EQ("", (*(*File)->getBuffer("empty.h"))->getBuffer());
+
+  File = FS->openFileForRead("//root/sysroot/usr");
+  EXPECT_EQ(errc::invalid_argument, File.getError());
+
+  ASSERT_FALSE(FS->setCurrentWorkingDirectory("//root/sysroot/usr"));
+  EXPECT_TRUE(FS->exists("include/a.h"));
+}
+
+TEST(ArchiveFileSystemTest, DirectoryIteration) {
+  vfs::ArchiveVFSWriter Writer;
+  Writer.addFile("//root/a/b", MemoryBuffer::getMemBufferCopy("b"));
+  Writer.addFile("//root/a/c/d", MemoryBuffer::getMemBufferCopy("d"));
+  Writer.addFile("//root/a.h", MemoryBuffer::getMemBufferCopy("a"));
+
+  std::string Archive;
+  IntrusiveRefCntPtr<vfs::FileSystem> FS = writeAndReadArchive(Writer, Archive);
+  ASSERT_TRUE(FS.get() != nullptr);
+
+  std::error_code EC;
+  std::vector<std::string> Names;
+  for (vfs::directory_iterator I = FS->dir_begin("//root/a", EC), E;
+       !EC && I != E; I.increment(EC))
+    Names.push_back(I->getName());
+  ASSERT_FALSE(EC);
+  ASSERT_EQ(2U, Names.size());
+  // The separators in the names are the platform's.
+  EXPECT_EQ("b", sys::path::filename(Names[0]));
+  EXPECT_EQ("c", sys::path::filename(Names[1]));
+
+  Names.clear();
+  for (vfs::recursive_directory_iterator I(*FS, "//root/", EC), E;
+       !EC && I != E; I.increment(EC))
+    Names.push_back(I->getName());
+  ASSERT_FALSE(EC);
+  EXPECT_EQ(5U, Names.size());
+
+  FS->dir_begin("//root/a.h", EC);
+  EXPECT_EQ(errc::not_a_directory, EC);
+}
+
+TEST(ArchiveFileSystemTest, RejectsMalformedArchive) {
+  EXPECT_TRUE(vfs::getVFSFromArchive(MemoryBuffer::getMemBuffer("")).get() ==
+              nullptr);
+  EXPECT_TRUE(vfs::getVFSFromArchive(
+                  MemoryBuffer::getMemBuffer("not an archive, but long enough "
+                                             "to hold a header"))
+                  .get() == nullptr);
+
+  vfs::ArchiveVFSWriter Writer;
+  Writer.addFile("//root/a", MemoryBuffer::getMemBufferCopy("a"));
+  std::string Archive;
+  {
+    raw_string_ostream OS(Archive);
+    Writer.write(OS);
+  }
+  // Truncate the contents of the file.
+  Archive.resize(4096);
+  EXPECT_TRUE(vfs::getVFSFromArchive(
+                  MemoryBuffer::getMemBuffer(Archive, "archive", false))
+                  .get() == nullptr);
+}
+
+TEST(SharedFileSystemCacheTest, SharesContentsBetweenFileSystems) {
+  IntrusiveRefCntPtr<vfs::InMemoryFileSystem> Base(new vfs::InMemoryFileSystem);
+  Base->addFile("/src/a.h", 0, MemoryBuffer::getMemBufferCopy("int a;\n"));
+  Base->addFile("/src/sub/b.h", 0, MemoryBuffer::getMemBufferCopy("int b;\n"));
+  IntrusiveRefCntPtr<vfs::SharedFileSystemCache> Cache(
+      new vfs::SharedFileSystemCache(Base));
+
+  IntrusiveRefCntPtr<vfs::FileSystem> FS1 =
+      vfs::createCachingFileSystem(Cache, "/src");
+  IntrusiveRefCntPtr<vfs::FileSystem> FS2 =
+      vfs::createCachingFileSystem(Cache, "/src/sub");
+
+  // Relative paths resolve against each file system's own working directory,
+  // and entries keep the name they were asked for.
+  auto Stat = FS1->status("a.h");
+  ASSERT_FALSE(Stat.getError());
+  EXPECT_EQ("a.h", Stat->getName());
+  EXPECT_EQ(7U, Stat->getSize());
+  EXPECT_EQ(errc::no_such_file_or_directory, FS2->status("a.h").getError());
+  EXPECT_TRUE(FS2->status("../a.h")->equivalent(*Stat));
+
+  auto File1 = FS1->openFileForRead("/src/a.h");
+  ASSERT_FALSE(File1.getError());
+  auto File2 = FS2->openFileForRead("../a.h");
+  ASSERT_FALSE(File2.getError());
+  auto Buf1 = (*File1)->getBuffer("a.h");
+  auto Buf2 = (*File2)->getBuffer("../a.h");
+  ASSERT_FALSE(Buf1.getError());
+  ASSERT_FALSE(Buf2.getError());
+  EXPECT_EQ("int a;\n", (*Buf1)->getBuffer());
+  EXPECT_EQ('\0', *(*Buf1)->getBufferEnd());
+  EXPECT_EQ("../a.h", (*Buf2)->getBufferIdentifier());
+  // The file was read once, and both buffers point at the same contents.
+  EXPECT_EQ((*Buf1)->getBufferStart(), (*Buf2)->getBufferStart());
+}
+
+TEST(SharedFileSystemCacheTest, WorkingDirectory) {
+  IntrusiveRefCntPtr<vfs::InMemoryFileSystem> Base(new vfs::InMemoryFileSystem);
+  Base->addFile("/src/sub/b.h", 0, MemoryBuffer::getMemBufferCopy("int b;\n"));
+  IntrusiveRefCntPtr<vfs::SharedFileSystemCache> Cache(
+      new vfs::SharedFileSystemCache(Base));
+  IntrusiveRefCntPtr<vfs::FileSystem> FS =
+      vfs::createCachingFileSystem(Cache, "/");
+
+  EXPECT_FALSE(FS->setCurrentWorkingDirectory("src"));
+  EXPECT_EQ("/src", *FS->getCurrentWorkingDirectory());
+  EXPECT_TRUE(FS->exists("sub/b.h"));
+  EXPECT_EQ(errc::not_a_directory,
+            FS->setCurrentWorkingDirectory("sub/b.h"));
+  EXPECT_EQ(errc::no_such_file_or_directory,
+            FS->setCurrentWorkingDirectory("missing"));
+  EXPECT_EQ("/src", *FS->getCurrentWorkingDirectory());
+}
+
 // NOTE: in the tests below, we use '//root/' as our root directory, since it is
 // a legal *absolute* path on Windows as well as *nix.
 class VFSFromYAMLTest : public ::testing::Test {
@@ -0,0 +1,200 @@
+//===- unittests/Frontend/PCHPreambleTest.cpp - Precompiled preamble tests ===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Basic/Diagnostic.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Frontend/ASTUnit.h"
+#include "clang/Frontend/CompilerInstance.h"
+#include "clang/Frontend/CompilerInvocation.h"
+#include "clang/Frontend/FrontendOptions.h"
+#include "clang/Frontend/PCHContainerOperations.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/Chrono.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+using namespace clang;
+
+namespace {
+
+class PCHPreambleTest : public ::testing::Test {
+  SmallString<128> TestDir;
+
+public:
+  void SetUp() override {
+    ASSERT_FALSE(sys::fs::createUniqueDirectory("preamble-test", TestDir));
+  }
+
+  void TearDown() override { sys::fs::remove_directories(TestDir); }
+
+  std::string getPath(StringRef Name) {
+    SmallString<128> Path(TestDir);
+    sys::path::append(Path, Name);
+    return Path.str();
+  }
+
+  void writeFile(StringRef Name, StringRef Contents) {
+    std::error_code EC;
+    raw_fd_ostream OS(getPath(Name), EC, sys::fs::F_None);
+    ASSERT_FALSE(EC);
+    OS << Contents;
+  }
+
+  /// \brief Give \p Name a modification time \p Seconds from now, so that
+  /// changes are visible even on file systems with coarse timestamps.
+  void setModificationTime(StringRef Name, int Seconds) {
+    int FD;
+    ASSERT_FALSE(
+        sys::fs::openFileForWrite(getPath(Name), FD, sys::fs::F_Append));
+    EXPECT_FALSE(sys::fs::setLastModificationAndAccessTime(
+        FD, std::chrono::system_clock::now() + std::chrono::seconds(Seconds)));
+    sys::Process::SafelyCloseFileDescriptor(FD);
+  }
+
+  std::unique_ptr<ASTUnit> parseAST(StringRef MainFile) {
+    auto CI = std::make_shared<CompilerInvocation>();
+    CI->getFrontendOpts().Inputs.push_back(
+        FrontendInputFile(getPath(MainFile), InputKind::CXX));
+    CI->getFrontendOpts().ProgramAction = frontend::ParseSyntaxOnly;
+    CI->getTargetOpts().Triple = "i386-unknown-linux-gnu";
+
+    IntrusiveRefCntPtr<DiagnosticsEngine> Diags(
+        CompilerInstance::createDiagnostics(new DiagnosticOptions,
+                                            new DiagnosticConsumer));
+    FileManager *FileMgr = new FileManager(FileSystemOptions());
+
+    return ASTUnit::LoadFromCompilerInvocation(
+        CI, PCHContainerOps, Diags, FileMgr, /*OnlyLocalDecls=*/false,
+        /*CaptureDiagnostics=*/true, /*PrecompilePreambleAfterNParses=*/1);
+  }
+
+  bool reparseAST(ASTUnit &AST) { return !AST.Reparse(PCHContainerOps); }
+
+  static bool hasErrors(ASTUnit &AST) {
+    for (auto D = AST.stored_diag_begin(), E = AST.stored_diag_end(); D != E;
+         ++D)
+      if (D->getLevel() >= DiagnosticsEngine::Error)
+        return true;
+    return false;
+  }
+
+  std::shared_ptr<PCHContainerOperations> PCHContainerOps =
+      std::make_shared<PCHContainerOperations>();
+};
+
+TEST_F(PCHPreambleTest, TouchedHeaderKeepsPreamble) {
+  writeFile("header.h", "int foo();\n");
+  writeFile("main.cpp", "#include \"header.h\"\nint x() { return foo(); }\n");
+
+  std::unique_ptr<ASTUnit> AST = parseAST("main.cpp");
+  ASSERT_TRUE(AST);
+  EXPECT_FALSE(hasErrors(*AST));
+  ASSERT_EQ(1U, AST->getPreambleCounterForTests());
+
+  // Only the modification time changes; the contents still match the ones
+  // the preamble was built from.
+  setModificationTime("header.h", 10);
+  ASSERT_TRUE(reparseAST(*AST));
+  EXPECT_FALSE(hasErrors(*AST));
+  EXPECT_EQ(1U, AST->getPreambleCounterForTests());
+}
+
+TEST_F(PCHPreambleTest, ChangedHeaderRebuildsPreamble) {
+  writeFile("header.h", "int foo();\n");
+  writeFile("main.cpp", "#include \"header.h\"\nint x() { return bar(); }\n");
+
+  std::unique_ptr<ASTUnit> AST = parseAST("main.cpp");
+  ASSERT_TRUE(AST);
+  EXPECT_TRUE(hasErrors(*AST));
+  ASSERT_EQ(1U, AST->getPreambleCounterForTests());
+
+  // The size stays the same, so only the contents tell the change apart.
+  writeFile("header.h", "int bar();\n");
+  setModificationTime("header.h", 10);
+  ASSERT_TRUE(reparseAST(*AST));
+  EXPECT_FALSE(hasErrors(*AST));
+  EXPECT_EQ(2U, AST->getPreambleCounterForTests());
+}
+
+TEST_F(PCHPreambleTest, GrownHeaderWhileRebuildingInBackground) {
+  writeFile("header.h", "int foo();\n");
+  writeFile("main.cpp",
+            "#include \"header.h\"\nint x() { return foo() + bar(); }\n");
+
+  std::unique_ptr<ASTUnit> AST = parseAST("main.cpp");
+  ASSERT_TRUE(AST);
+  AST->setBuildPreambleInBackground(true);
+  EXPECT_TRUE(hasErrors(*AST));
+  ASSERT_EQ(1U, AST->getPreambleCounterForTests());
+
+  // The old preamble can't be loaded once the header has grown, so this
+  // reparse must not use it while the new one is being built.
+  writeFile("header.h", "int foo();\nint bar();\n");
+  ASSERT_TRUE(reparseAST(*AST));
+  EXPECT_FALSE(hasErrors(*AST));
+}
+
+TEST_F(PCHPreambleTest, ChainedPreambleRebuildsOnlyLaterSegments) {
+  writeFile("first.h", "int foo();\n");
+  writeFile("second.h", "int bar();\n");
+  writeFile("main.cpp", "#include \"first.h\"\n#include \"second.h\"\n"
+                        "int x() { return foo() + baz(); }\n");
+
+  std::unique_ptr<ASTUnit> AST = parseAST("main.cpp");
+  ASSERT_TRUE(AST);
+  AST->setChainPreambleAtIncludes(true);
+  EXPECT_TRUE(hasErrors(*AST));
+  ASSERT_EQ(1U, AST->getPreambleCounterForTests());
+
+  // The preamble precompiled as a whole is still up to date.
+  ASSERT_TRUE(reparseAST(*AST));
+  EXPECT_TRUE(hasErrors(*AST));
+  EXPECT_EQ(1U, AST->getPreambleCounterForTests());
+  EXPECT_EQ(0U, AST->getPreambleSegmentCounterForTests());
+
+  // Once it is out of date, it is precompiled again, one segment per
+  // inclusion.
+  writeFile("second.h", "int baz();\n");
+  setModificationTime("second.h", 10);
+  ASSERT_TRUE(reparseAST(*AST));
+  EXPECT_FALSE(hasErrors(*AST));
+  EXPECT_EQ(2U, AST->getPreambleCounterForTests());
+  EXPECT_EQ(2U, AST->getPreambleSegmentCounterForTests());
+
+  // Only the segment that includes the second header is out of date.
+  writeFile("second.h", "int bar();\n");
+  setModificationTime("second.h", 20);
+  ASSERT_TRUE(reparseAST(*AST));
+  EXPECT_TRUE(hasErrors(*AST));
+  EXPECT_EQ(3U, AST->getPreambleCounterForTests());
+  EXPECT_EQ(3U, AST->getPreambleSegmentCounterForTests());
+
+  // An inclusion added to the end of the preamble is precompiled on top of
+  // the existing segments.
+  writeFile("third.h", "int baz();\n");
+  writeFile("main.cpp", "#include \"first.h\"\n#include \"second.h\"\n"
+                        "#include \"third.h\"\n"
+                        "int x() { return foo() + bar() + baz(); }\n");
+  ASSERT_TRUE(reparseAST(*AST));
+  EXPECT_FALSE(hasErrors(*AST));
+  EXPECT_EQ(4U, AST->getPreambleCounterForTests());
+  EXPECT_EQ(4U, AST->getPreambleSegmentCounterForTests());
+
+  // Nothing is precompiled when nothing has changed.
+  ASSERT_TRUE(reparseAST(*AST));
+  EXPECT_FALSE(hasErrors(*AST));
+  EXPECT_EQ(4U, AST->getPreambleCounterForTests());
+  EXPECT_EQ(4U, AST->getPreambleSegmentCounterForTests());
+}
+
+} // anonymous namespace
@@ -499,6 +499,25 @@ TEST(ClangToolTest, BuildASTs) {
   EXPECT_EQ(2u, ASTs.size());
 }
 
+TEST(ClangToolTest, RunWithThreads) {
+  FixedCompilationDatabase Compilations("/", std::vector<std::string>());
+
+  std::vector<std::string> Sources;
+  Sources.push_back("/a.cc");
+  Sources.push_back("/b.cc");
+  Sources.push_back("/c.cc");
+  ClangTool Tool(Compilations, Sources);
+
+  Tool.mapVirtualFile("/a.cc", "#include \"common.h\"\nvoid a() { common(); }");
+  Tool.mapVirtualFile("/b.cc", "#include \"common.h\"\nvoid b() { common(); }");
+  Tool.mapVirtualFile("/c.cc", "#include \"common.h\"\nvoid c() { common(); }");
+  Tool.mapVirtualFile("/common.h", "void common();");
+
+  std::unique_ptr<FrontendActionFactory> Action(
+      newFrontendActionFactory<SyntaxOnlyAction>());
+  EXPECT_EQ(0, Tool.run(Action.get(), 3));
+}
+
 struct TestDiagnosticConsumer : public DiagnosticConsumer {
   TestDiagnosticConsumer() : NumDiagnosticsSeen(0) {}
   void HandleDiagnostic(DiagnosticsEngine::Level DiagLevel,